@@ -0,0 +1,43 @@
+#ifndef SRC_BENCHMARKS_BENCH_COUNTERS_H_
+#define SRC_BENCHMARKS_BENCH_COUNTERS_H_
+
+#include <benchmark/benchmark.h>
+
+#include "./../brick_game/common/alloc_tracker.h"
+#include "./../brick_game/common/perf_counters.h"
+
+// Heap traffic and, where perf_event_open is permitted, hardware counters
+// per iteration, reported next to the timings. Create right before the
+// benchmark loop and report right after it.
+class BenchCounters {
+ public:
+  BenchCounters() {
+    readPerfCounters(&start_);
+    startAllocTracking();
+  }
+
+  void report(benchmark::State &state) {
+    AllocStats_t allocs = stopAllocTracking();
+    PerfSample_t end;
+    readPerfCounters(&end);
+
+    setPerIteration(state, "allocs", allocs.mallocs);
+    setPerIteration(state, "frees", allocs.frees);
+    setPerIteration(state, "bytes", allocs.bytes);
+    if (!start_.hardware || !end.hardware) return;
+    for (int i = 0; i < PERF_EVENTS; i++) {
+      setPerIteration(state, perfEventName(i), end.counts[i] - start_.counts[i]);
+    }
+  }
+
+ private:
+  static void setPerIteration(benchmark::State &state, const char *name,
+                              unsigned long long value) {
+    state.counters[name] = benchmark::Counter(
+        static_cast<double>(value), benchmark::Counter::kAvgIterations);
+  }
+
+  PerfSample_t start_;
+};
+
+#endif  // SRC_BENCHMARKS_BENCH_COUNTERS_H_
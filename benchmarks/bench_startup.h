@@ -0,0 +1,25 @@
+#ifndef SRC_BENCHMARKS_BENCH_STARTUP_H_
+#define SRC_BENCHMARKS_BENCH_STARTUP_H_
+
+#include <benchmark/benchmark.h>
+
+#include <thread>
+
+#include "./../brick_game/common/clock.h"
+#include "./../brick_game/common/engine.h"
+
+// Time from starting the engine thread to its first published frame, the
+// first thing a frontend can draw. Reported through manual timing, so the
+// thread shutdown stays out of the measurement.
+inline void measureFirstFrame(benchmark::State &state) {
+  Frame_t frame;
+  for (auto _ : state) {
+    unsigned long long start = monotonicNanos();
+    EngineThread_t *engine = startEngineThread(getEngineOps());
+    while (readFrame(engine, &frame) == 0) std::this_thread::yield();
+    state.SetIterationTime((double)(monotonicNanos() - start) / 1e9);
+    stopEngineThread(engine);
+  }
+}
+
+#endif  // SRC_BENCHMARKS_BENCH_STARTUP_H_
@@ -0,0 +1,217 @@
+#include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#ifdef __APPLE__
+#include <util.h>
+#else
+#include <pty.h>
+#endif
+
+#include <cstdio>
+#include <vector>
+
+#include "./../gui/cli/frontend.h"
+#include "./../gui/common/frame_image.h"
+#include "bench_counters.h"
+
+namespace {
+
+// An ncurses screen on the slave side of a pseudo-terminal sized for the
+// whole layout. Everything the renderer sends to the terminal can be read
+// back from the master side and counted.
+class HeadlessTerminal {
+ public:
+  HeadlessTerminal() {
+    struct winsize size = {};
+    size.ws_row = GAME_FIELD_H;
+    size.ws_col = CONTROLS_W + GAME_FIELD_W + GAME_INFO_W;
+    if (openpty(&master_, &slave_, nullptr, nullptr, &size) != 0) return;
+    fcntl(master_, F_SETFL, fcntl(master_, F_GETFL) | O_NONBLOCK);
+    output_ = fdopen(dup(slave_), "w");
+    input_ = fdopen(dup(slave_), "r");
+    screen_ = newterm("xterm-256color", output_, input_);
+    if (!screen_) return;
+    set_term(screen_);
+    cbreak();
+    noecho();
+    curs_set(FALSE);
+    initColors();
+    refresh();
+    drain();
+  }
+
+  ~HeadlessTerminal() {
+    if (screen_) {
+      endwin();
+      delscreen(screen_);
+    }
+    if (output_) fclose(output_);
+    if (input_) fclose(input_);
+    if (slave_ >= 0) close(slave_);
+    if (master_ >= 0) close(master_);
+  }
+
+  bool ready() const { return screen_ != nullptr; }
+
+  // Reads out whatever the terminal has received so the pty buffer never
+  // fills up and blocks the renderer, and returns its size.
+  size_t drain() {
+    char buffer[4096];
+    size_t total = 0;
+    ssize_t n;
+    while ((n = read(master_, buffer, sizeof(buffer))) > 0) total += n;
+    return total;
+  }
+
+ private:
+  int master_ = -1, slave_ = -1;
+  FILE *output_ = nullptr, *input_ = nullptr;
+  SCREEN *screen_ = nullptr;
+};
+
+// A field plus the next-piece preview in the layout GameInfo_t expects.
+class SyntheticGame {
+ public:
+  SyntheticGame() {
+    for (int i = 0; i < FIELD_H; i++) field_rows_[i] = field_[i];
+    for (int i = 0; i < 4; i++) next_rows_[i] = next_[i];
+    next_[0][1] = next_[1][0] = next_[1][1] = next_[1][2] = 1;
+    info_.field = field_rows_;
+    info_.next = next_rows_;
+    info_.high_score = 12000;
+    info_.level = 3;
+    info_.speed = INIT_SPEED - 2 * SPEED_STEP;
+  }
+
+  GameInfo_t &info() { return info_; }
+  int (&field())[FIELD_H][FIELD_W] { return field_; }
+
+  // Fills the bottom rows leaving one gap per row, like a game in progress.
+  void settle(int rows) {
+    for (int i = FIELD_H - rows; i < FIELD_H; i++)
+      for (int j = 0; j < FIELD_W; j++) field_[i][j] = j != i % FIELD_W;
+  }
+
+  // Draws or erases a T piece with its top-left corner at (y, x).
+  void piece(int y, int x, int value) {
+    field_[y][x] = field_[y][x + 1] = field_[y][x + 2] = value;
+    field_[y + 1][x + 1] = value;
+  }
+
+ private:
+  int field_[FIELD_H][FIELD_W] = {};
+  int next_[4][4] = {};
+  int *field_rows_[FIELD_H];
+  int *next_rows_[4];
+  GameInfo_t info_ = {};
+};
+
+// Renders one frame per iteration after letting step update the game, and
+// reports the terminal bytes it took next to the CPU time.
+template <typename Step>
+void measureFrames(benchmark::State &state, SyntheticGame &game, Step step) {
+  HeadlessTerminal terminal;
+  if (!terminal.ready()) {
+    state.SkipWithError("no terminal description for xterm-256color");
+    return;
+  }
+
+  renderGUI(game.info());
+  terminal.drain();
+
+  size_t bytes = 0;
+  long frame = 0;
+  BenchCounters counters;
+  for (auto _ : state) {
+    step(frame++);
+    renderGUI(game.info());
+
+    state.PauseTiming();
+    bytes += terminal.drain();
+    state.ResumeTiming();
+  }
+  counters.report(state);
+  state.counters["term_bytes"] = benchmark::Counter(
+      static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+}
+
+// The same frame over and over: only what ncurses fails to diff away.
+void BM_RenderStatic(benchmark::State &state) {
+  SyntheticGame game;
+  game.settle(6);
+  game.piece(2, 3, 1);
+  measureFrames(state, game, [](long) {});
+}
+
+// A piece moving down one row per frame over a half-filled field.
+void BM_RenderPieceFall(benchmark::State &state) {
+  SyntheticGame game;
+  game.settle(FIELD_H / 2);
+  const int rows = FIELD_H / 2 - 2;
+  measureFrames(state, game, [&game, rows](long frame) {
+    int y = frame % rows;
+    game.piece(y == 0 ? rows - 1 : y - 1, 3, 0);
+    game.piece(y, 3, 1);
+    game.info().score = frame;
+  });
+}
+
+// Four full rows alternately present and cleared, shifting the stack above
+// them, with the score changing on every clear.
+void BM_RenderLineClear(benchmark::State &state) {
+  SyntheticGame game;
+  measureFrames(state, game, [&game](long frame) {
+    auto &field = game.field();
+    for (int i = 0; i < FIELD_H; i++)
+      for (int j = 0; j < FIELD_W; j++) field[i][j] = 0;
+    if (frame % 2 == 0) {
+      game.settle(10);
+      for (int i = FIELD_H - 4; i < FIELD_H; i++)
+        for (int j = 0; j < FIELD_W; j++) field[i][j] = 1;
+    } else {
+      game.settle(6);
+      game.info().score += 1500;
+    }
+  });
+}
+
+// Every cell flips on every frame, the worst case for the terminal.
+void BM_RenderFullRedraw(benchmark::State &state) {
+  SyntheticGame game;
+  measureFrames(state, game, [&game](long frame) {
+    auto &field = game.field();
+    for (int i = 0; i < FIELD_H; i++)
+      for (int j = 0; j < FIELD_W; j++) field[i][j] = (i + j + frame) % 2;
+  });
+}
+
+// Offline rendering of a half-filled field with the next piece into an RGB
+// image of state.range(0) pixels per cell, as replay_render does per frame.
+void BM_RasterizeFrame(benchmark::State &state) {
+  const int block = state.range(0);
+  Frame_t frame = {};
+  for (int i = FIELD_H / 2; i < FIELD_H; i++)
+    for (int j = 0; j < FIELD_W; j++) frame.field[i][j] = 1 + (i + j) % 3;
+  frame.next[1][0] = frame.next[1][1] = frame.next[1][2] = frame.next[2][1] = 1;
+  int width, height;
+  frameImageSize(block, &width, &height);
+  std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 3);
+  BenchCounters counters;
+  for (auto _ : state) {
+    rasterizeFrame(&frame, block, 3, pixels.data());
+    benchmark::DoNotOptimize(pixels.data());
+  }
+  counters.report(state);
+  state.SetBytesProcessed(state.iterations() * pixels.size());
+}
+
+BENCHMARK(BM_RenderStatic);
+BENCHMARK(BM_RenderPieceFall);
+BENCHMARK(BM_RenderLineClear);
+BENCHMARK(BM_RenderFullRedraw);
+BENCHMARK(BM_RasterizeFrame)->Arg(8)->Arg(20);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,259 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "./../brick_game/common/frame_delta.h"
+#include "./../brick_game/common/rollback.h"
+#include "./../brick_game/common/spectator.h"
+#include "./../brick_game/snake/model.h"
+#include "bench_counters.h"
+#include "bench_startup.h"
+
+namespace brickgame {
+
+// Drives SnakeModel internals on a snake that follows a Hamiltonian cycle of
+// the field, so it can move forever without eating or colliding.
+class SnakeModelBench {
+ public:
+  explicit SnakeModelBench(int length) : head_(length - 1) {
+    buildCycle();
+    model_.handleInput(Start, false);
+    model_.snake_.clear();
+    for (int i = 0; i < length; ++i) model_.snake_.push_back(cycle_[head_ - i]);
+    model_.apple_x_ = -1;
+    model_.apple_y_ = -1;
+  }
+
+  SnakeModel &model() { return model_; }
+
+  void move() {
+    int next = (head_ + 1) % kCells;
+    model_.next_direction_ = directionBetween(cycle_[head_], cycle_[next]);
+    model_.move();
+    head_ = next;
+  }
+
+  bool checkCollision() const { return model_.checkCollision(); }
+
+  void generateApple() { model_.generateApple(); }
+
+  // Runs straight up into the wall from wherever the head is.
+  void crash() {
+    while (model_.getState() == SnakeFSM::State_t::MOVING) {
+      model_.next_direction_ = SnakeModel::Direction_t::UP;
+      model_.move();
+    }
+  }
+
+ private:
+  static constexpr int kCells = FIELD_H * FIELD_W;
+
+  // Up column 0, then row by row through columns 1..FIELD_W-1, back to the
+  // start. FIELD_H is even, so the last row ends next to column 0.
+  void buildCycle() {
+    for (int row = FIELD_H - 1; row >= 0; --row) cycle_.push_back({row, 0});
+    for (int row = 0; row < FIELD_H; ++row) {
+      for (int i = 1; i < FIELD_W; ++i) {
+        int col = row % 2 == 0 ? i : FIELD_W - i;
+        cycle_.push_back({row, col});
+      }
+    }
+  }
+
+  static SnakeModel::Direction_t directionBetween(std::pair<int, int> from,
+                                                  std::pair<int, int> to) {
+    if (to.first < from.first) return SnakeModel::Direction_t::UP;
+    if (to.first > from.first) return SnakeModel::Direction_t::DOWN;
+    if (to.second < from.second) return SnakeModel::Direction_t::LEFT;
+    return SnakeModel::Direction_t::RIGHT;
+  }
+
+  SnakeModel model_;
+  std::vector<std::pair<int, int>> cycle_;
+  int head_;
+};
+
+}  // namespace brickgame
+
+namespace {
+
+using brickgame::SnakeModelBench;
+
+void freeInfo(GameInfo_t *info) {
+  for (int i = 0; i < FIELD_H; ++i) delete[] info->field[i];
+  delete[] info->field;
+  for (int i = 0; i < NEXT_H; ++i) delete[] info->next[i];
+  delete[] info->next;
+}
+
+void BM_SnakeMove(benchmark::State &state) {
+  SnakeModelBench bench(state.range(0));
+  BenchCounters counters;
+  for (auto _ : state) bench.move();
+  counters.report(state);
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SnakeCheckCollision(benchmark::State &state) {
+  SnakeModelBench bench(state.range(0));
+  BenchCounters counters;
+  for (auto _ : state) benchmark::DoNotOptimize(bench.checkCollision());
+  counters.report(state);
+}
+
+void BM_SnakeGenerateApple(benchmark::State &state) {
+  SnakeModelBench bench(state.range(0));
+  BenchCounters counters;
+  for (auto _ : state) {
+    bench.generateApple();
+    benchmark::ClobberMemory();
+  }
+  counters.report(state);
+}
+
+void BM_SnakeGetGameInfo(benchmark::State &state) {
+  SnakeModelBench bench(state.range(0));
+  BenchCounters counters;
+  for (auto _ : state) {
+    GameInfo_t info = bench.model().getGameInfo();
+    benchmark::DoNotOptimize(info.field);
+    freeInfo(&info);
+  }
+  counters.report(state);
+}
+
+void BM_SnakeFirstFrame(benchmark::State &state) { measureFirstFrame(state); }
+
+// Game over to the first frame of the next game.
+void BM_SnakeRestart(benchmark::State &state) {
+  SnakeModelBench bench(4);
+  Frame_t frame;
+  BenchCounters counters;
+  for (auto _ : state) {
+    bench.crash();
+    unsigned long long start = monotonicNanos();
+    bench.model().handleInput(Start, false);
+    bench.model().fillFrame(&frame);
+    state.SetIterationTime((double)(monotonicNanos() - start) / 1e9);
+  }
+  counters.report(state);
+}
+
+// Snapshot and restore of the whole game, the unit of AI search and rollback.
+void BM_SnakeSnapshotRoundTrip(benchmark::State &state) {
+  SnakeModelBench bench(state.range(0));
+  BenchCounters counters;
+  for (auto _ : state) {
+    brickgame::SnakeModel::Snapshot snapshot = bench.model().snapshot();
+    benchmark::DoNotOptimize(snapshot);
+    bench.model().restore(snapshot);
+  }
+  counters.report(state);
+  state.counters["snapshot_bytes"] = sizeof(brickgame::SnakeModel::Snapshot);
+}
+
+// A late remote input state.range(0) ticks back, every iteration: the remote
+// board is loaded from its snapshot and run up to the present again, then the
+// session moves on a tick. The budget is a couple of milliseconds a frame.
+void BM_SnakeRollback(benchmark::State &state) {
+  const uint32_t depth = state.range(0);
+  auto session = std::make_unique<RollbackSession_t>();
+  startRollbackSession(session.get(), getEngineOps(), 0, 7, 1000);
+  const RollbackInput_t none = {-1, 0};
+  const RollbackInput_t start = {Start, 0};
+  advanceRollback(session.get(), start);
+  while (session->tick < depth) advanceRollback(session.get(), none);
+
+  // The remote player starts and then turns on every tick; none of it was
+  // predicted.
+  const UserAction_t turns[] = {Left, Up, Right, Up};
+  uint32_t resimulated = 0;
+  BenchCounters counters;
+  for (auto _ : state) {
+    uint32_t tick = session->confirmed;
+    RollbackInput_t input = {
+        static_cast<int8_t>(tick ? turns[tick % 4] : Start), 0};
+    addRemoteInput(session.get(), tick, input);
+    resimulated += reconcileRollback(session.get());
+    advanceRollback(session.get(), none);
+  }
+  counters.report(state);
+  state.counters["ticks_resimulated"] = benchmark::Counter(
+      resimulated, benchmark::Counter::kAvgIterations);
+  state.counters["snapshot_bytes"] = session->snapshot_sizes[0];
+  stopRollbackSession(session.get());
+}
+
+// A move and its spectator message, with a keyframe every
+// SPECTATOR_KEYFRAME_INTERVAL frames: stream bytes per frame against the
+// 800 bytes of the raw field.
+void BM_SnakeSpectatorStream(benchmark::State &state) {
+  SnakeModelBench bench(state.range(0));
+  SpectatorEncoder_t encoder;
+  startSpectatorEncoder(&encoder, SPECTATOR_KEYFRAME_INTERVAL);
+  Frame_t frame;
+  uint8_t message[SPECTATOR_MESSAGE_MAX];
+  uint64_t bytes = 0;
+  BenchCounters counters;
+  for (auto _ : state) {
+    bench.move();
+    bench.model().fillFrame(&frame);
+    int *field_rows[FIELD_H];
+    int *next_rows[NEXT_H];
+    bytes += encodeSpectatorFrame(
+        &encoder, frameToGameInfo(&frame, field_rows, next_rows), message);
+    benchmark::DoNotOptimize(message);
+  }
+  counters.report(state);
+  state.counters["stream_bytes"] =
+      benchmark::Counter(bytes, benchmark::Counter::kAvgIterations);
+  state.counters["raw_ratio"] =
+      bytes ? (double)sizeof(frame.field) * state.iterations() / bytes : 0;
+}
+
+// A move published to the frame versions and polled by a follower that was
+// one version behind: the delta carries three cells, the new head, the old
+// one and the tail, whatever the length of the snake.
+void BM_SnakeFrameDelta(benchmark::State &state) {
+  SnakeModelBench bench(state.range(0));
+  auto versions = std::make_unique<FrameVersions_t>();
+  initFrameVersions(versions.get());
+  auto delta = std::make_unique<FrameDelta_t>();
+  Frame_t frame;
+  unsigned long long seen = 0;
+  uint64_t cells = 0;
+  BenchCounters counters;
+  for (auto _ : state) {
+    bench.move();
+    bench.model().fillFrame(&frame);
+    updateFrameVersions(versions.get(), &frame);
+    if (readFrameVersionsDelta(versions.get(), seen, delta.get())) {
+      seen = delta->version;
+      cells += delta->count;
+    }
+  }
+  counters.report(state);
+  state.counters["changed_cells"] =
+      benchmark::Counter(cells, benchmark::Counter::kAvgIterations);
+}
+
+// Snake lengths from a fresh game up to an almost full field.
+#define SNAKE_LENGTHS Arg(4)->Arg(50)->Arg(100)->Arg(196)
+
+BENCHMARK(BM_SnakeMove)->SNAKE_LENGTHS;
+BENCHMARK(BM_SnakeCheckCollision)->SNAKE_LENGTHS;
+BENCHMARK(BM_SnakeGenerateApple)->SNAKE_LENGTHS;
+BENCHMARK(BM_SnakeGetGameInfo)->SNAKE_LENGTHS;
+BENCHMARK(BM_SnakeFirstFrame)->UseManualTime();
+BENCHMARK(BM_SnakeRestart)->UseManualTime();
+BENCHMARK(BM_SnakeSnapshotRoundTrip)->SNAKE_LENGTHS;
+BENCHMARK(BM_SnakeSpectatorStream)->SNAKE_LENGTHS;
+BENCHMARK(BM_SnakeFrameDelta)->SNAKE_LENGTHS;
+BENCHMARK(BM_SnakeRollback)->Arg(1)->Arg(8)->Arg(10)->Unit(
+    benchmark::kMicrosecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();
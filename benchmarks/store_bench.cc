@@ -0,0 +1,302 @@
+#include <benchmark/benchmark.h>
+#include <sqlite3.h>
+
+#include <cstdio>
+#include <vector>
+
+#include "./../brick_game/common/corpus.h"
+#include "./../brick_game/common/replay_archive.h"
+#include "./../brick_game/common/score_store.h"
+#include "bench_counters.h"
+
+namespace {
+
+const char *kPath = "store_bench.db";
+const char *kTable = "bench_scores";
+
+void removeFiles() {
+  std::remove(kPath);
+  std::remove("store_bench.db-wal");
+  std::remove("store_bench.db-journal");
+  std::remove("store_bench.db-shm");
+}
+
+// The engines' storage path before the score store: a rollback journal with
+// the default synchronous=FULL and a statement prepared for every call.
+class LegacyStore {
+ public:
+  LegacyStore() {
+    removeFiles();
+    sqlite3_open(kPath, &db_);
+    sqlite3_exec(db_,
+                 "CREATE TABLE IF NOT EXISTS bench_scores ("
+                 "id INTEGER PRIMARY KEY, value INTEGER NOT NULL);"
+                 "INSERT OR IGNORE INTO bench_scores (id, value) VALUES (1, 0);",
+                 0, 0, 0);
+  }
+  ~LegacyStore() {
+    sqlite3_close(db_);
+    removeFiles();
+  }
+
+  int read() {
+    sqlite3_stmt *stmt;
+    int score = 0;
+    sqlite3_prepare_v2(db_, "SELECT value FROM bench_scores WHERE id = 1;", -1,
+                       &stmt, 0);
+    if (sqlite3_step(stmt) == SQLITE_ROW) score = sqlite3_column_int(stmt, 0);
+    sqlite3_finalize(stmt);
+    return score;
+  }
+
+  void write(int score) {
+    sqlite3_stmt *stmt;
+    sqlite3_prepare_v2(db_, "UPDATE bench_scores SET value = ? WHERE id = 1;",
+                       -1, &stmt, 0);
+    sqlite3_bind_int(stmt, 1, score);
+    sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+  }
+
+ private:
+  sqlite3 *db_ = nullptr;
+};
+
+class TunedStore {
+ public:
+  TunedStore() {
+    removeFiles();
+    openScoreStore(&store_, kPath, kTable);
+  }
+  ~TunedStore() {
+    closeScoreStore(&store_);
+    removeFiles();
+  }
+  ScoreStore_t *get() { return &store_; }
+
+ private:
+  ScoreStore_t store_ = {};
+};
+
+void BM_ScoreReadLegacy(benchmark::State &state) {
+  LegacyStore store;
+  BenchCounters counters;
+  for (auto _ : state) benchmark::DoNotOptimize(store.read());
+  counters.report(state);
+  state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ScoreReadStore(benchmark::State &state) {
+  TunedStore store;
+  int score;
+  BenchCounters counters;
+  for (auto _ : state) {
+    readScore(store.get(), &score);
+    benchmark::DoNotOptimize(score);
+  }
+  counters.report(state);
+  state.SetItemsProcessed(state.iterations());
+}
+
+// What saveMaxScore() does on every apple or game over: read the record and
+// overwrite it, each statement committing on its own.
+void BM_ScorePersistLegacy(benchmark::State &state) {
+  LegacyStore store;
+  int score = 0;
+  BenchCounters counters;
+  for (auto _ : state) {
+    if (++score > store.read()) store.write(score);
+  }
+  counters.report(state);
+  state.SetItemsProcessed(state.iterations());
+}
+
+// The same read and write inside one batch, state.range(0) saves per commit.
+void BM_ScorePersistStore(benchmark::State &state) {
+  TunedStore store;
+  const int per_batch = state.range(0);
+  int score = 0, high_score;
+  BenchCounters counters;
+  for (auto _ : state) {
+    if (score % per_batch == 0) beginScoreBatch(store.get());
+    readScore(store.get(), &high_score);
+    if (++score > high_score) writeScore(store.get(), score);
+    if (score % per_batch == 0) commitScoreBatch(store.get());
+  }
+  if (score % per_batch != 0) commitScoreBatch(store.get());
+  counters.report(state);
+  state.SetItemsProcessed(state.iterations());
+}
+
+const char *kArchivePath = "archive_bench.db";
+const char *kReplayPath = "archive_bench.bin";
+
+void removeArchiveFiles() {
+  std::remove(kArchivePath);
+  std::remove("archive_bench.db-wal");
+  std::remove("archive_bench.db-shm");
+  std::remove(kReplayPath);
+}
+
+// A replay of two-byte entries claiming score; only the name of the
+// game matters to the archive.
+void writeReplay(int entries, int score) {
+  EngineOps_t ops = {};
+  ops.name = "bench";
+  ReplayRecorder_t recorder;
+  startReplayRecording(&recorder, kReplayPath, &ops, nullptr, score, 0, 0);
+  for (int i = 0; i < entries; i++)
+    recordReplayEntry(&recorder, i * 50ULL, REPLAY_ADVANCE, false);
+  Frame_t frame = {};
+  frame.score = score;
+  claimReplayResult(&recorder, &frame);
+  stopReplayRecording(&recorder);
+}
+
+// state.range(0) archived one-minute replays of about 2.4 KB each.
+class FilledArchive {
+ public:
+  explicit FilledArchive(int replays) {
+    removeArchiveFiles();
+    openReplayArchive(&archive_, kArchivePath);
+    writeReplay(1200, 0);
+    for (int i = 0; i < replays; i++) {
+      // Scores are a permutation, so the top is spread over the table.
+      writeClaim((int)((i * 7919LL) % replays));
+      archiveReplay(&archive_, kReplayPath, 1700000000LL + i * 60, nullptr);
+    }
+  }
+  ~FilledArchive() {
+    closeReplayArchive(&archive_);
+    removeArchiveFiles();
+  }
+  ReplayArchive_t *get() { return &archive_; }
+
+ private:
+  // Rewrites only the claim in the footer, keeping the same payload.
+  void writeClaim(int score) {
+    FILE *file = std::fopen(kReplayPath, "r+b");
+    ReplayFooter_t footer;
+    std::fseek(file, -(long)sizeof(footer), SEEK_END);
+    if (std::fread(&footer, sizeof(footer), 1, file) == 1) {
+      footer.claim.score = score;
+      std::fseek(file, -(long)sizeof(footer), SEEK_END);
+      std::fwrite(&footer, sizeof(footer), 1, file);
+    }
+    std::fclose(file);
+  }
+
+  ReplayArchive_t archive_ = {};
+};
+
+bool countRecord(const ReplayRecord_t *record, void *context) {
+  benchmark::DoNotOptimize(record->score);
+  ++*static_cast<int *>(context);
+  return true;
+}
+
+// Top 10 out of state.range(0) replays: an index walk, no payload read.
+void BM_ArchiveTopReplays(benchmark::State &state) {
+  FilledArchive archive(state.range(0));
+  int rows = 0;
+  BenchCounters counters;
+  for (auto _ : state)
+    topReplays(archive.get(), "bench", 10, countRecord, &rows);
+  counters.report(state);
+  state.counters["rows"] =
+      benchmark::Counter(rows, benchmark::Counter::kAvgIterations);
+  state.SetItemsProcessed(state.iterations());
+}
+
+// An hour of recordings, 60 rows, out of state.range(0).
+void BM_ArchiveDateRange(benchmark::State &state) {
+  FilledArchive archive(state.range(0));
+  const long long middle = 1700000000LL + state.range(0) * 30LL;
+  int rows = 0;
+  BenchCounters counters;
+  for (auto _ : state)
+    replaysBetween(archive.get(), "bench", middle, middle + 3599, countRecord,
+                   &rows);
+  counters.report(state);
+  state.counters["rows"] =
+      benchmark::Counter(rows, benchmark::Counter::kAvgIterations);
+  state.SetItemsProcessed(state.iterations());
+}
+
+// One ten-minute replay streamed in and back out per iteration.
+void BM_ArchiveRoundTrip(benchmark::State &state) {
+  removeArchiveFiles();
+  ReplayArchive_t archive = {};
+  openReplayArchive(&archive, kArchivePath);
+  writeReplay(12000, 1);
+  long long id = 0;
+  BenchCounters counters;
+  for (auto _ : state) {
+    archiveReplay(&archive, kReplayPath, 0, &id);
+    extractReplay(&archive, id, "archive_bench_out.bin");
+  }
+  counters.report(state);
+  FILE *file = std::fopen(kReplayPath, "rb");
+  std::fseek(file, 0, SEEK_END);
+  state.SetBytesProcessed(state.iterations() * std::ftell(file) * 2);
+  std::fclose(file);
+  closeReplayArchive(&archive);
+  std::remove("archive_bench_out.bin");
+  removeArchiveFiles();
+}
+
+const char *kCorpusPath = "corpus_bench.corpus";
+
+// 20000 one-minute sessions of 1200 entries each, a move every fourth; the
+// codes column alone is 24 MB.
+void writeCorpus() {
+  const int kSessions = 20000, kEntries = 1200;
+  std::vector<uint8_t> codes(kEntries, (REPLAY_ADVANCE + 4) << 1);
+  std::vector<uint32_t> deltas(kEntries, 50);
+  for (int i = 0; i < kEntries; i += 4) codes[i] = (Left + i / 4 % 4 + 4) << 1;
+  CorpusWriter_t writer;
+  startCorpus(&writer, kCorpusPath, "bench");
+  for (int i = 0; i < kSessions; i++) {
+    CorpusSession_t session = {};
+    session.millis = 60000;
+    session.inputs = kEntries / 4;
+    session.score = i;
+    session.level = i % 11;
+    session.pieces[i % 7] = 150;
+    addCorpusSession(&writer, &session, codes.data(), deltas.data(), kEntries);
+  }
+  finishCorpus(&writer);
+}
+
+// The whole aggregate over a mapped corpus on state.range(0) threads.
+// Bytes are the summaries and codes read, against the memory bandwidth of
+// the machine once the file is in the page cache.
+void BM_CorpusScan(benchmark::State &state) {
+  writeCorpus();
+  Corpus_t corpus;
+  openCorpus(&corpus, kCorpusPath);
+  CorpusStats_t stats;
+  BenchCounters counters;
+  for (auto _ : state) {
+    scanCorpus(&corpus, (int)state.range(0), &stats);
+    benchmark::DoNotOptimize(stats.actions[Left]);
+  }
+  counters.report(state);
+  state.SetBytesProcessed(state.iterations() * (int64_t)stats.bytes);
+  state.SetItemsProcessed(state.iterations() * (int64_t)stats.sessions);
+  closeCorpus(&corpus);
+  std::remove(kCorpusPath);
+}
+
+BENCHMARK(BM_ScoreReadLegacy)->UseRealTime();
+BENCHMARK(BM_ScoreReadStore)->UseRealTime();
+BENCHMARK(BM_ScorePersistLegacy)->UseRealTime();
+BENCHMARK(BM_ScorePersistStore)->Arg(1)->Arg(16)->UseRealTime();
+BENCHMARK(BM_ArchiveTopReplays)->Arg(1000)->Arg(20000)->UseRealTime();
+BENCHMARK(BM_ArchiveDateRange)->Arg(1000)->Arg(20000)->UseRealTime();
+BENCHMARK(BM_ArchiveRoundTrip)->UseRealTime();
+BENCHMARK(BM_CorpusScan)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,261 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+
+#include "./../brick_game/common/replay.h"
+#include "./../brick_game/tetris/backend.h"
+#include "bench_counters.h"
+#include "bench_startup.h"
+
+namespace {
+
+// Starts a game and fills the bottom fill_percent of the field with rows
+// that each miss one cell, so nothing gets cleared, plus full_rows complete
+// rows right above them. The falling block is a fixed T at the top.
+void prepareBoard(int fill_percent, int full_rows = 0) {
+  userInput(Start, false);
+  userInput((UserAction_t)-1, false);
+
+  State_t *state = getCurrentState();
+  int partial_rows = FIELD_H * fill_percent / 100;
+  for (int i = 0; i < FIELD_H; i++) {
+    int row = FIELD_H - 1 - i;
+    for (int j = 0; j < FIELD_W; j++) {
+      int filled = (i < partial_rows && j != i % FIELD_W) ||
+                   (i >= partial_rows && i < partial_rows + full_rows);
+      state->field[row][j] = filled;
+    }
+  }
+
+  for (int i = 0; i < BLOCK_MAX; i++)
+    for (int j = 0; j < BLOCK_MAX; j++) state->block[i][j] = 0;
+  state->block_size = 3;
+  state->block[0][0] = state->block[0][1] = state->block[0][2] = 1;
+  state->block[1][1] = 1;
+  state->x = 1;
+  state->y = 3;
+  state->status = Moving;
+}
+
+void BM_TetrisIsBlockAttached(benchmark::State &state) {
+  prepareBoard(state.range(0));
+  BenchCounters counters;
+  for (auto _ : state) benchmark::DoNotOptimize(isBlockAttached());
+  counters.report(state);
+}
+
+void BM_TetrisRotateBlock(benchmark::State &state) {
+  prepareBoard(state.range(0));
+  BenchCounters counters;
+  for (auto _ : state) {
+    rotateBlock();
+    benchmark::ClobberMemory();
+  }
+  counters.report(state);
+}
+
+// deleteLines() changes the field, so every iteration restores it first; the
+// copy is a few hundred bytes and stays in the measurement. The score stores
+// are suspended so a cleared line never reaches SQLite: what is measured is
+// the clear itself, not a transaction on the record table.
+void BM_TetrisDeleteLines(benchmark::State &state) {
+  closeDB();
+  suspendScoreStores(true);
+  prepareBoard(50, state.range(0));
+  State_t *game = getCurrentState();
+  int saved[FIELD_H][FIELD_W];
+  for (int i = 0; i < FIELD_H; i++)
+    for (int j = 0; j < FIELD_W; j++) saved[i][j] = game->field[i][j];
+
+  BenchCounters counters;
+  for (auto _ : state) {
+    for (int i = 0; i < FIELD_H; i++)
+      for (int j = 0; j < FIELD_W; j++) game->field[i][j] = saved[i][j];
+    game->score = 0;
+    game->level = 1;
+    game->speed = INIT_SPEED;
+    deleteLines();
+  }
+  counters.report(state);
+  suspendScoreStores(false);
+}
+
+void BM_TetrisUpdateCurrentState(benchmark::State &state) {
+  prepareBoard(state.range(0));
+  BenchCounters counters;
+  for (auto _ : state) {
+    GameInfo_t info = updateCurrentState();
+    benchmark::DoNotOptimize(info.field);
+    freeGameInfo(&info);
+  }
+  counters.report(state);
+}
+
+void BM_TetrisEmitGameEvent(benchmark::State &state) {
+  EventRing_t *ring = getEventRing();
+  BenchCounters counters;
+  for (auto _ : state) {
+    emitGameEvent(ring, EVENT_PIECE_LOCKED, T_BLOCK, 4, 10);
+  }
+  benchmark::DoNotOptimize(ring->head);
+  counters.report(state);
+}
+
+void BM_TetrisFirstFrame(benchmark::State &state) { measureFirstFrame(state); }
+
+// Game over to the first frame of the next game, with the new piece spawned.
+void BM_TetrisRestart(benchmark::State &state) {
+  Frame_t frame;
+  BenchCounters counters;
+  for (auto _ : state) {
+    userInput(Start, false);
+    while (getCurrentState()->status != GameOver) {
+      if (getCurrentState()->status == Moving) userInput(Down, false);
+      userInput((UserAction_t)-1, false);
+    }
+
+    unsigned long long start = monotonicNanos();
+    userInput(Start, false);
+    userInput((UserAction_t)-1, false);
+    fillFrame(&frame);
+    state.SetIterationTime((double)(monotonicNanos() - start) / 1e9);
+  }
+  counters.report(state);
+}
+
+// Snapshot and restore of the whole game, the unit of AI search and rollback.
+void BM_TetrisSnapshotRoundTrip(benchmark::State &state) {
+  prepareBoard(state.range(0));
+  TetrisSnapshot_t snapshot;
+  BenchCounters counters;
+  for (auto _ : state) {
+    snapshotGame(&snapshot);
+    benchmark::DoNotOptimize(snapshot);
+    restoreGame(&snapshot);
+  }
+  counters.report(state);
+  state.counters["snapshot_bytes"] = sizeof(TetrisSnapshot_t);
+}
+
+// What a rollback costs Tetris: the game loaded from a saved blob and run
+// state.range(0) ticks of 16 ms forward, a move on every fourth. Tetris keeps
+// one game per thread, so this is the board alone, without a session.
+void BM_TetrisResimulate(benchmark::State &state) {
+  closeDB();
+  unsigned long long clock = 1000;
+  setGameClock(&clock);
+  suspendScoreStores(true);
+  const EngineOps_t *ops = getEngineOps();
+  void *game = ops->create();
+  ops->seed(game, 42);
+  ops->input(game, Start, false);
+  stepGameClock(ops, game);
+  unsigned char blob[1024];
+  size_t size = ops->save(game, blob, sizeof(blob));
+
+  const UserAction_t moves[] = {Left, Action, Right, Down};
+  BenchCounters counters;
+  for (auto _ : state) {
+    clock = 1000;
+    ops->load(game, blob, size);
+    for (int tick = 0; tick < state.range(0); ++tick) {
+      clock += 16;
+      if (tick % 4 == 0) ops->input(game, moves[tick / 4 % 4], false);
+      stepGameClock(ops, game);
+    }
+  }
+  counters.report(state);
+  state.counters["snapshot_bytes"] = size;
+  ops->destroy(game);
+  suspendScoreStores(false);
+  setGameClock(NULL);
+}
+
+// A session of the given length on a virtual clock, recorded the way the
+// engine does it: a tick every 50 ms, a random move every 250 ms and a new
+// game after every game over.
+void recordSession(const char *path, int minutes, int keyframe_interval) {
+  // Earlier benchmarks leave the store open; the sessions run without one.
+  closeDB();
+  unsigned long long clock = 1000;
+  setGameClock(&clock);
+  suspendScoreStores(true);
+  const EngineOps_t *ops = getEngineOps();
+  void *game = ops->create();
+  ops->seed(game, 42);
+  ReplayRecorder_t recorder;
+  startReplayRecording(&recorder, path, ops, game, 42, clock,
+                       keyframe_interval);
+
+  auto call = [&](int action) {
+    recordReplayEntry(&recorder, clock, action, false);
+    if (action == REPLAY_ADVANCE)
+      stepGameClock(ops, game);
+    else
+      ops->input(game, (UserAction_t)action, false);
+  };
+  const UserAction_t moves[] = {Left, Right, Action, Down};
+  Rng_t rng;
+  seedRng(&rng, 7);
+  call(Start);
+  for (unsigned long long t = 50; t <= minutes * 60000ULL; t += 50) {
+    clock += 50;
+    if (getCurrentState()->status == GameOver)
+      call(Start);
+    else if (t % 250 == 0)
+      call(moves[randomBelow(&rng, 4)]);
+    call(REPLAY_ADVANCE);
+  }
+
+  stopReplayRecording(&recorder);
+  ops->destroy(game);
+  suspendScoreStores(false);
+  setGameClock(NULL);
+}
+
+// Seeks to random points of a state.range(0) minute replay with a keyframe
+// every state.range(1) entries, 0 meaning none.
+void BM_TetrisReplaySeek(benchmark::State &state) {
+  const char *path = "tetris_seek_bench.bin";
+  const int minutes = state.range(0);
+  recordSession(path, minutes, state.range(1));
+  FILE *file = fopen(path, "rb");
+  fseek(file, 0, SEEK_END);
+  state.counters["file_kb"] = ftell(file) / 1024.0;
+  fclose(file);
+
+  ReplayPlayer_t player;
+  openReplay(&player, path, getEngineOps());
+  Rng_t rng;
+  seedRng(&rng, 1);
+  unsigned long long replayed = 0;
+  BenchCounters counters;
+  for (auto _ : state)
+    replayed += seekReplay(&player, randomBelow(&rng, minutes * 60000));
+  counters.report(state);
+  state.counters["entries_replayed"] = benchmark::Counter(
+      (double)replayed, benchmark::Counter::kAvgIterations);
+  closeReplay(&player);
+  std::remove(path);
+}
+
+// Share of the field covered by settled blocks.
+#define BOARD_FILLS Arg(0)->Arg(25)->Arg(50)->Arg(75)
+
+BENCHMARK(BM_TetrisIsBlockAttached)->BOARD_FILLS;
+BENCHMARK(BM_TetrisRotateBlock)->BOARD_FILLS;
+BENCHMARK(BM_TetrisDeleteLines)->Arg(0)->Arg(1)->Arg(2)->Arg(4);
+BENCHMARK(BM_TetrisUpdateCurrentState)->BOARD_FILLS;
+BENCHMARK(BM_TetrisEmitGameEvent);
+BENCHMARK(BM_TetrisFirstFrame)->UseManualTime();
+BENCHMARK(BM_TetrisRestart)->UseManualTime();
+BENCHMARK(BM_TetrisSnapshotRoundTrip)->BOARD_FILLS;
+BENCHMARK(BM_TetrisResimulate)->Arg(1)->Arg(8)->Arg(10)->Unit(
+    benchmark::kMicrosecond);
+BENCHMARK(BM_TetrisReplaySeek)
+    ->ArgsProduct({{1, 10, 40}, {0, 256, 4096}})
+    ->Unit(benchmark::kMicrosecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();
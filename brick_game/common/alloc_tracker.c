@@ -0,0 +1,95 @@
+#include "alloc_tracker.h"
+
+#include <errno.h>
+#include <stddef.h>
+
+static _Thread_local bool tracking = false;
+static _Thread_local AllocStats_t stats = {0, 0, 0};
+
+void startAllocTracking(void) {
+  stats = (AllocStats_t){0, 0, 0};
+  tracking = true;
+}
+
+AllocStats_t stopAllocTracking(void) {
+  tracking = false;
+  return stats;
+}
+
+AllocStats_t currentAllocStats(void) { return stats; }
+
+#ifdef __GLIBC__
+
+// glibc exports its allocator under these names as well, which lets the
+// wrappers below forward to it without dlsym().
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *ptr);
+
+bool allocTrackingSupported(void) { return true; }
+
+static void countAlloc(size_t size) {
+  if (!tracking) return;
+  stats.mallocs++;
+  stats.bytes += size;
+}
+
+static void countFree(const void *ptr) {
+  if (tracking && ptr) stats.frees++;
+}
+
+void *malloc(size_t size) {
+  countAlloc(size);
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  countAlloc(count * size);
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  countFree(ptr);
+  if (size || !ptr) countAlloc(size);
+  return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size) {
+  countAlloc(size);
+  return __libc_memalign(alignment, size);
+}
+
+static bool powerOfTwo(size_t value) {
+  return value && (value & (value - 1)) == 0;
+}
+
+// __libc_memalign rounds a bad alignment up instead of failing, so the
+// checks these two functions owe their callers are made here.
+void *aligned_alloc(size_t alignment, size_t size) {
+  if (!powerOfTwo(alignment)) {
+    errno = EINVAL;
+    return NULL;
+  }
+  return memalign(alignment, size);
+}
+
+int posix_memalign(void **ptr, size_t alignment, size_t size) {
+  if (!powerOfTwo(alignment) || alignment % sizeof(void *)) return EINVAL;
+  void *memory = memalign(alignment, size);
+  if (!memory) return ENOMEM;
+  *ptr = memory;
+  return 0;
+}
+
+void free(void *ptr) {
+  countFree(ptr);
+  __libc_free(ptr);
+}
+
+#else
+
+bool allocTrackingSupported(void) { return false; }
+
+#endif
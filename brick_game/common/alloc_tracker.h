@@ -0,0 +1,33 @@
+#ifndef SRC_BRICK_GAME_COMMON_ALLOC_TRACKER_H_
+#define SRC_BRICK_GAME_COMMON_ALLOC_TRACKER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+// Opt-in heap accounting. alloc_tracker.c replaces malloc and friends, so it
+// is linked only into executables (tests, benchmarks, frontends), never into
+// the game libraries.
+// Counting is per thread and only between start and stop, which lets a test
+// measure a single engine call.
+typedef struct {
+  unsigned long long mallocs;
+  unsigned long long frees;
+  unsigned long long bytes;
+} AllocStats_t;
+
+// False where the allocator cannot be interposed (non-glibc builds); the
+// counters then stay at zero.
+bool allocTrackingSupported(void);
+
+void startAllocTracking(void);
+AllocStats_t stopAllocTracking(void);
+AllocStats_t currentAllocStats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_ALLOC_TRACKER_H_
@@ -0,0 +1,86 @@
+#include "auto_repeat.h"
+
+#include <stdlib.h>
+
+#include "clock.h"
+
+static int rateFromEnv(const char *name, int fallback) {
+  const char *value = getenv(name);
+  if (value == NULL || *value == '\0') return fallback;
+  char *end = NULL;
+  long parsed = strtol(value, &end, 10);
+  return (*end == '\0' && parsed >= 0) ? (int)parsed : fallback;
+}
+
+static unsigned actionBit(UserAction_t action) {
+  int index = (int)action;
+  return (index >= 0 && index <= (int)Action) ? 1u << index : 0u;
+}
+
+void initAutoRepeat(AutoRepeat_t *repeat) {
+  repeat->held = 0;
+  repeat->repeating = -1;
+  repeat->next_repeat = 0;
+  setAutoRepeatRates(repeat, rateFromEnv("BRICKGAME_DAS_MS", DEFAULT_DAS_MS),
+                     rateFromEnv("BRICKGAME_ARR_MS", DEFAULT_ARR_MS));
+}
+
+void setAutoRepeatRates(AutoRepeat_t *repeat, int das, int arr) {
+  repeat->das = das > 0 ? (unsigned long long)das : 0;
+  // A zero repeat rate would mean infinitely many moves per tick; one
+  // millisecond already crosses the field faster than a frame.
+  repeat->arr = arr > 1 ? (unsigned long long)arr : 1;
+}
+
+bool acceptHeldInput(AutoRepeat_t *repeat, UserAction_t action, bool hold) {
+  unsigned bit = actionBit(action);
+  if (bit == 0) return true;
+
+  if (hold) {
+    if (repeat->held & bit) return false;
+    repeat->held |= bit;
+    return true;
+  }
+
+  if (repeat->held & bit) {
+    repeat->held &= ~bit;
+    if (repeat->repeating == (int)action) repeat->repeating = -1;
+    return false;
+  }
+  return true;
+}
+
+bool isInputHeld(const AutoRepeat_t *repeat, UserAction_t action) {
+  return (repeat->held & actionBit(action)) != 0;
+}
+
+bool validAutoRepeat(const AutoRepeat_t *repeat) {
+  return repeat->arr >= 1 &&
+         (repeat->repeating == -1 ||
+          (repeat->repeating >= (int)Left && repeat->repeating <= (int)Action));
+}
+
+void releaseAllInputs(AutoRepeat_t *repeat) {
+  repeat->held = 0;
+  repeat->repeating = -1;
+}
+
+void startAutoRepeat(AutoRepeat_t *repeat, UserAction_t action,
+                     unsigned long long now) {
+  repeat->repeating = action;
+  repeat->next_repeat = now + repeat->das;
+}
+
+int dueAutoRepeats(AutoRepeat_t *repeat, unsigned long long now) {
+  if (repeat->repeating < 0 || now < repeat->next_repeat) return 0;
+
+  unsigned long long due = (now - repeat->next_repeat) / repeat->arr + 1;
+  repeat->next_repeat += due * repeat->arr;
+  return due > MAX_REPEATS_PER_TICK ? MAX_REPEATS_PER_TICK : (int)due;
+}
+
+unsigned long long autoRepeatTimeLeft(const AutoRepeat_t *repeat,
+                                      unsigned long long now) {
+  if (repeat->repeating < 0) return NO_TIMEOUT;
+  return repeat->next_repeat > now ? repeat->next_repeat - now : 0;
+}
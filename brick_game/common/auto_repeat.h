@@ -0,0 +1,56 @@
+#ifndef SRC_BRICK_GAME_COMMON_AUTO_REPEAT_H_
+#define SRC_BRICK_GAME_COMMON_AUTO_REPEAT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "./../../brick_game.h"
+
+#define DEFAULT_DAS_MS 170
+#define DEFAULT_ARR_MS 50
+#define MAX_REPEATS_PER_TICK FIELD_W
+
+// Held-input bookkeeping shared by the engines. userInput(action, true)
+// reports a press, userInput(action, false) for a held action reports its
+// release, and userInput(action, false) for anything else is a single tap.
+// The engine clock, not the frontend, drives the repeats: the first one
+// fires das ms after the press and the rest every arr ms.
+typedef struct {
+  unsigned long long das;
+  unsigned long long arr;
+  unsigned held;  // bit per UserAction_t
+  int repeating;  // action being auto-repeated, -1 if none
+  unsigned long long next_repeat;
+} AutoRepeat_t;
+
+// Delays come from BRICKGAME_DAS_MS and BRICKGAME_ARR_MS when set.
+void initAutoRepeat(AutoRepeat_t *repeat);
+void setAutoRepeatRates(AutoRepeat_t *repeat, int das, int arr);
+
+// Returns true when the input has to be applied now: for a tap and for the
+// press of a hold, but not for a release or a duplicate press.
+bool acceptHeldInput(AutoRepeat_t *repeat, UserAction_t action, bool hold);
+bool isInputHeld(const AutoRepeat_t *repeat, UserAction_t action);
+// False for state no setAutoRepeatRates() or startAutoRepeat() could leave
+// behind, such as a zero repeat rate; restores from a file check it first.
+bool validAutoRepeat(const AutoRepeat_t *repeat);
+void releaseAllInputs(AutoRepeat_t *repeat);
+
+// Called by the engine for held actions that repeat, right after applying
+// the press. now is in engine milliseconds.
+void startAutoRepeat(AutoRepeat_t *repeat, UserAction_t action,
+                     unsigned long long now);
+// Number of repeats that fell due by now; the schedule moves past them.
+int dueAutoRepeats(AutoRepeat_t *repeat, unsigned long long now);
+// Milliseconds until the next repeat, NO_TIMEOUT if nothing repeats.
+unsigned long long autoRepeatTimeLeft(const AutoRepeat_t *repeat,
+                                      unsigned long long now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_AUTO_REPEAT_H_
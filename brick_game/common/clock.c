@@ -0,0 +1,21 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include "clock.h"
+
+#include <time.h>
+
+unsigned long long monotonicNanos(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL +
+         (unsigned long long)ts.tv_nsec;
+}
+
+static _Thread_local const unsigned long long *game_clock = NULL;
+
+unsigned long long gameMillis(void) {
+  if (game_clock) return *game_clock;
+  return monotonicNanos() / NANOS_PER_MILLI;
+}
+
+void setGameClock(const unsigned long long *millis) { game_clock = millis; }
@@ -0,0 +1,27 @@
+#ifndef SRC_BRICK_GAME_COMMON_CLOCK_H_
+#define SRC_BRICK_GAME_COMMON_CLOCK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NANOS_PER_MILLI 1000000ULL
+#define NO_TIMEOUT ((unsigned long long)-1)
+
+// Monotonic time in nanoseconds, for stamping events across threads.
+unsigned long long monotonicNanos(void);
+
+// Game time in milliseconds. The engines read it instead of the system clock,
+// so whoever drives a game can pin it: the engine thread holds it still for
+// the length of each call, and replays run the game on a virtual clock.
+// Without a pinned clock it follows monotonicNanos().
+unsigned long long gameMillis(void);
+// Makes gameMillis() on the calling thread return *millis until it is called
+// again with NULL.
+void setGameClock(const unsigned long long *millis);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_CLOCK_H_
@@ -0,0 +1,367 @@
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include "corpus.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <threads.h>
+#include <unistd.h>
+
+#define CORPUS_COPY_CHUNK 65536
+
+static uint64_t alignUp(uint64_t offset) {
+  return (offset + CORPUS_ALIGN - 1) / CORPUS_ALIGN * CORPUS_ALIGN;
+}
+
+bool startCorpus(CorpusWriter_t *writer, const char *path, const char *game) {
+  memset(writer, 0, sizeof(*writer));
+  writer->file = fopen(path, "wb+");
+  writer->codes = tmpfile();
+  writer->deltas = tmpfile();
+  CorpusHeader_t *header = &writer->header;
+  memcpy(header->magic, CORPUS_MAGIC, sizeof(header->magic));
+  header->version = CORPUS_VERSION;
+  header->header_size = sizeof(*header);
+  strncpy(header->game, game, REPLAY_GAME_MAX - 1);
+  header->sessions_offset = alignUp(sizeof(*header));
+
+  // The summaries go straight into the file; the header is rewritten last.
+  bool ok = writer->file && writer->codes && writer->deltas &&
+            fseek(writer->file, (long)header->sessions_offset, SEEK_SET) == 0;
+  if (!ok) {
+    if (writer->file) fclose(writer->file);
+    if (writer->codes) fclose(writer->codes);
+    if (writer->deltas) fclose(writer->deltas);
+    memset(writer, 0, sizeof(*writer));
+  }
+  return ok;
+}
+
+bool addCorpusSession(CorpusWriter_t *writer, CorpusSession_t *session,
+                      const uint8_t *codes, const uint32_t *deltas,
+                      size_t entries) {
+  if (!writer->file || entries > UINT32_MAX) return false;
+  session->first_entry = writer->header.entries;
+  session->entries = (uint32_t)entries;
+  if (fwrite(codes, sizeof(*codes), entries, writer->codes) != entries ||
+      fwrite(deltas, sizeof(*deltas), entries, writer->deltas) != entries ||
+      fwrite(session, sizeof(*session), 1, writer->file) != 1)
+    return false;
+  writer->header.sessions++;
+  writer->header.entries += entries;
+  return true;
+}
+
+static bool appendColumn(FILE *file, FILE *column, uint64_t offset) {
+  static const char padding[CORPUS_ALIGN];
+  long position = ftell(file);
+  if (position < 0 || (uint64_t)position > offset ||
+      fwrite(padding, 1, offset - (uint64_t)position, file) !=
+          offset - (uint64_t)position)
+    return false;
+
+  char chunk[CORPUS_COPY_CHUNK];
+  rewind(column);
+  size_t read;
+  while ((read = fread(chunk, 1, sizeof(chunk), column)) > 0) {
+    if (fwrite(chunk, 1, read, file) != read) return false;
+  }
+  return !ferror(column);
+}
+
+bool finishCorpus(CorpusWriter_t *writer) {
+  if (!writer->file) return false;
+  CorpusHeader_t *header = &writer->header;
+  header->codes_offset = alignUp(header->sessions_offset +
+                                 header->sessions * sizeof(CorpusSession_t));
+  header->deltas_offset = alignUp(header->codes_offset + header->entries);
+  header->size = header->deltas_offset + header->entries * sizeof(uint32_t);
+
+  bool ok = appendColumn(writer->file, writer->codes, header->codes_offset) &&
+            appendColumn(writer->file, writer->deltas, header->deltas_offset) &&
+            fseek(writer->file, 0, SEEK_SET) == 0 &&
+            fwrite(header, sizeof(*header), 1, writer->file) == 1;
+  ok = fclose(writer->file) == 0 && ok;
+  fclose(writer->codes);
+  fclose(writer->deltas);
+  writer->file = writer->codes = writer->deltas = NULL;
+  return ok;
+}
+
+typedef struct {
+  uint8_t *codes;
+  uint32_t *deltas;
+  size_t count;
+  size_t capacity;
+} EntryColumns_t;
+
+static bool appendEntry(EntryColumns_t *columns, const ReplayEntry_t *entry) {
+  if (columns->count == columns->capacity) {
+    size_t capacity = columns->capacity ? columns->capacity * 2 : 4096;
+    uint8_t *codes = realloc(columns->codes, capacity * sizeof(*codes));
+    if (!codes) return false;
+    columns->codes = codes;
+    uint32_t *deltas = realloc(columns->deltas, capacity * sizeof(*deltas));
+    if (!deltas) return false;
+    columns->deltas = deltas;
+    columns->capacity = capacity;
+  }
+  columns->codes[columns->count] =
+      (uint8_t)((entry->action + 4) << 1 | (entry->hold ? 1 : 0));
+  columns->deltas[columns->count] =
+      entry->delta > UINT32_MAX ? UINT32_MAX : (uint32_t)entry->delta;
+  columns->count++;
+  return true;
+}
+
+// Counts the pieces spawned since *seen; a ring that lapped it only has the
+// last EVENT_RING_SIZE events left to count.
+static void countPieces(const EventRing_t *ring, uint32_t *seen,
+                        CorpusSession_t *session) {
+  if (!ring) return;
+  uint32_t head = ring->head;
+  if (head - *seen > EVENT_RING_SIZE) *seen = head - EVENT_RING_SIZE;
+  for (; *seen != head; (*seen)++) {
+    const GameEvent_t *event = &ring->events[*seen & (EVENT_RING_SIZE - 1)];
+    if (event->type == EVENT_PIECE_SPAWNED && event->a < CORPUS_PIECE_TYPES)
+      session->pieces[event->a]++;
+  }
+}
+
+static void summarise(CorpusSession_t *session, const Frame_t *frame,
+                      const ReplayClaim_t *claim, bool reached) {
+  session->score = frame->score;
+  session->level = frame->level;
+  session->lines = frame->lines;
+  if (!claim->present) return;
+  session->flags |= CORPUS_CLAIMED;
+  if (reached && claim->score == frame->score &&
+      claim->level == frame->level && claim->lines == frame->lines)
+    session->flags |= CORPUS_VERIFIED;
+}
+
+bool addReplayToCorpus(CorpusWriter_t *writer, const char *path,
+                       const EngineOps_t *ops) {
+  ReplayPlayer_t player;
+  if (!openReplay(&player, path, ops)) return false;
+  CorpusSession_t session;
+  memset(&session, 0, sizeof(session));
+  session.seed = player.header.seed;
+  EntryColumns_t columns = {0};
+  const EventRing_t *ring = ops->events ? ops->events(player.game) : NULL;
+  uint32_t seen = ring ? ring->head : 0;
+
+  // The result is the frame at the claim, as verifyReplay() sees it, or the
+  // last one when the replay claims nothing.
+  Frame_t frame;
+  bool reached = false;
+  bool ok = true;
+  while (ok && !player.finished) {
+    if (player.claim.present && player.entries == player.claim.entries) {
+      fillReplayFrame(&player, &frame);
+      reached = true;
+    }
+    ok = appendEntry(&columns, &player.next);
+    if (player.next.action >= 0) session.inputs++;
+    playReplayEntries(&player, 1);
+    countPieces(ring, &seen, &session);
+  }
+  if (!reached) fillReplayFrame(&player, &frame);
+  reached = reached || player.entries == player.claim.entries;
+  summarise(&session, &frame, &player.claim, reached);
+  session.millis = replayElapsed(&player);
+  closeReplay(&player);
+
+  ok = ok && addCorpusSession(writer, &session, columns.codes, columns.deltas,
+                              columns.count);
+  free(columns.codes);
+  free(columns.deltas);
+  return ok;
+}
+
+static bool validCorpus(const CorpusHeader_t *header, size_t size) {
+  if (size < sizeof(*header) ||
+      memcmp(header->magic, CORPUS_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != CORPUS_VERSION ||
+      header->header_size != sizeof(*header) || header->size != size)
+    return false;
+  // Every column has to lie inside the file, in order and aligned. The
+  // offsets come from the file, so each one is bounded before it is
+  // subtracted, and the column lengths are compared against the room left
+  // rather than added to an offset that could wrap.
+  uint64_t sessions = header->sessions_offset, codes = header->codes_offset,
+           deltas = header->deltas_offset;
+  return sessions >= sizeof(*header) && sessions <= codes && codes <= deltas &&
+         deltas <= size && sessions % CORPUS_ALIGN == 0 &&
+         codes % CORPUS_ALIGN == 0 && deltas % CORPUS_ALIGN == 0 &&
+         header->sessions <= (codes - sessions) / sizeof(CorpusSession_t) &&
+         header->entries <= deltas - codes &&
+         header->entries <= (size - deltas) / sizeof(uint32_t);
+}
+
+bool openCorpus(Corpus_t *corpus, const char *path) {
+  memset(corpus, 0, sizeof(*corpus));
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat info;
+  void *map = MAP_FAILED;
+  if (fstat(fd, &info) == 0 && info.st_size > 0)
+    map = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return false;
+
+  size_t size = (size_t)info.st_size;
+  const CorpusHeader_t *header = map;
+  if (!validCorpus(header, size)) {
+    munmap(map, size);
+    return false;
+  }
+  // Scans go front to back; let the kernel read ahead aggressively.
+  madvise(map, size, MADV_SEQUENTIAL);
+  const uint8_t *bytes = map;
+  corpus->header = header;
+  corpus->sessions =
+      (const CorpusSession_t *)(bytes + header->sessions_offset);
+  corpus->codes = bytes + header->codes_offset;
+  corpus->deltas = (const uint32_t *)(bytes + header->deltas_offset);
+  corpus->map = map;
+  corpus->size = size;
+  return true;
+}
+
+void closeCorpus(Corpus_t *corpus) {
+  if (corpus->map) munmap(corpus->map, corpus->size);
+  memset(corpus, 0, sizeof(*corpus));
+}
+
+void mergeCorpusStats(CorpusStats_t *into, const CorpusStats_t *stats) {
+  // Every field is a uint64_t counter.
+  uint64_t *target = (uint64_t *)into;
+  const uint64_t *source = (const uint64_t *)stats;
+  for (size_t i = 0; i < sizeof(*into) / sizeof(uint64_t); i++)
+    target[i] += source[i];
+}
+
+static int scoreBucket(int32_t score) {
+  int bucket = 0;
+  for (uint32_t value = score > 0 ? (uint32_t)score : 0; value; value >>= 1)
+    bucket++;
+  return bucket < CORPUS_SCORE_BUCKETS ? bucket : CORPUS_SCORE_BUCKETS - 1;
+}
+
+static void scanSession(const CorpusSession_t *session, CorpusStats_t *stats) {
+  stats->sessions++;
+  if (session->flags & CORPUS_VERIFIED) stats->verified++;
+  stats->entries += session->entries;
+  stats->inputs += session->inputs;
+  stats->millis += session->millis;
+  for (int i = 0; i < CORPUS_PIECE_TYPES; i++)
+    stats->pieces[i] += session->pieces[i];
+  stats->scores[scoreBucket(session->score)]++;
+  int level = session->level < 0 ? 0 : session->level;
+  stats->levels[level < CORPUS_LEVELS ? level : CORPUS_LEVELS - 1]++;
+  if (session->millis > 0) {
+    uint64_t apm = session->inputs * 60000ULL / session->millis;
+    uint64_t bucket = apm / CORPUS_APM_STEP;
+    stats->apm[bucket < CORPUS_APM_BUCKETS ? bucket : CORPUS_APM_BUCKETS - 1]++;
+  }
+}
+
+// One pass over a contiguous run of codes. Most entries are clock steps, so
+// four interleaved tables keep consecutive increments of the same code from
+// waiting on each other.
+static void countCodes(const uint8_t *codes, uint64_t count,
+                       uint64_t histogram[CORPUS_CODES]) {
+  uint32_t tables[4][CORPUS_CODES] = {{0}};
+  uint64_t i = 0;
+  while (i < count) {
+    // Flush before a table can overflow.
+    uint64_t end = count - i > (1u << 30) ? i + (1u << 30) : count;
+    for (; i + 4 <= end; i += 4) {
+      tables[0][codes[i] & (CORPUS_CODES - 1)]++;
+      tables[1][codes[i + 1] & (CORPUS_CODES - 1)]++;
+      tables[2][codes[i + 2] & (CORPUS_CODES - 1)]++;
+      tables[3][codes[i + 3] & (CORPUS_CODES - 1)]++;
+    }
+    for (; i < end; i++) tables[0][codes[i] & (CORPUS_CODES - 1)]++;
+    for (int t = 0; t < 4; t++) {
+      for (int c = 0; c < CORPUS_CODES; c++) {
+        histogram[c] += tables[t][c];
+        tables[t][c] = 0;
+      }
+    }
+  }
+}
+
+typedef struct {
+  const Corpus_t *corpus;
+  uint64_t next;  // first session of the next chunk, __atomic_fetch_add
+} ScanQueue_t;
+
+typedef struct {
+  ScanQueue_t *queue;
+  CorpusStats_t stats;
+} ScanWorker_t;
+
+static int scanWorker(void *arg) {
+  ScanWorker_t *worker = arg;
+  const Corpus_t *corpus = worker->queue->corpus;
+  const uint64_t sessions = corpus->header->sessions;
+  uint64_t codes[CORPUS_CODES] = {0};
+  for (;;) {
+    uint64_t first = __atomic_fetch_add(&worker->queue->next,
+                                        CORPUS_SCAN_CHUNK, __ATOMIC_RELAXED);
+    if (first >= sessions) break;
+    uint64_t last = first + CORPUS_SCAN_CHUNK < sessions
+                        ? first + CORPUS_SCAN_CHUNK
+                        : sessions;
+    for (uint64_t i = first; i < last; i++)
+      scanSession(&corpus->sessions[i], &worker->stats);
+    // Sessions are packed back to back, so a chunk's codes are one run.
+    const CorpusSession_t *end = &corpus->sessions[last - 1];
+    uint64_t from = corpus->sessions[first].first_entry;
+    uint64_t to = end->first_entry + end->entries;
+    if (to > from && to <= corpus->header->entries)
+      countCodes(corpus->codes + from, to - from, codes);
+    worker->stats.bytes += (last - first) * sizeof(CorpusSession_t) +
+                           (to > from ? to - from : 0);
+  }
+  for (int code = 0; code < CORPUS_CODES; code++) {
+    int action = (code >> 1) - 4;
+    if (action >= 0 && action < CORPUS_ACTIONS)
+      worker->stats.actions[action] += codes[code];
+  }
+  return 0;
+}
+
+void scanCorpus(const Corpus_t *corpus, int threads, CorpusStats_t *stats) {
+  memset(stats, 0, sizeof(*stats));
+  if (threads < 1) threads = 1;
+  ScanQueue_t queue = {corpus, 0};
+  // The calling thread is the last worker.
+  int helpers = threads - 1;
+  ScanWorker_t *workers = calloc((size_t)threads, sizeof(*workers));
+  thrd_t *handles = calloc((size_t)threads, sizeof(*handles));
+  int started = 0;
+  if (workers && handles) {
+    for (; started < helpers; started++) {
+      workers[started].queue = &queue;
+      if (thrd_create(&handles[started], scanWorker, &workers[started]) !=
+          thrd_success)
+        break;
+    }
+  }
+  ScanWorker_t self = {&queue, {0}};
+  scanWorker(&self);
+  for (int i = 0; i < started; i++) {
+    thrd_join(handles[i], NULL);
+    mergeCorpusStats(stats, &workers[i].stats);
+  }
+  mergeCorpusStats(stats, &self.stats);
+  free(handles);
+  free(workers);
+}
@@ -0,0 +1,128 @@
+#ifndef SRC_BRICK_GAME_COMMON_CORPUS_H_
+#define SRC_BRICK_GAME_COMMON_CORPUS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "engine.h"
+#include "replay.h"
+
+#define CORPUS_MAGIC "BGCP"
+#define CORPUS_VERSION 1
+#define CORPUS_ALIGN 64          // every column starts on a cache line
+#define CORPUS_PIECE_TYPES 7     // Block_t values
+#define CORPUS_ACTIONS 8         // UserAction_t values
+#define CORPUS_CODES 32          // entry codes, (action + 4) << 1 | hold
+#define CORPUS_SCORE_BUCKETS 16  // 0, then powers of two
+#define CORPUS_LEVELS 11         // the last bucket holds 10 and up
+#define CORPUS_APM_BUCKETS 16
+#define CORPUS_APM_STEP 20       // actions per minute per bucket
+#define CORPUS_SCAN_CHUNK 1024   // sessions a worker takes at a time
+
+// Many replays in one file, one column per field rather than one record per
+// session, so an aggregate reads only the columns it needs and each column
+// is a flat array that maps straight into memory:
+//
+//   header | sessions[sessions] | codes[entries] | deltas[entries]
+//
+// Sessions are fixed-size summaries, worked out by playing the replay when it
+// is packed. Codes and deltas hold every entry of every session back to back,
+// the code as a byte in the replay's own encoding and the delta as
+// milliseconds; a session's entries start at its first_entry. Keyframes stay
+// behind, they only matter to seeks.
+typedef struct {
+  char magic[4];
+  uint16_t version;
+  uint16_t header_size;
+  char game[REPLAY_GAME_MAX];
+  uint64_t sessions;
+  uint64_t entries;
+  uint64_t sessions_offset;
+  uint64_t codes_offset;
+  uint64_t deltas_offset;
+  uint64_t size;
+} CorpusHeader_t;
+
+#define CORPUS_CLAIMED 1u   // the replay claims a result
+#define CORPUS_VERIFIED 2u  // and playing it back reaches that result
+
+typedef struct {
+  uint64_t seed;
+  uint64_t first_entry;
+  uint64_t millis;   // game time covered
+  uint32_t entries;
+  uint32_t inputs;   // entries that are player actions
+  int32_t score;     // at the claim, or at the end without one
+  int32_t level;
+  int32_t lines;
+  uint32_t flags;
+  uint32_t pieces[CORPUS_PIECE_TYPES];  // spawns by type, from the events
+  uint32_t reserved;
+} CorpusSession_t;
+
+// Columns are spooled to temporary files while sessions are added and
+// appended behind the summaries when the corpus is finished, so memory use
+// does not grow with the corpus.
+typedef struct {
+  FILE *file;
+  FILE *codes;
+  FILE *deltas;
+  CorpusHeader_t header;
+} CorpusWriter_t;
+
+bool startCorpus(CorpusWriter_t *writer, const char *path, const char *game);
+// Fills in session->first_entry and session->entries.
+bool addCorpusSession(CorpusWriter_t *writer, CorpusSession_t *session,
+                      const uint8_t *codes, const uint32_t *deltas,
+                      size_t entries);
+// Plays the replay through a fresh game on the calling thread, summarises it
+// and adds it. Fails when the file is not a replay of the game behind ops.
+bool addReplayToCorpus(CorpusWriter_t *writer, const char *path,
+                       const EngineOps_t *ops);
+// Closes the file; writer->header is left describing it.
+bool finishCorpus(CorpusWriter_t *writer);
+
+// A read-only mapping of the whole file; the pointers index into it.
+typedef struct {
+  const CorpusHeader_t *header;
+  const CorpusSession_t *sessions;
+  const uint8_t *codes;
+  const uint32_t *deltas;
+  void *map;
+  size_t size;
+} Corpus_t;
+
+bool openCorpus(Corpus_t *corpus, const char *path);
+void closeCorpus(Corpus_t *corpus);
+
+typedef struct {
+  uint64_t sessions;
+  uint64_t verified;
+  uint64_t entries;
+  uint64_t inputs;
+  uint64_t millis;
+  uint64_t actions[CORPUS_ACTIONS];
+  uint64_t pieces[CORPUS_PIECE_TYPES];
+  uint64_t scores[CORPUS_SCORE_BUCKETS];  // [2^(i-1), 2^i), 0 in the first
+  uint64_t levels[CORPUS_LEVELS];
+  uint64_t apm[CORPUS_APM_BUCKETS];  // sessions by actions per minute
+  uint64_t bytes;  // column bytes read
+} CorpusStats_t;
+
+// Aggregates every session on threads workers, each taking
+// CORPUS_SCAN_CHUNK sessions at a time and counting into its own stats.
+// Reads the summaries and the codes column; the deltas are left unread.
+void scanCorpus(const Corpus_t *corpus, int threads, CorpusStats_t *stats);
+void mergeCorpusStats(CorpusStats_t *into, const CorpusStats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_CORPUS_H_
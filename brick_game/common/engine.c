@@ -0,0 +1,263 @@
+#include "engine.h"
+
+#include <stdlib.h>
+#include <threads.h>
+#include <time.h>
+
+#include "clock.h"
+#include "frame_delta.h"
+#include "metrics.h"
+#include "perf_counters.h"
+#include "replay.h"
+#include "seqlock.h"
+#include "spectator.h"
+#include "trace.h"
+#include "triple_buffer.h"
+
+struct EngineThread {
+  const EngineOps_t *ops;
+  void *game;
+  thrd_t thread;
+  mtx_t lock;
+  cnd_t wakeup;
+  InputEvent_t queue[INPUT_QUEUE_SIZE];
+  int queue_head;
+  int queue_count;
+  bool running;
+  unsigned long long frame_id;
+  unsigned long long input_stamp;
+  unsigned long long clock;  // game clock, pinned for the length of a call
+  ReplayRecorder_t recorder;
+  SpectatorStream_t spectator;
+  FrameSeqlock_t published;
+  FrameVersions_t versions;
+  TripleBuffer_t render;
+};
+
+static void publishCurrentFrame(EngineThread_t *engine) {
+  Frame_t *frame = getBackFrame(&engine->render);
+  TraceSpan_t span;
+  beginTraceSpan(&span, "snapshot");
+  PerfSample_t sample;
+  beginPerfSample(&sample);
+  unsigned long long start = monotonicNanos();
+  engine->ops->fill(engine->game, frame);
+  recordMetricLatency(METRIC_SNAPSHOT_LATENCY, monotonicNanos() - start);
+  endPerfSample(&sample, PERF_SITE_SNAPSHOT);
+  endTraceSpan(&span);
+  setMetricGauge(METRIC_SCORE, frame->score);
+  setMetricGauge(METRIC_HIGH_SCORE, frame->high_score);
+  setMetricGauge(METRIC_LEVEL, frame->level);
+  setMetricGauge(METRIC_SPEED, frame->speed);
+  frame->frame_id = ++engine->frame_id;
+  frame->input_stamp = engine->input_stamp;
+  frame->version = updateFrameVersions(&engine->versions, frame);
+  claimReplayResult(&engine->recorder, frame);
+  if (engine->spectator.file) writeSpectatorFrame(&engine->spectator, frame);
+  publishFrame(&engine->published, frame);
+  swapBackFrame(&engine->render);
+}
+
+static void pinClock(EngineThread_t *engine) {
+  engine->clock = monotonicNanos() / NANOS_PER_MILLI;
+}
+
+static void applyInputs(EngineThread_t *engine, const InputEvent_t *pending,
+                        int count) {
+  for (int i = 0; i < count; i++) {
+    pinClock(engine);
+    recordReplayEntry(&engine->recorder, engine->clock, pending[i].action,
+                      pending[i].hold);
+    engine->ops->input(engine->game, pending[i].action, pending[i].hold);
+    engine->input_stamp = pending[i].stamp;
+  }
+  if (count > 0) addMetricCounter(METRIC_INPUTS, (unsigned long long)count);
+}
+
+// Same contract the frontends follow: a zero timeout means the game expects
+// an empty action to advance its state machine.
+unsigned long long stepGameClock(const EngineOps_t *ops, void *game) {
+  unsigned long long time_left = ops->tick(game);
+  if (time_left == 0) {
+    ops->input(game, (UserAction_t)-1, false);
+    time_left = ops->tick(game);
+  }
+  return time_left;
+}
+
+static unsigned long long advanceClock(EngineThread_t *engine) {
+  PerfSample_t sample;
+  beginPerfSample(&sample);
+  unsigned long long start = monotonicNanos();
+  pinClock(engine);
+  recordReplayEntry(&engine->recorder, engine->clock, REPLAY_ADVANCE, false);
+  unsigned long long time_left = stepGameClock(engine->ops, engine->game);
+  recordMetricLatency(METRIC_TICK_LATENCY, monotonicNanos() - start);
+  addMetricCounter(METRIC_TICKS, 1);
+  endPerfSample(&sample, PERF_SITE_TICK);
+  return time_left;
+}
+
+static void waitForWakeup(EngineThread_t *engine,
+                          unsigned long long time_left) {
+  if (time_left == 0) return;
+  if (time_left == NO_TIMEOUT) {
+    cnd_wait(&engine->wakeup, &engine->lock);
+    return;
+  }
+
+  struct timespec deadline;
+  timespec_get(&deadline, TIME_UTC);
+  deadline.tv_sec += (time_t)(time_left / 1000);
+  deadline.tv_nsec += (long)(time_left % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+  cnd_timedwait(&engine->wakeup, &engine->lock, &deadline);
+}
+
+// Entries between keyframes; 0 records none and keeps the file smallest.
+static unsigned long long keyframeInterval(void) {
+  const char *value = getenv(REPLAY_KEYFRAME_ENV);
+  if (value == NULL || *value == '\0') return REPLAY_KEYFRAME_INTERVAL;
+  char *end = NULL;
+  long long parsed = strtoll(value, &end, 10);
+  return (*end == '\0' && parsed >= 0) ? (unsigned long long)parsed
+                                        : REPLAY_KEYFRAME_INTERVAL;
+}
+
+// The seed is only forced on recorded sessions; the others keep whatever the
+// game picked for itself.
+static void startRecording(EngineThread_t *engine) {
+  const char *path = getenv(REPLAY_RECORD_ENV);
+  if (!path || !*path) return;
+
+  uint64_t seed = monotonicNanos();
+  engine->ops->seed(engine->game, seed);
+  startReplayRecording(&engine->recorder, path, engine->ops, engine->game,
+                       seed, engine->clock, keyframeInterval());
+}
+
+static void startSpectating(EngineThread_t *engine) {
+  const char *path = getenv(SPECTATOR_STREAM_ENV);
+  if (!path || !*path) return;
+  startSpectatorStream(&engine->spectator, path, SPECTATOR_KEYFRAME_INTERVAL);
+}
+
+static int drainQueue(EngineThread_t *engine, InputEvent_t *pending) {
+  int count = engine->queue_count;
+  for (int i = 0; i < count; i++) {
+    pending[i] = engine->queue[(engine->queue_head + i) % INPUT_QUEUE_SIZE];
+  }
+  engine->queue_head = (engine->queue_head + count) % INPUT_QUEUE_SIZE;
+  engine->queue_count = 0;
+  return count;
+}
+
+static int engineLoop(void *arg) {
+  EngineThread_t *engine = arg;
+  InputEvent_t pending[INPUT_QUEUE_SIZE];
+
+  setTraceThreadName("engine");
+  setGameClock(&engine->clock);
+  pinClock(engine);
+  engine->game = engine->ops->create();
+  startRecording(engine);
+  startSpectating(engine);
+  unsigned long long time_left = advanceClock(engine);
+  publishCurrentFrame(engine);
+
+  mtx_lock(&engine->lock);
+  while (engine->running) {
+    if (engine->queue_count == 0) waitForWakeup(engine, time_left);
+    int count = drainQueue(engine, pending);
+    mtx_unlock(&engine->lock);
+
+    applyInputs(engine, pending, count);
+    time_left = advanceClock(engine);
+    publishCurrentFrame(engine);
+
+    mtx_lock(&engine->lock);
+  }
+  // Inputs submitted right before the stop (typically Terminate) still reach
+  // the game, so it can persist its score.
+  applyInputs(engine, pending, drainQueue(engine, pending));
+  mtx_unlock(&engine->lock);
+
+  stopReplayRecording(&engine->recorder);
+  stopSpectatorStream(&engine->spectator);
+  engine->ops->destroy(engine->game);
+  setGameClock(NULL);
+  releasePerfCounters();
+  return 0;
+}
+
+EngineThread_t *startEngineThread(const EngineOps_t *ops) {
+  EngineThread_t *engine = calloc(1, sizeof(EngineThread_t));
+  if (!engine) return NULL;
+
+  engine->ops = ops;
+  engine->running = true;
+  initFrameSeqlock(&engine->published);
+  initFrameVersions(&engine->versions);
+  initTripleBuffer(&engine->render);
+  mtx_init(&engine->lock, mtx_plain);
+  cnd_init(&engine->wakeup);
+
+  if (thrd_create(&engine->thread, engineLoop, engine) != thrd_success) {
+    cnd_destroy(&engine->wakeup);
+    mtx_destroy(&engine->lock);
+    free(engine);
+    return NULL;
+  }
+  return engine;
+}
+
+void stopEngineThread(EngineThread_t *engine) {
+  if (!engine) return;
+
+  mtx_lock(&engine->lock);
+  engine->running = false;
+  cnd_signal(&engine->wakeup);
+  mtx_unlock(&engine->lock);
+
+  thrd_join(engine->thread, NULL);
+  cnd_destroy(&engine->wakeup);
+  mtx_destroy(&engine->lock);
+  free(engine);
+}
+
+bool submitInput(EngineThread_t *engine, UserAction_t action, bool hold) {
+  InputEvent_t event = {action, hold, monotonicNanos()};
+  return submitInputEvent(engine, &event);
+}
+
+bool submitInputEvent(EngineThread_t *engine, const InputEvent_t *event) {
+  bool accepted = false;
+
+  mtx_lock(&engine->lock);
+  if (engine->queue_count < INPUT_QUEUE_SIZE) {
+    int tail = (engine->queue_head + engine->queue_count) % INPUT_QUEUE_SIZE;
+    engine->queue[tail] = *event;
+    engine->queue_count++;
+    accepted = true;
+    cnd_signal(&engine->wakeup);
+  }
+  mtx_unlock(&engine->lock);
+
+  return accepted;
+}
+
+unsigned long long readFrame(const EngineThread_t *engine, Frame_t *frame) {
+  return readPublishedFrame(&engine->published, frame);
+}
+
+bool pollFrameDelta(const EngineThread_t *engine, unsigned long long since,
+                    FrameDelta_t *delta) {
+  return readFrameVersionsDelta(&engine->versions, since, delta);
+}
+
+Frame_t *acquireFrame(EngineThread_t *engine, bool *fresh) {
+  return getFrontFrame(&engine->render, fresh);
+}
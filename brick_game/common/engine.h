@@ -0,0 +1,92 @@
+#ifndef SRC_BRICK_GAME_COMMON_ENGINE_H_
+#define SRC_BRICK_GAME_COMMON_ENGINE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "clock.h"
+#include "event_ring.h"
+#include "frame.h"
+#include "frame_delta.h"
+
+#define INPUT_QUEUE_SIZE 64
+
+// Game-agnostic entry points. Every game library exports getEngineOps(), so
+// a frontend picks the game at link time, the same way it does for
+// userInput() and updateCurrentState().
+typedef struct {
+  const char *name;
+  void *(*create)(void);
+  // Called right after create() by drivers that need a reproducible session;
+  // otherwise games seed themselves from the clock.
+  void (*seed)(void *game, unsigned long long seed);
+  void (*destroy)(void *game);
+  void (*input)(void *game, UserAction_t action, bool hold);
+  unsigned long long (*tick)(void *game);
+  void (*fill)(void *game, Frame_t *frame);
+  // The whole simulation state, RNG included, as a blob that load() turns
+  // back into the same game. save() returns the size written, 0 when the
+  // buffer is too small.
+  size_t (*save)(void *game, void *buffer, size_t capacity);
+  bool (*load)(void *game, const void *buffer, size_t size);
+  // The game's event ring, for drivers that follow its events as it plays.
+  const EventRing_t *(*events)(void *game);
+  // Delay and rate of auto-repeated held moves, in milliseconds. create()
+  // takes them from the environment; replays record them and set them back.
+  void (*repeatRates)(void *game, int *das, int *arr);
+  void (*setRepeatRates)(void *game, int das, int arr);
+} EngineOps_t;
+
+const EngineOps_t *getEngineOps(void);
+
+// One step of the game clock, shared by the engine thread and replays: a tick,
+// and when the game reports nothing left to wait, the empty action that
+// advances its state machine and another tick. Returns the next timeout.
+unsigned long long stepGameClock(const EngineOps_t *ops, void *game);
+
+typedef struct {
+  UserAction_t action;
+  bool hold;
+  unsigned long long stamp;  // monotonicNanos() when the input arrived
+} InputEvent_t;
+
+typedef struct EngineThread EngineThread_t;
+
+// Runs the game on a dedicated thread. The game object is created, stepped
+// and destroyed on that thread only; other threads talk to it exclusively
+// through submitInput() and readFrame(). When BRICKGAME_RECORD names a file,
+// the session is recorded there as a replay.
+EngineThread_t *startEngineThread(const EngineOps_t *ops);
+void stopEngineThread(EngineThread_t *engine);
+
+// Thread-safe. Returns false when the input queue is full. submitInput()
+// stamps the event itself; frontends that see the input earlier stamp it on
+// arrival and use submitInputEvent().
+bool submitInput(EngineThread_t *engine, UserAction_t action, bool hold);
+bool submitInputEvent(EngineThread_t *engine, const InputEvent_t *event);
+
+// Lock-free, allocation-free copy of the latest completed frame. Returns its
+// frame_id, which is 0 until the engine has published its first frame.
+unsigned long long readFrame(const EngineThread_t *engine, Frame_t *frame);
+
+// Lock-free and allocation-free: what changed since the version the caller
+// saw last, 0 before the first call. Returns false when nothing did, so a
+// renderer, streamer or bot polling in a loop does work in proportion to the
+// changes, not to the board.
+bool pollFrameDelta(const EngineThread_t *engine, unsigned long long since,
+                    FrameDelta_t *delta);
+
+// Zero-copy access for the one render stage of a frontend, through a triple
+// buffer. The frame stays valid until the next call; *fresh tells whether it
+// changed since then. Never blocks the engine.
+Frame_t *acquireFrame(EngineThread_t *engine, bool *fresh);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_ENGINE_H_
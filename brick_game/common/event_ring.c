@@ -0,0 +1,110 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "event_ring.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+static EventRing_t *registered[EVENT_RING_MAX_REGISTERED];
+static _Thread_local bool dumps_suspended = false;
+
+static void dumpRegisteredRings(int signal) {
+  (void)signal;
+  for (int i = 0; i < EVENT_RING_MAX_REGISTERED; i++) {
+    EventRing_t *ring = __atomic_load_n(&registered[i], __ATOMIC_ACQUIRE);
+    if (ring) dumpEventRing(ring);
+  }
+}
+
+static void installDumpHandler(void) {
+  struct sigaction current;
+  if (sigaction(EVENT_DUMP_SIGNAL, NULL, &current) != 0) return;
+  if (current.sa_handler != SIG_DFL) return;
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = dumpRegisteredRings;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(EVENT_DUMP_SIGNAL, &action, NULL);
+}
+
+void initEventRing(EventRing_t *ring, const char *game) {
+  memset(ring, 0, sizeof(*ring));
+  snprintf(ring->path, sizeof(ring->path), "%s_events.bin", game);
+
+  installDumpHandler();
+  for (int i = 0; i < EVENT_RING_MAX_REGISTERED; i++) {
+    EventRing_t *expected = NULL;
+    if (__atomic_compare_exchange_n(&registered[i], &expected, ring, false,
+                                    __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+      break;
+    }
+  }
+}
+
+void releaseEventRing(EventRing_t *ring) {
+  for (int i = 0; i < EVENT_RING_MAX_REGISTERED; i++) {
+    EventRing_t *expected = ring;
+    __atomic_compare_exchange_n(&registered[i], &expected, NULL, false,
+                                __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+  }
+}
+
+void emitGameEvent(EventRing_t *ring, GameEventType_t type, int a, int b,
+                   int value) {
+  uint32_t index = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+  GameEvent_t *event = &ring->events[index & (EVENT_RING_SIZE - 1)];
+  __atomic_store_n(&event->sequence, 0, __ATOMIC_RELAXED);
+  event->tick = ring->tick;
+  event->type = (uint8_t)type;
+  event->a = (uint8_t)a;
+  event->b = (uint16_t)b;
+  event->value = value;
+  __atomic_store_n(&event->sequence, index + 1, __ATOMIC_RELEASE);
+  __atomic_store_n(&ring->head, index + 1, __ATOMIC_RELEASE);
+}
+
+void advanceEventTick(EventRing_t *ring) {
+  __atomic_store_n(&ring->tick, ring->tick + 1, __ATOMIC_RELAXED);
+}
+
+static bool writeAll(int fd, const void *data, size_t size) {
+  const char *bytes = data;
+  while (size > 0) {
+    ssize_t written = write(fd, bytes, size);
+    if (written <= 0) return false;
+    bytes += written;
+    size -= (size_t)written;
+  }
+  return true;
+}
+
+void suspendEventDumps(bool suspended) { dumps_suspended = suspended; }
+
+bool dumpEventRing(const EventRing_t *ring) {
+  if (dumps_suspended) return false;
+  int fd = open(ring->path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return false;
+
+  EventDumpHeader_t header = {
+      .magic = {'B', 'G', 'E', 'V'},
+      .version = EVENT_DUMP_VERSION,
+      .event_size = sizeof(GameEvent_t),
+      .capacity = EVENT_RING_SIZE,
+      .head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE),
+  };
+  bool ok = writeAll(fd, &header, sizeof(header)) &&
+            writeAll(fd, ring->events, sizeof(ring->events));
+  return close(fd) == 0 && ok;
+}
+
+const char *gameEventName(int type) {
+  static const char *const NAMES[EVENT_TYPES] = {
+      "?",           "piece_spawned", "piece_locked",   "lines_cleared",
+      "level_up",    "apple_eaten",   "state_changed", "score_persisted"};
+  return type > 0 && type < EVENT_TYPES ? NAMES[type] : "?";
+}
@@ -0,0 +1,81 @@
+#ifndef SRC_BRICK_GAME_COMMON_EVENT_RING_H_
+#define SRC_BRICK_GAME_COMMON_EVENT_RING_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define EVENT_RING_SIZE 4096  // power of two
+#define EVENT_RING_MAX_REGISTERED 4
+#define EVENT_RING_PATH_MAX 64
+#define EVENT_DUMP_MAGIC "BGEV"
+#define EVENT_DUMP_VERSION 1
+#define EVENT_DUMP_SIGNAL SIGUSR1
+
+typedef enum {
+  EVENT_PIECE_SPAWNED = 1,  // a: block type, b: rotation
+  EVENT_PIECE_LOCKED,       // a: block type, b: column, value: row
+  EVENT_LINES_CLEARED,      // a: lines, value: score
+  EVENT_LEVEL_UP,           // a: level, value: speed
+  EVENT_APPLE_EATEN,        // a: row, b: column, value: score
+  EVENT_STATE_CHANGED,      // a: previous state, b: new state
+  EVENT_SCORE_PERSISTED,    // value: score
+  EVENT_TYPES
+} GameEventType_t;
+
+// 16 bytes per event. sequence is written last; a slot whose sequence does
+// not match its position was being overwritten while it was dumped.
+typedef struct {
+  uint32_t sequence;
+  uint32_t tick;
+  uint8_t type;
+  uint8_t a;
+  uint16_t b;
+  int32_t value;
+} GameEvent_t;
+
+// Always-on flight recorder for one game session, written only by the thread
+// that drives the engine. Emitting is a 16-byte store and two release stores
+// with no read-modify-write; the ring keeps the last EVENT_RING_SIZE
+// events and is dumped to <game>_events.bin on game over or on
+// EVENT_DUMP_SIGNAL.
+typedef struct {
+  GameEvent_t events[EVENT_RING_SIZE];
+  uint32_t head;
+  uint32_t tick;
+  char path[EVENT_RING_PATH_MAX];
+} EventRing_t;
+
+typedef struct {
+  char magic[4];
+  uint16_t version;
+  uint16_t event_size;
+  uint32_t capacity;
+  uint32_t head;
+} EventDumpHeader_t;
+
+// Registers the ring for signal dumps, installing the handler unless the
+// application already handles the signal.
+void initEventRing(EventRing_t *ring, const char *game);
+void releaseEventRing(EventRing_t *ring);
+
+void emitGameEvent(EventRing_t *ring, GameEventType_t type, int a, int b,
+                   int value);
+void advanceEventTick(EventRing_t *ring);
+
+// Async-signal-safe.
+bool dumpEventRing(const EventRing_t *ring);
+// While suspended, dumps requested from the calling thread write nothing, so
+// replayed sessions leave the dump of the last real one alone.
+void suspendEventDumps(bool suspended);
+
+const char *gameEventName(int type);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_EVENT_RING_H_
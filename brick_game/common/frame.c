@@ -0,0 +1,17 @@
+#include "frame.h"
+
+GameInfo_t frameToGameInfo(Frame_t *frame, int *field_rows[FIELD_H],
+                           int *next_rows[NEXT_H]) {
+  for (int i = 0; i < FIELD_H; i++) field_rows[i] = frame->field[i];
+  for (int i = 0; i < NEXT_H; i++) next_rows[i] = frame->next[i];
+
+  GameInfo_t info = {0};
+  info.field = field_rows;
+  info.next = next_rows;
+  info.score = frame->score;
+  info.high_score = frame->high_score;
+  info.level = frame->level;
+  info.speed = frame->speed;
+  info.pause = frame->pause;
+  return info;
+}
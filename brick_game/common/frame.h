@@ -0,0 +1,43 @@
+#ifndef SRC_BRICK_GAME_COMMON_FRAME_H_
+#define SRC_BRICK_GAME_COMMON_FRAME_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "./../../brick_game.h"
+
+#define NEXT_H 4
+#define NEXT_W 4
+
+// Flat, allocation-free counterpart of GameInfo_t. Engines fill it in place,
+// so it can be copied between threads with a plain memcpy.
+typedef struct {
+  int field[FIELD_H][FIELD_W];
+  int next[NEXT_H][NEXT_W];
+  int score;
+  int high_score;
+  int level;
+  int lines;  // rows cleared this game, 0 for games without rows
+  int speed;
+  int pause;
+  // Board cell the player is looking at: the falling block or the head.
+  int focus_row;
+  int focus_col;
+  unsigned long long frame_id;
+  // Moves only when something drawn changed, see FrameVersions_t.
+  unsigned long long version;
+  // Arrival time of the newest input reflected in the frame, 0 if none.
+  unsigned long long input_stamp;
+} Frame_t;
+
+// Builds a GameInfo_t view over the frame. The row arrays are owned by the
+// caller and must outlive the returned view; nothing is allocated.
+GameInfo_t frameToGameInfo(Frame_t *frame, int *field_rows[FIELD_H],
+                           int *next_rows[NEXT_H]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_FRAME_H_
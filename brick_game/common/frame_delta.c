@@ -0,0 +1,155 @@
+#include "frame_delta.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define FIELD_CELLS (FIELD_H * FIELD_W)
+
+static const size_t SCALAR_OFFSETS[FRAME_SCALARS] = {
+    offsetof(Frame_t, score),     offsetof(Frame_t, high_score),
+    offsetof(Frame_t, level),     offsetof(Frame_t, lines),
+    offsetof(Frame_t, speed),     offsetof(Frame_t, pause),
+    offsetof(Frame_t, focus_row), offsetof(Frame_t, focus_col)};
+
+static int scalarValue(const Frame_t *frame, int index) {
+  return *(const int *)((const char *)frame + SCALAR_OFFSETS[index]);
+}
+
+// Field cells first, row by row, then the next piece's.
+static int cellValue(const Frame_t *frame, int cell) {
+  if (cell < FIELD_CELLS) return frame->field[cell / FIELD_W][cell % FIELD_W];
+  cell -= FIELD_CELLS;
+  return frame->next[cell / NEXT_W][cell % NEXT_W];
+}
+
+void initFrameVersions(FrameVersions_t *versions) {
+  memset(versions, 0, sizeof(*versions));
+  __atomic_store_n(&versions->sequence, 0, __ATOMIC_RELEASE);
+}
+
+unsigned long long updateFrameVersions(FrameVersions_t *versions,
+                                       const Frame_t *frame) {
+  uint16_t changed[FRAME_DELTA_CELLS];
+  int count = 0;
+  for (int cell = 0; cell < FRAME_DELTA_CELLS; cell++) {
+    if (cellValue(&versions->frame, cell) != cellValue(frame, cell))
+      changed[count++] = (uint16_t)cell;
+  }
+  unsigned scalars = 0;
+  for (int i = 0; i < FRAME_SCALARS; i++) {
+    if (scalarValue(&versions->frame, i) != scalarValue(frame, i))
+      scalars |= 1u << i;
+  }
+  if (count == 0 && scalars == 0) return versions->version;
+
+  // An odd sequence marks the versions as being written.
+  unsigned sequence = __atomic_load_n(&versions->sequence, __ATOMIC_RELAXED);
+  __atomic_store_n(&versions->sequence, sequence + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  unsigned long long version = versions->version + 1;
+  versions->log_start[version % FRAME_LOG_VERSIONS] = versions->log_end;
+  for (int i = 0; i < count; i++) {
+    versions->log[versions->log_end++ % FRAME_LOG_CELLS] = changed[i];
+    versions->cell_versions[changed[i]] = version;
+  }
+  for (int i = 0; i < FRAME_SCALARS; i++) {
+    if (scalars & (1u << i)) versions->scalar_versions[i] = version;
+  }
+  memcpy(&versions->frame, frame, sizeof(*frame));
+  versions->version = version;
+
+  __atomic_store_n(&versions->sequence, sequence + 2, __ATOMIC_RELEASE);
+  return version;
+}
+
+static void addCell(const FrameVersions_t *versions, FrameDelta_t *delta,
+                    int cell) {
+  FrameCellChange_t *change = &delta->cells[delta->count++];
+  change->next = cell >= FIELD_CELLS;
+  int index = change->next ? cell - FIELD_CELLS : cell;
+  int width = change->next ? NEXT_W : FIELD_W;
+  change->row = (uint8_t)(index / width);
+  change->col = (uint8_t)(index % width);
+  change->value = cellValue(&versions->frame, cell);
+}
+
+// True when the log still holds every cell changed after version since.
+static bool inLog(const FrameVersions_t *versions, unsigned long long since,
+                  unsigned long long version) {
+  if (since == 0 || since > version || version - since > FRAME_LOG_VERSIONS)
+    return false;
+  unsigned long long first =
+      versions->log_start[(since + 1) % FRAME_LOG_VERSIONS];
+  return versions->log_end - first <= FRAME_LOG_CELLS;
+}
+
+// One attempt, which the caller throws away if a write overlapped it. Every
+// index is bounded so that a torn read cannot go out of range first.
+static bool fillDelta(const FrameVersions_t *versions, unsigned long long since,
+                      FrameDelta_t *delta) {
+  unsigned long long version = versions->version;
+  delta->count = 0;
+  delta->scalar_mask = 0;
+  delta->full = false;
+  delta->version = version;
+  if (since == version) return false;
+
+  if (!inLog(versions, since, version)) {
+    delta->full = true;
+    for (int cell = 0; cell < FRAME_DELTA_CELLS; cell++)
+      addCell(versions, delta, cell);
+  } else {
+    // A cell changed in several versions is reported once, at the last one.
+    for (unsigned long long v = since + 1; v <= version; v++) {
+      unsigned long long begin = versions->log_start[v % FRAME_LOG_VERSIONS];
+      unsigned long long end =
+          v == version ? versions->log_end
+                       : versions->log_start[(v + 1) % FRAME_LOG_VERSIONS];
+      if (end < begin || end - begin > FRAME_DELTA_CELLS) break;
+      for (unsigned long long i = begin; i < end; i++) {
+        int cell = versions->log[i % FRAME_LOG_CELLS];
+        if (cell < FRAME_DELTA_CELLS && versions->cell_versions[cell] == v &&
+            delta->count < FRAME_DELTA_CELLS)
+          addCell(versions, delta, cell);
+      }
+    }
+  }
+
+  for (int i = 0; i < FRAME_SCALARS; i++) {
+    if (delta->full || versions->scalar_versions[i] > since) {
+      delta->scalar_mask |= 1u << i;
+      delta->scalars[i] = scalarValue(&versions->frame, i);
+    }
+  }
+  return true;
+}
+
+bool readFrameVersionsDelta(const FrameVersions_t *versions,
+                            unsigned long long since, FrameDelta_t *delta) {
+  unsigned before, after;
+  bool changed = false;
+  do {
+    before = __atomic_load_n(&versions->sequence, __ATOMIC_ACQUIRE);
+    if (before & 1u) continue;
+    changed = fillDelta(versions, since, delta);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    after = __atomic_load_n(&versions->sequence, __ATOMIC_RELAXED);
+    if (before == after) break;
+  } while (1);
+  return changed;
+}
+
+void applyFrameDelta(Frame_t *frame, const FrameDelta_t *delta) {
+  for (int i = 0; i < delta->count; i++) {
+    const FrameCellChange_t *change = &delta->cells[i];
+    if (change->next)
+      frame->next[change->row][change->col] = change->value;
+    else
+      frame->field[change->row][change->col] = change->value;
+  }
+  for (int i = 0; i < FRAME_SCALARS; i++) {
+    if (delta->scalar_mask & (1u << i))
+      *(int *)((char *)frame + SCALAR_OFFSETS[i]) = delta->scalars[i];
+  }
+}
@@ -0,0 +1,82 @@
+#ifndef SRC_BRICK_GAME_COMMON_FRAME_DELTA_H_
+#define SRC_BRICK_GAME_COMMON_FRAME_DELTA_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "frame.h"
+
+#define FRAME_DELTA_CELLS (FIELD_H * FIELD_W + NEXT_H * NEXT_W)
+#define FRAME_LOG_VERSIONS 64  // versions a delta can be built from the log
+#define FRAME_LOG_CELLS 1024   // cell changes kept for them
+
+typedef enum {
+  FRAME_SCORE,
+  FRAME_HIGH_SCORE,
+  FRAME_LEVEL,
+  FRAME_LINES,
+  FRAME_SPEED,
+  FRAME_PAUSE,
+  FRAME_FOCUS_ROW,
+  FRAME_FOCUS_COL,
+  FRAME_SCALARS
+} FrameScalar_t;
+
+typedef struct {
+  uint8_t next;  // a cell of the next piece rather than of the field
+  uint8_t row;
+  uint8_t col;
+  int value;
+} FrameCellChange_t;
+
+// What changed between the caller's version and the current one. A caller
+// too far behind for the change log, or at version 0, gets every cell and
+// every scalar, with full set.
+typedef struct {
+  unsigned long long version;
+  bool full;
+  int count;
+  FrameCellChange_t cells[FRAME_DELTA_CELLS];
+  unsigned scalar_mask;  // 1 << FrameScalar_t for each one that changed
+  int scalars[FRAME_SCALARS];
+} FrameDelta_t;
+
+// Frame versions for a single writer, usually the engine thread, read by
+// any number of threads. The version moves only when a cell or a scalar
+// does, and every cell and scalar remembers the version it last changed in;
+// the cells each version changed go to a log, so a delta is built from the
+// changes themselves, not from a pass over the board. Readers never block the
+// writer: like FrameSeqlock_t, they retry when a write overlapped.
+typedef struct {
+  unsigned sequence;
+  unsigned long long version;
+  Frame_t frame;
+  unsigned long long cell_versions[FRAME_DELTA_CELLS];
+  unsigned long long scalar_versions[FRAME_SCALARS];
+  uint16_t log[FRAME_LOG_CELLS];
+  unsigned long long log_end;  // cell changes logged so far
+  unsigned long long log_start[FRAME_LOG_VERSIONS];  // log_end before each
+} FrameVersions_t;
+
+void initFrameVersions(FrameVersions_t *versions);
+// Takes the newest frame and returns its version, the previous one when
+// nothing a renderer draws changed.
+unsigned long long updateFrameVersions(FrameVersions_t *versions,
+                                       const Frame_t *frame);
+// Returns false, with delta->version set to since, when nothing changed
+// after version since. Otherwise fills delta with the cells and scalars that
+// changed, each with its current value.
+bool readFrameVersionsDelta(const FrameVersions_t *versions,
+                            unsigned long long since, FrameDelta_t *delta);
+// Applies a delta to the caller's copy of the frame.
+void applyFrameDelta(Frame_t *frame, const FrameDelta_t *delta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_FRAME_DELTA_H_
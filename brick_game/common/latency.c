@@ -0,0 +1,76 @@
+#include "latency.h"
+
+#include <string.h>
+
+int latencyBucket(unsigned long long nanos) {
+  if (nanos < LATENCY_SUB_BUCKETS) return (int)nanos;
+
+  int exponent = 63 - __builtin_clzll(nanos);
+  int sub = (int)(nanos >> (exponent - LATENCY_SUB_BITS)) &
+            (LATENCY_SUB_BUCKETS - 1);
+  return (exponent - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS + sub;
+}
+
+// Midpoint of the values that fall into the bucket.
+static unsigned long long bucketValue(int index) {
+  if (index < LATENCY_SUB_BUCKETS) return (unsigned long long)index;
+
+  int exponent = index / LATENCY_SUB_BUCKETS + LATENCY_SUB_BITS - 1;
+  int sub = index % LATENCY_SUB_BUCKETS;
+  unsigned long long width = 1ULL << (exponent - LATENCY_SUB_BITS);
+  return (1ULL << exponent) + (unsigned long long)sub * width + width / 2;
+}
+
+void initLatencyHistogram(LatencyHistogram_t *histogram) {
+  memset(histogram, 0, sizeof(*histogram));
+}
+
+void recordLatency(LatencyHistogram_t *histogram, unsigned long long nanos) {
+  histogram->counts[latencyBucket(nanos)]++;
+  histogram->count++;
+  histogram->sum += nanos;
+  if (nanos > histogram->max) histogram->max = nanos;
+}
+
+void mergeLatencyHistogram(LatencyHistogram_t *dest,
+                           const LatencyHistogram_t *src) {
+  for (int i = 0; i < LATENCY_BUCKETS; i++) dest->counts[i] += src->counts[i];
+  dest->count += src->count;
+  dest->sum += src->sum;
+  if (src->max > dest->max) dest->max = src->max;
+}
+
+unsigned long long latencyPercentile(const LatencyHistogram_t *histogram,
+                                     double percentile) {
+  if (histogram->count == 0) return 0;
+
+  unsigned long long rank =
+      (unsigned long long)(percentile * (double)(histogram->count - 1)) + 1;
+  unsigned long long seen = 0;
+  for (int i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += histogram->counts[i];
+    if (seen >= rank) {
+      unsigned long long value = bucketValue(i);
+      return value < histogram->max ? value : histogram->max;
+    }
+  }
+  return histogram->max;
+}
+
+LatencySummary_t summarizeLatency(const LatencyHistogram_t *histogram) {
+  LatencySummary_t summary;
+  summary.count = histogram->count;
+  summary.p50 = latencyPercentile(histogram, 0.50);
+  summary.p99 = latencyPercentile(histogram, 0.99);
+  summary.max = histogram->max;
+  return summary;
+}
+
+unsigned long long latencyCountAtMost(const LatencyHistogram_t *histogram,
+                                      unsigned long long nanos) {
+  if (nanos >= histogram->max) return histogram->count;
+
+  unsigned long long count = 0;
+  for (int i = 0; i <= latencyBucket(nanos); i++) count += histogram->counts[i];
+  return count;
+}
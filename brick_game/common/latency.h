@@ -0,0 +1,45 @@
+#ifndef SRC_BRICK_GAME_COMMON_LATENCY_H_
+#define SRC_BRICK_GAME_COMMON_LATENCY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LATENCY_SUB_BITS 4
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 1) * LATENCY_SUB_BUCKETS)
+
+// Log-linear histogram of durations in nanoseconds: every power of two is
+// split into 16 buckets, so percentiles are exact to about 6% with a fixed
+// footprint and O(1) recording.
+typedef struct {
+  unsigned long long counts[LATENCY_BUCKETS];
+  unsigned long long count;
+  unsigned long long sum;
+  unsigned long long max;
+} LatencyHistogram_t;
+
+typedef struct {
+  unsigned long long count;
+  unsigned long long p50;
+  unsigned long long p99;
+  unsigned long long max;
+} LatencySummary_t;
+
+void initLatencyHistogram(LatencyHistogram_t *histogram);
+void recordLatency(LatencyHistogram_t *histogram, unsigned long long nanos);
+int latencyBucket(unsigned long long nanos);
+void mergeLatencyHistogram(LatencyHistogram_t *dest,
+                           const LatencyHistogram_t *src);
+unsigned long long latencyPercentile(const LatencyHistogram_t *histogram,
+                                     double percentile);
+LatencySummary_t summarizeLatency(const LatencyHistogram_t *histogram);
+// Samples of at most nanos, to the resolution of the buckets.
+unsigned long long latencyCountAtMost(const LatencyHistogram_t *histogram,
+                                      unsigned long long nanos);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_LATENCY_H_
@@ -0,0 +1,305 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "metrics.h"
+
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <threads.h>
+#include <unistd.h>
+
+#define METRICS_POLL_MS 200
+#define METRICS_REQUEST_WAIT_MS 50
+#define METRICS_PROCESS_MAX 64
+
+typedef struct MetricShard {
+  struct MetricShard *next;
+  unsigned long long counters[METRIC_COUNTERS];
+  LatencyHistogram_t latencies[METRIC_LATENCIES];
+} MetricShard_t;
+
+typedef struct {
+  const char *name;
+  const char *help;
+} MetricInfo_t;
+
+static const MetricInfo_t COUNTERS[METRIC_COUNTERS] = {
+    {"brickgame_ticks_total", "Engine clock steps."},
+    {"brickgame_inputs_total", "User actions applied to the game."},
+    {"brickgame_lines_cleared_total", "Tetris lines removed."},
+    {"brickgame_apples_eaten_total", "Snake apples eaten."},
+    {"brickgame_db_ops_total", "Score database statements executed."},
+    {"brickgame_frames_rendered_total", "Frames drawn by the frontend."}};
+static const MetricInfo_t GAUGES[METRIC_GAUGES] = {
+    {"brickgame_score", "Current score."},
+    {"brickgame_high_score", "Best score on record."},
+    {"brickgame_level", "Current level."},
+    {"brickgame_speed", "Current step interval in milliseconds."}};
+static const MetricInfo_t LATENCIES[METRIC_LATENCIES] = {
+    {"brickgame_tick_duration_seconds", "Time to advance the game clock."},
+    {"brickgame_snapshot_duration_seconds", "Time to copy out a frame."},
+    {"brickgame_persist_duration_seconds", "Time to persist the score."},
+    {"brickgame_render_duration_seconds", "Time to draw a frame."},
+    {"brickgame_db_statement_duration_seconds",
+     "Time to run one score database statement."}};
+// Histogram bucket bounds in nanoseconds, 10us to 100ms.
+static const unsigned long long BOUNDS[] = {
+    10000ULL,   50000ULL,   100000ULL,   250000ULL,  500000ULL,  1000000ULL,
+    2500000ULL, 5000000ULL, 10000000ULL, 25000000ULL, 50000000ULL,
+    100000000ULL};
+
+static MetricShard_t *shards = NULL;
+static _Thread_local MetricShard_t *thread_shard = NULL;
+static long long gauges[METRIC_GAUGES];
+
+static MetricShard_t *getThreadShard(void) {
+  if (thread_shard) return thread_shard;
+
+  MetricShard_t *shard = calloc(1, sizeof(MetricShard_t));
+  if (!shard) return NULL;
+  shard->next = __atomic_load_n(&shards, __ATOMIC_RELAXED);
+  while (!__atomic_compare_exchange_n(&shards, &shard->next, shard, true,
+                                      __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+  }
+  thread_shard = shard;
+  return shard;
+}
+
+// Only the owning thread writes a shard: no read-modify-write needed, the
+// atomic store just keeps concurrent readers from seeing torn values.
+static void bump(unsigned long long *value, unsigned long long delta) {
+  __atomic_store_n(value, *value + delta, __ATOMIC_RELAXED);
+}
+
+void addMetricCounter(MetricCounter_t counter, unsigned long long delta) {
+  MetricShard_t *shard = getThreadShard();
+  if (shard) bump(&shard->counters[counter], delta);
+}
+
+void setMetricGauge(MetricGauge_t gauge, long long value) {
+  __atomic_store_n(&gauges[gauge], value, __ATOMIC_RELAXED);
+}
+
+void recordMetricLatency(MetricLatency_t latency, unsigned long long nanos) {
+  MetricShard_t *shard = getThreadShard();
+  if (!shard) return;
+
+  LatencyHistogram_t *histogram = &shard->latencies[latency];
+  bump(&histogram->counts[latencyBucket(nanos)], 1);
+  bump(&histogram->sum, nanos);
+  if (nanos > histogram->max) {
+    __atomic_store_n(&histogram->max, nanos, __ATOMIC_RELAXED);
+  }
+}
+
+static unsigned long long load(const unsigned long long *value) {
+  return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+
+static void mergeShard(MetricsSnapshot_t *snapshot,
+                       const MetricShard_t *shard) {
+  for (int i = 0; i < METRIC_COUNTERS; i++) {
+    snapshot->counters[i] += load(&shard->counters[i]);
+  }
+  for (int i = 0; i < METRIC_LATENCIES; i++) {
+    LatencyHistogram_t *dest = &snapshot->latencies[i];
+    const LatencyHistogram_t *src = &shard->latencies[i];
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+      dest->counts[bucket] += load(&src->counts[bucket]);
+    }
+    dest->sum += load(&src->sum);
+    unsigned long long max = load(&src->max);
+    if (max > dest->max) dest->max = max;
+  }
+}
+
+void readMetrics(MetricsSnapshot_t *snapshot) {
+  memset(snapshot, 0, sizeof(*snapshot));
+  for (const MetricShard_t *shard = __atomic_load_n(&shards, __ATOMIC_ACQUIRE);
+       shard; shard = shard->next) {
+    mergeShard(snapshot, shard);
+  }
+  // Counts are derived from the buckets, so a sample recorded mid-merge can
+  // never make the total disagree with them.
+  for (int i = 0; i < METRIC_LATENCIES; i++) {
+    LatencyHistogram_t *histogram = &snapshot->latencies[i];
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+      histogram->count += histogram->counts[bucket];
+    }
+  }
+  for (int i = 0; i < METRIC_GAUGES; i++) {
+    snapshot->gauges[i] = __atomic_load_n(&gauges[i], __ATOMIC_RELAXED);
+  }
+}
+
+static void writeHeader(FILE *out, const MetricInfo_t *info,
+                        const char *type) {
+  fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", info->name, info->help,
+          info->name, type);
+}
+
+static void writeHistogram(FILE *out, const MetricInfo_t *info,
+                           const LatencyHistogram_t *histogram,
+                           const char *process) {
+  writeHeader(out, info, "histogram");
+  for (size_t i = 0; i < sizeof(BOUNDS) / sizeof(BOUNDS[0]); i++) {
+    fprintf(out, "%s_bucket{process=\"%s\",le=\"%g\"} %llu\n", info->name,
+            process, BOUNDS[i] / 1e9, latencyCountAtMost(histogram, BOUNDS[i]));
+  }
+  fprintf(out, "%s_bucket{process=\"%s\",le=\"+Inf\"} %llu\n", info->name,
+          process, histogram->count);
+  fprintf(out, "%s_sum{process=\"%s\"} %.9f\n", info->name, process,
+          histogram->sum / 1e9);
+  fprintf(out, "%s_count{process=\"%s\"} %llu\n", info->name, process,
+          histogram->count);
+}
+
+void writeMetrics(FILE *out, const char *process) {
+  MetricsSnapshot_t *snapshot = malloc(sizeof(MetricsSnapshot_t));
+  if (!snapshot) return;
+  readMetrics(snapshot);
+
+  for (int i = 0; i < METRIC_COUNTERS; i++) {
+    writeHeader(out, &COUNTERS[i], "counter");
+    fprintf(out, "%s{process=\"%s\"} %llu\n", COUNTERS[i].name, process,
+            snapshot->counters[i]);
+  }
+  for (int i = 0; i < METRIC_GAUGES; i++) {
+    writeHeader(out, &GAUGES[i], "gauge");
+    fprintf(out, "%s{process=\"%s\"} %lld\n", GAUGES[i].name, process,
+            snapshot->gauges[i]);
+  }
+  for (int i = 0; i < METRIC_LATENCIES; i++) {
+    writeHistogram(out, &LATENCIES[i], &snapshot->latencies[i], process);
+  }
+  free(snapshot);
+}
+
+static struct {
+  int fd;
+  thrd_t thread;
+  bool running;
+  char path[METRICS_SOCKET_PATH_MAX];
+  char process[METRICS_PROCESS_MAX];
+} server = {.fd = -1};
+
+// Waits briefly for a request: HTTP clients send one, plain readers such as
+// socat just wait for the text.
+static bool readHttpRequest(int client) {
+  char request[1024];
+  size_t size = 0;
+  struct pollfd pending = {.fd = client, .events = POLLIN};
+
+  while (size < sizeof(request) - 1 &&
+         poll(&pending, 1, METRICS_REQUEST_WAIT_MS) > 0) {
+    ssize_t received = recv(client, request + size, sizeof(request) - 1 - size,
+                            0);
+    if (received <= 0) break;
+    size += (size_t)received;
+    request[size] = '\0';
+    if (strstr(request, "\r\n\r\n")) break;
+  }
+  return size >= 4 && memcmp(request, "GET ", 4) == 0;
+}
+
+static void answerScrape(int client) {
+  bool http = readHttpRequest(client);
+
+  char *text = NULL;
+  size_t size = 0;
+  FILE *out = open_memstream(&text, &size);
+  if (!out) return;
+  if (http) {
+    fputs("HTTP/1.0 200 OK\r\n"
+          "Content-Type: text/plain; version=0.0.4\r\n"
+          "Connection: close\r\n\r\n",
+          out);
+  }
+  writeMetrics(out, server.process);
+  fclose(out);
+
+  for (size_t sent = 0; sent < size;) {
+    ssize_t written = send(client, text + sent, size - sent, MSG_NOSIGNAL);
+    if (written <= 0) break;
+    sent += (size_t)written;
+  }
+  free(text);
+}
+
+static int serveMetrics(void *arg) {
+  (void)arg;
+  struct pollfd listening = {.fd = server.fd, .events = POLLIN};
+
+  while (__atomic_load_n(&server.running, __ATOMIC_ACQUIRE)) {
+    if (poll(&listening, 1, METRICS_POLL_MS) <= 0) continue;
+    int client = accept(server.fd, NULL, NULL);
+    if (client < 0) continue;
+    answerScrape(client);
+    close(client);
+  }
+  return 0;
+}
+
+static bool resolveSocketPath(const char *process) {
+  const char *env = getenv("BRICKGAME_METRICS_SOCKET");
+  int length;
+  if (env) {
+    if (*env == '\0') return false;
+    length = snprintf(server.path, sizeof(server.path), "%s", env);
+  } else {
+    length = snprintf(server.path, sizeof(server.path),
+                      "/tmp/brickgame-%s-%d.sock", process, (int)getpid());
+  }
+  return length > 0 && (size_t)length < sizeof(server.path);
+}
+
+bool startMetricsServer(const char *process) {
+  if (server.fd >= 0) return true;
+
+  const char *slash = strrchr(process, '/');
+  if (slash) process = slash + 1;
+  snprintf(server.process, sizeof(server.process), "%s", process);
+  if (!resolveSocketPath(server.process)) return false;
+
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  memcpy(address.sun_path, server.path, strlen(server.path) + 1);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) return false;
+  unlink(server.path);
+  if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+      listen(fd, 8) != 0) {
+    close(fd);
+    return false;
+  }
+
+  server.fd = fd;
+  __atomic_store_n(&server.running, true, __ATOMIC_RELEASE);
+  if (thrd_create(&server.thread, serveMetrics, NULL) != thrd_success) {
+    server.running = false;
+    close(fd);
+    unlink(server.path);
+    server.fd = -1;
+    return false;
+  }
+  return true;
+}
+
+void stopMetricsServer(void) {
+  if (server.fd < 0) return;
+
+  if (__atomic_exchange_n(&server.running, false, __ATOMIC_ACQ_REL)) {
+    thrd_join(server.thread, NULL);
+  }
+  close(server.fd);
+  unlink(server.path);
+  server.fd = -1;
+}
+
+const char *metricsSocketPath(void) {
+  return server.fd >= 0 ? server.path : NULL;
+}
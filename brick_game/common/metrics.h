@@ -0,0 +1,71 @@
+#ifndef SRC_BRICK_GAME_COMMON_METRICS_H_
+#define SRC_BRICK_GAME_COMMON_METRICS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "latency.h"
+
+#define METRICS_SOCKET_PATH_MAX 108  // sizeof(sockaddr_un.sun_path)
+
+typedef enum {
+  METRIC_TICKS,
+  METRIC_INPUTS,
+  METRIC_LINES_CLEARED,
+  METRIC_APPLES_EATEN,
+  METRIC_DB_OPS,
+  METRIC_FRAMES_RENDERED,
+  METRIC_COUNTERS
+} MetricCounter_t;
+
+typedef enum {
+  METRIC_SCORE,
+  METRIC_HIGH_SCORE,
+  METRIC_LEVEL,
+  METRIC_SPEED,
+  METRIC_GAUGES
+} MetricGauge_t;
+
+typedef enum {
+  METRIC_TICK_LATENCY,
+  METRIC_SNAPSHOT_LATENCY,
+  METRIC_PERSIST_LATENCY,
+  METRIC_RENDER_LATENCY,
+  METRIC_DB_LATENCY,
+  METRIC_LATENCIES
+} MetricLatency_t;
+
+typedef struct {
+  unsigned long long counters[METRIC_COUNTERS];
+  long long gauges[METRIC_GAUGES];
+  LatencyHistogram_t latencies[METRIC_LATENCIES];
+} MetricsSnapshot_t;
+
+// Always on. Counters and histograms live in per-thread shards that only
+// their own thread writes, so recording is a few plain stores; readMetrics()
+// merges the shards of every thread that ever recorded.
+void addMetricCounter(MetricCounter_t counter, unsigned long long delta);
+void setMetricGauge(MetricGauge_t gauge, long long value);
+void recordMetricLatency(MetricLatency_t latency, unsigned long long nanos);
+
+void readMetrics(MetricsSnapshot_t *snapshot);
+// Prometheus text exposition format, labelled with the process name.
+void writeMetrics(FILE *out, const char *process);
+
+// Serves writeMetrics() on a UNIX-domain socket from a background thread:
+// BRICKGAME_METRICS_SOCKET if set (empty disables), otherwise
+// /tmp/brickgame-<process>-<pid>.sock. Plain readers get the text, HTTP
+// clients (curl --unix-socket) get it as a response.
+bool startMetricsServer(const char *process);
+void stopMetricsServer(void);
+const char *metricsSocketPath(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_METRICS_H_
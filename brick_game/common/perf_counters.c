@@ -0,0 +1,210 @@
+#define _GNU_SOURCE
+
+#include "perf_counters.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char *const EVENT_NAMES[PERF_EVENTS] = {
+    "cycles", "instructions", "cache-misses", "branch-misses"};
+static const char *const SITE_NAMES[PERF_SITES] = {"tick", "snapshot",
+                                                   "persist"};
+
+enum { COUNTERS_UNOPENED, COUNTERS_OPEN, COUNTERS_UNAVAILABLE };
+
+// One counter group per thread; members that fail to open read as zero.
+typedef struct {
+  int state;
+  int fds[PERF_EVENTS];  // fds[0] leads the group, -1 if missing
+  int members;
+  int slot[PERF_EVENTS];  // position in the group read, -1 if missing
+} ThreadCounters_t;
+
+static _Thread_local ThreadCounters_t thread_counters = {
+    COUNTERS_UNOPENED, {-1, -1, -1, -1}, 0, {-1, -1, -1, -1}};
+
+static int enabled = -1;  // -1 until the environment has been read
+static int unavailable_errno = 0;
+static PerfTotals_t totals[PERF_SITES];
+
+bool perfCountersEnabled(void) {
+  int value = __atomic_load_n(&enabled, __ATOMIC_RELAXED);
+  if (value < 0) {
+    const char *env = getenv("BRICKGAME_PERF");
+    value = env != NULL && *env != '\0' && strcmp(env, "0") != 0;
+    __atomic_store_n(&enabled, value, __ATOMIC_RELAXED);
+  }
+  return value;
+}
+
+void enablePerfCounters(void) {
+  __atomic_store_n(&enabled, 1, __ATOMIC_RELAXED);
+}
+
+const char *perfEventName(int event) {
+  return event >= 0 && event < PERF_EVENTS ? EVENT_NAMES[event] : "?";
+}
+
+const char *perfUnavailableReason(void) {
+  int error = __atomic_load_n(&unavailable_errno, __ATOMIC_RELAXED);
+  return error ? strerror(error) : NULL;
+}
+
+#ifdef __linux__
+
+static int openCounter(unsigned long long config, int group) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = group < 0;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+static void openThreadCounters(ThreadCounters_t *counters) {
+  static const unsigned long long CONFIGS[PERF_EVENTS] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+  for (int i = 0; i < PERF_EVENTS; i++) {
+    counters->fds[i] = -1;
+    counters->slot[i] = -1;
+  }
+  counters->fds[0] = openCounter(CONFIGS[0], -1);
+  if (counters->fds[0] < 0) {
+    __atomic_store_n(&unavailable_errno, errno, __ATOMIC_RELAXED);
+    counters->state = COUNTERS_UNAVAILABLE;
+    return;
+  }
+  counters->slot[0] = 0;
+  counters->members = 1;
+  for (int i = 1; i < PERF_EVENTS; i++) {
+    counters->fds[i] = openCounter(CONFIGS[i], counters->fds[0]);
+    if (counters->fds[i] >= 0) counters->slot[i] = counters->members++;
+  }
+  ioctl(counters->fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  counters->state = COUNTERS_OPEN;
+}
+
+static bool readThreadCounters(unsigned long long counts[PERF_EVENTS]) {
+  ThreadCounters_t *counters = &thread_counters;
+  if (counters->state == COUNTERS_UNOPENED) openThreadCounters(counters);
+  if (counters->state != COUNTERS_OPEN) return false;
+
+  unsigned long long values[1 + PERF_EVENTS];
+  ssize_t size = (ssize_t)sizeof(values[0]) * (1 + counters->members);
+  if (read(counters->fds[0], values, (size_t)size) != size) return false;
+  for (int i = 0; i < PERF_EVENTS; i++) {
+    counts[i] = counters->slot[i] < 0 ? 0 : values[1 + counters->slot[i]];
+  }
+  return true;
+}
+
+void releasePerfCounters(void) {
+  ThreadCounters_t *counters = &thread_counters;
+  for (int i = 0; i < PERF_EVENTS; i++) {
+    if (counters->fds[i] >= 0) close(counters->fds[i]);
+    counters->fds[i] = -1;
+  }
+  counters->state = COUNTERS_UNOPENED;
+}
+
+#else
+
+static bool readThreadCounters(unsigned long long counts[PERF_EVENTS]) {
+  (void)counts;
+  __atomic_store_n(&unavailable_errno, ENOSYS, __ATOMIC_RELAXED);
+  return false;
+}
+
+void releasePerfCounters(void) {}
+
+#endif
+
+void readPerfCounters(PerfSample_t *sample) {
+  memset(sample->counts, 0, sizeof(sample->counts));
+  sample->hardware = readThreadCounters(sample->counts);
+  sample->nanos = monotonicNanos();
+  sample->active = true;
+}
+
+void beginPerfSample(PerfSample_t *start) {
+  start->active = false;
+  if (perfCountersEnabled()) readPerfCounters(start);
+}
+
+void endPerfSample(const PerfSample_t *start, PerfSite_t site) {
+  if (!start->active) return;
+
+  PerfSample_t end;
+  readPerfCounters(&end);
+  PerfTotals_t *total = &totals[site];
+  __atomic_fetch_add(&total->calls, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&total->nanos, end.nanos - start->nanos,
+                     __ATOMIC_RELAXED);
+  if (!start->hardware || !end.hardware) return;
+  for (int i = 0; i < PERF_EVENTS; i++) {
+    __atomic_fetch_add(&total->counts[i], end.counts[i] - start->counts[i],
+                       __ATOMIC_RELAXED);
+  }
+}
+
+void getPerfTotals(PerfSite_t site, PerfTotals_t *total) {
+  total->calls = __atomic_load_n(&totals[site].calls, __ATOMIC_RELAXED);
+  total->nanos = __atomic_load_n(&totals[site].nanos, __ATOMIC_RELAXED);
+  for (int i = 0; i < PERF_EVENTS; i++) {
+    total->counts[i] =
+        __atomic_load_n(&totals[site].counts[i], __ATOMIC_RELAXED);
+  }
+}
+
+void resetPerfTotals(void) {
+  for (int site = 0; site < PERF_SITES; site++) {
+    __atomic_store_n(&totals[site].calls, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&totals[site].nanos, 0, __ATOMIC_RELAXED);
+    for (int i = 0; i < PERF_EVENTS; i++) {
+      __atomic_store_n(&totals[site].counts[i], 0, __ATOMIC_RELAXED);
+    }
+  }
+}
+
+void printPerfReport(FILE *out) {
+  if (!perfCountersEnabled()) return;
+
+  const char *reason = perfUnavailableReason();
+  fprintf(out, "perf counters per call%s%s\n",
+          reason ? ", hardware unavailable: " : "", reason ? reason : "");
+  fprintf(out, "%-9s %10s %10s", "site", "calls", "ns");
+  if (!reason) {
+    for (int i = 0; i < PERF_EVENTS; i++) fprintf(out, " %13s", EVENT_NAMES[i]);
+  }
+  fputc('\n', out);
+
+  for (int site = 0; site < PERF_SITES; site++) {
+    PerfTotals_t total;
+    getPerfTotals(site, &total);
+    if (total.calls == 0) continue;
+    fprintf(out, "%-9s %10llu %10llu", SITE_NAMES[site], total.calls,
+            total.nanos / total.calls);
+    if (!reason) {
+      for (int i = 0; i < PERF_EVENTS; i++) {
+        fprintf(out, " %13llu", total.counts[i] / total.calls);
+      }
+    }
+    fputc('\n', out);
+  }
+}
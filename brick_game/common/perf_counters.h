@@ -0,0 +1,61 @@
+#ifndef SRC_BRICK_GAME_COMMON_PERF_COUNTERS_H_
+#define SRC_BRICK_GAME_COMMON_PERF_COUNTERS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#define PERF_EVENTS 4
+
+typedef enum {
+  PERF_SITE_TICK,
+  PERF_SITE_SNAPSHOT,
+  PERF_SITE_PERSIST,
+  PERF_SITES
+} PerfSite_t;
+
+// Raw per-thread readings: cycles, instructions, cache misses and branch
+// misses (user space only), plus monotonic nanoseconds. hardware is false
+// when perf_event_open is unavailable and only the time is meaningful.
+typedef struct {
+  unsigned long long counts[PERF_EVENTS];
+  unsigned long long nanos;
+  bool hardware;
+  bool active;
+} PerfSample_t;
+
+typedef struct {
+  unsigned long long calls;
+  unsigned long long nanos;
+  unsigned long long counts[PERF_EVENTS];
+} PerfTotals_t;
+
+// Off unless BRICKGAME_PERF is set or enablePerfCounters() is called; when
+// off, a begin/end pair costs one relaxed load.
+bool perfCountersEnabled(void);
+void enablePerfCounters(void);
+
+// Counters are opened lazily for each thread. readPerfCounters() works
+// regardless of the enabled flag, for harnesses that measure on their own.
+void readPerfCounters(PerfSample_t *sample);
+// Closes the calling thread's counters. Threads that play a game call it
+// before they return; a later sample on the same thread opens them again.
+void releasePerfCounters(void);
+const char *perfEventName(int event);
+const char *perfUnavailableReason(void);
+
+void beginPerfSample(PerfSample_t *start);
+void endPerfSample(const PerfSample_t *start, PerfSite_t site);
+
+void getPerfTotals(PerfSite_t site, PerfTotals_t *totals);
+void resetPerfTotals(void);
+void printPerfReport(FILE *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_PERF_COUNTERS_H_
@@ -0,0 +1,466 @@
+#include "replay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "auto_repeat.h"
+#include "clock.h"
+#include "event_ring.h"
+#include "score_store.h"
+
+static bool writeVarint(FILE *file, uint64_t value) {
+  unsigned char bytes[10];
+  int count = 0;
+  do {
+    bytes[count] = (unsigned char)(value & 0x7F);
+    value >>= 7;
+    if (value) bytes[count] |= 0x80;
+    count++;
+  } while (value);
+  return fwrite(bytes, 1, (size_t)count, file) == (size_t)count;
+}
+
+static bool readVarint(FILE *file, uint64_t *value) {
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int byte = getc(file);
+    if (byte == EOF) return false;
+    *value |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+bool writeReplayEntry(FILE *file, const ReplayEntry_t *entry) {
+  uint64_t code = ((uint64_t)(entry->action + 4) << 1) | (entry->hold ? 1 : 0);
+  return writeVarint(file, entry->delta) && writeVarint(file, code);
+}
+
+bool readReplayEntry(FILE *file, ReplayEntry_t *entry) {
+  uint64_t delta, code;
+  if (!readVarint(file, &delta) || !readVarint(file, &code)) return false;
+  entry->delta = delta;
+  entry->action = (int)(code >> 1) - 4;
+  entry->hold = code & 1;
+  return true;
+}
+
+bool startReplayRecording(ReplayRecorder_t *recorder, const char *path,
+                          const EngineOps_t *ops, void *game, uint64_t seed,
+                          unsigned long long start_millis,
+                          unsigned long long keyframe_interval) {
+  memset(recorder, 0, sizeof(*recorder));
+  recorder->file = fopen(path, "wb");
+  if (!recorder->file) return false;
+
+  ReplayHeader_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+  header.version = REPLAY_VERSION;
+  header.header_size = sizeof(header);
+  strncpy(header.game, ops->name, REPLAY_GAME_MAX - 1);
+  header.seed = seed;
+  header.start_millis = start_millis;
+  int das = DEFAULT_DAS_MS, arr = DEFAULT_ARR_MS;
+  if (game && ops->repeatRates) ops->repeatRates(game, &das, &arr);
+  header.das_millis = (uint32_t)das;
+  header.arr_millis = (uint32_t)arr;
+  if (fwrite(&header, sizeof(header), 1, recorder->file) != 1) {
+    stopReplayRecording(recorder);
+    return false;
+  }
+  recorder->ops = ops;
+  recorder->game = game;
+  recorder->start_millis = start_millis;
+  recorder->last_millis = start_millis;
+  recorder->keyframe_interval = keyframe_interval;
+  if (keyframe_interval) recorder->blob = malloc(REPLAY_KEYFRAME_MAX);
+  return true;
+}
+
+static bool addKeyframe(ReplayRecorder_t *recorder,
+                        const ReplayKeyframe_t *keyframe) {
+  if (recorder->keyframe_count == recorder->keyframe_capacity) {
+    size_t capacity =
+        recorder->keyframe_capacity ? recorder->keyframe_capacity * 2 : 64;
+    ReplayKeyframe_t *grown =
+        realloc(recorder->keyframes, capacity * sizeof(*grown));
+    if (!grown) return false;
+    recorder->keyframes = grown;
+    recorder->keyframe_capacity = capacity;
+  }
+  recorder->keyframes[recorder->keyframe_count++] = *keyframe;
+  return true;
+}
+
+// The game as it stands after the last recorded call, at that call's clock.
+static void recordKeyframe(ReplayRecorder_t *recorder) {
+  size_t size =
+      recorder->ops->save(recorder->game, recorder->blob, REPLAY_KEYFRAME_MAX);
+  if (size == 0) return;
+
+  ReplayKeyframe_t keyframe = {recorder->entries, recorder->last_millis,
+                               (uint64_t)ftell(recorder->file)};
+  ReplayEntry_t entry = {0, REPLAY_KEYFRAME, false};
+  if (writeReplayEntry(recorder->file, &entry) &&
+      writeVarint(recorder->file, size) &&
+      fwrite(recorder->blob, 1, size, recorder->file) == size) {
+    addKeyframe(recorder, &keyframe);
+  }
+}
+
+static bool isKeyframeDue(const ReplayRecorder_t *recorder) {
+  unsigned long long interval = recorder->keyframe_interval;
+  if (!interval || !recorder->blob || recorder->entries == 0 ||
+      recorder->entries % interval != 0)
+    return false;
+  return recorder->keyframe_count == 0 ||
+         recorder->keyframes[recorder->keyframe_count - 1].entries !=
+             recorder->entries;
+}
+
+void recordReplayEntry(ReplayRecorder_t *recorder, unsigned long long millis,
+                       int action, bool hold) {
+  if (!recorder->file) return;
+  if (isKeyframeDue(recorder)) recordKeyframe(recorder);
+  ReplayEntry_t entry = {millis - recorder->last_millis, action, hold};
+  if (writeReplayEntry(recorder->file, &entry)) recorder->entries++;
+  recorder->last_millis = millis;
+}
+
+void claimReplayResult(ReplayRecorder_t *recorder, const Frame_t *frame) {
+  if (!recorder->file) return;
+  recorder->claim.entries = recorder->entries;
+  recorder->claim.millis = recorder->last_millis - recorder->start_millis;
+  recorder->claim.score = frame->score;
+  recorder->claim.level = frame->level;
+  recorder->claim.lines = frame->lines;
+  recorder->claim.present = 1;
+}
+
+static void writeIndex(ReplayRecorder_t *recorder) {
+  ReplayEntry_t end = {0, REPLAY_END, false};
+  if (!writeReplayEntry(recorder->file, &end)) return;
+
+  ReplayFooter_t footer;
+  memset(&footer, 0, sizeof(footer));
+  footer.index_offset = (uint64_t)ftell(recorder->file);
+  footer.claim = recorder->claim;
+  footer.keyframes = (uint32_t)recorder->keyframe_count;
+  memcpy(footer.magic, REPLAY_INDEX_MAGIC, sizeof(footer.magic));
+  if (fwrite(recorder->keyframes, sizeof(ReplayKeyframe_t),
+             recorder->keyframe_count,
+             recorder->file) == recorder->keyframe_count) {
+    fwrite(&footer, sizeof(footer), 1, recorder->file);
+  }
+}
+
+void stopReplayRecording(ReplayRecorder_t *recorder) {
+  if (recorder->file) {
+    if (recorder->ops) writeIndex(recorder);
+    fclose(recorder->file);
+  }
+  free(recorder->keyframes);
+  free(recorder->blob);
+  memset(recorder, 0, sizeof(*recorder));
+}
+
+// Every call into the game sees the virtual clock and suspended stores, and
+// a replayed game over leaves the event dump of the real one alone.
+static void enterReplay(ReplayPlayer_t *player) {
+  setGameClock(&player->clock);
+  suspendScoreStores(true);
+  suspendEventDumps(true);
+}
+
+static void leaveReplay(void) {
+  suspendEventDumps(false);
+  suspendScoreStores(false);
+  setGameClock(NULL);
+}
+
+// Keyframes only matter to seeks; sequential playback steps over them.
+static void loadNextEntry(ReplayPlayer_t *player) {
+  unsigned long long skipped = 0;
+  uint64_t size;
+  for (;;) {
+    if (!readReplayEntry(player->file, &player->next) ||
+        player->next.action == REPLAY_END) {
+      player->finished = true;
+      return;
+    }
+    if (player->next.action != REPLAY_KEYFRAME) break;
+    skipped += player->next.delta;
+    if (!readVarint(player->file, &size) ||
+        fseek(player->file, (long)size, SEEK_CUR) != 0) {
+      player->finished = true;
+      return;
+    }
+  }
+  player->next.delta += skipped;
+}
+
+// The engine thread steps the game right after every batch of inputs and
+// whenever the time left from the last step runs out; a deadline that goes
+// by without an advance entry is counted once.
+static void applyNextEntry(ReplayPlayer_t *player) {
+  const ReplayEntry_t *entry = &player->next;
+  player->clock += entry->delta;
+  if (player->deadline != NO_TIMEOUT &&
+      player->clock > player->deadline + REPLAY_TICK_SLACK) {
+    player->missed_ticks++;
+    player->deadline = NO_TIMEOUT;
+  }
+  if (entry->action == REPLAY_ADVANCE) {
+    unsigned long long time_left = stepGameClock(player->ops, player->game);
+    player->deadline =
+        time_left == NO_TIMEOUT ? NO_TIMEOUT : player->clock + time_left;
+  } else {
+    player->ops->input(player->game, (UserAction_t)entry->action, entry->hold);
+    if (player->deadline > player->clock) player->deadline = player->clock;
+  }
+  player->entries++;
+  loadNextEntry(player);
+}
+
+static bool readHeader(FILE *file, ReplayHeader_t *header) {
+  return fread(header, sizeof(*header), 1, file) == 1 &&
+         memcmp(header->magic, REPLAY_MAGIC, sizeof(header->magic)) == 0 &&
+         header->version == REPLAY_VERSION &&
+         header->header_size == sizeof(*header);
+}
+
+static bool readFooter(FILE *file, ReplayFooter_t *footer) {
+  return fseek(file, -(long)sizeof(*footer), SEEK_END) == 0 &&
+         fread(footer, sizeof(*footer), 1, file) == 1 &&
+         memcmp(footer->magic, REPLAY_INDEX_MAGIC, sizeof(footer->magic)) == 0;
+}
+
+// A missing or damaged footer leaves the replay without keyframes or claim.
+static void loadIndex(ReplayPlayer_t *player) {
+  ReplayFooter_t footer;
+  if (!readFooter(player->file, &footer)) return;
+  player->claim = footer.claim;
+  if (footer.keyframes == 0) return;
+
+  ReplayKeyframe_t *keyframes = malloc(footer.keyframes * sizeof(*keyframes));
+  player->blob = malloc(REPLAY_KEYFRAME_MAX);
+  if (keyframes && player->blob &&
+      fseek(player->file, (long)footer.index_offset, SEEK_SET) == 0 &&
+      fread(keyframes, sizeof(*keyframes), footer.keyframes, player->file) ==
+          footer.keyframes) {
+    player->keyframes = keyframes;
+    player->keyframe_count = footer.keyframes;
+  } else {
+    free(keyframes);
+  }
+}
+
+// Back to the state right after openReplay(), with a fresh game.
+static void restartReplay(ReplayPlayer_t *player) {
+  const EngineOps_t *ops = player->ops;
+  player->clock = player->header.start_millis;
+  enterReplay(player);
+  if (player->game) ops->destroy(player->game);
+  player->game = ops->create();
+  ops->seed(player->game, player->header.seed);
+  // The recording's rates, whatever the environment says now.
+  if (ops->setRepeatRates)
+    ops->setRepeatRates(player->game, (int)player->header.das_millis,
+                        (int)player->header.arr_millis);
+  leaveReplay();
+  player->entries = 0;
+  player->finished = false;
+  player->deadline = NO_TIMEOUT;
+  player->missed_ticks = 0;
+  fseek(player->file, (long)sizeof(player->header), SEEK_SET);
+  loadNextEntry(player);
+}
+
+bool peekReplay(const char *path, ReplayHeader_t *header, ReplayClaim_t *claim) {
+  FILE *file = fopen(path, "rb");
+  if (!file) return false;
+  ReplayFooter_t footer;
+  bool valid = readHeader(file, header);
+  if (valid && readFooter(file, &footer)) {
+    *claim = footer.claim;
+  } else {
+    memset(claim, 0, sizeof(*claim));
+  }
+  fclose(file);
+  return valid;
+}
+
+bool openReplay(ReplayPlayer_t *player, const char *path,
+                const EngineOps_t *ops) {
+  memset(player, 0, sizeof(*player));
+  player->file = fopen(path, "rb");
+  if (!player->file) return false;
+
+  ReplayHeader_t *header = &player->header;
+  bool valid = readHeader(player->file, header) &&
+               strncmp(header->game, ops->name, REPLAY_GAME_MAX) == 0;
+  if (!valid) {
+    fclose(player->file);
+    player->file = NULL;
+    return false;
+  }
+
+  player->ops = ops;
+  loadIndex(player);
+  restartReplay(player);
+  return true;
+}
+
+void closeReplay(ReplayPlayer_t *player) {
+  if (player->game) {
+    enterReplay(player);
+    player->ops->destroy(player->game);
+    leaveReplay();
+  }
+  if (player->file) fclose(player->file);
+  free(player->keyframes);
+  free(player->blob);
+  memset(player, 0, sizeof(*player));
+}
+
+unsigned long long advanceReplay(ReplayPlayer_t *player,
+                                 unsigned long long millis) {
+  unsigned long long target = player->clock + millis;
+  unsigned long long applied = 0;
+  enterReplay(player);
+  while (!player->finished && player->clock + player->next.delta <= target) {
+    applyNextEntry(player);
+    applied++;
+  }
+  leaveReplay();
+  // The clock stops between two entries, that much closer to the next one.
+  if (!player->finished) player->next.delta -= target - player->clock;
+  player->clock = target;
+  return applied;
+}
+
+unsigned long long fastForwardReplay(ReplayPlayer_t *player) {
+  unsigned long long applied = 0;
+  enterReplay(player);
+  while (!player->finished) {
+    applyNextEntry(player);
+    applied++;
+  }
+  leaveReplay();
+  return applied;
+}
+
+unsigned long long playReplayEntries(ReplayPlayer_t *player,
+                                     unsigned long long count) {
+  unsigned long long applied = 0;
+  enterReplay(player);
+  while (!player->finished && applied < count) {
+    applyNextEntry(player);
+    applied++;
+  }
+  leaveReplay();
+  return applied;
+}
+
+static bool loadKeyframe(ReplayPlayer_t *player,
+                         const ReplayKeyframe_t *keyframe) {
+  ReplayEntry_t entry;
+  uint64_t size;
+  if (fseek(player->file, (long)keyframe->offset, SEEK_SET) != 0 ||
+      !readReplayEntry(player->file, &entry) ||
+      entry.action != REPLAY_KEYFRAME || !readVarint(player->file, &size) ||
+      size > REPLAY_KEYFRAME_MAX ||
+      fread(player->blob, 1, size, player->file) != size)
+    return false;
+
+  enterReplay(player);
+  bool loaded = player->ops->load(player->game, player->blob, size);
+  leaveReplay();
+  if (!loaded) return false;
+  player->clock = keyframe->millis;
+  player->entries = keyframe->entries;
+  player->finished = false;
+  player->deadline = NO_TIMEOUT;
+  loadNextEntry(player);
+  return true;
+}
+
+// The last keyframe saved at or before millis, NULL when there is none.
+static const ReplayKeyframe_t *findKeyframe(const ReplayPlayer_t *player,
+                                            unsigned long long millis) {
+  size_t low = 0, high = player->keyframe_count;
+  while (low < high) {
+    size_t middle = low + (high - low) / 2;
+    if (player->keyframes[middle].millis <= millis)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return low ? &player->keyframes[low - 1] : NULL;
+}
+
+unsigned long long seekReplay(ReplayPlayer_t *player,
+                              unsigned long long millis) {
+  unsigned long long target = player->header.start_millis + millis;
+  const ReplayKeyframe_t *keyframe = findKeyframe(player, target);
+  bool backwards = target < player->clock;
+
+  bool jump = keyframe && (backwards || keyframe->entries > player->entries);
+  if (jump && !loadKeyframe(player, keyframe)) {
+    restartReplay(player);
+  } else if (!jump && backwards) {
+    restartReplay(player);
+  }
+  return advanceReplay(player, target - player->clock);
+}
+
+unsigned long long replayElapsed(const ReplayPlayer_t *player) {
+  return player->clock - player->header.start_millis;
+}
+
+void fillReplayFrame(ReplayPlayer_t *player, Frame_t *frame) {
+  enterReplay(player);
+  player->ops->fill(player->game, frame);
+  leaveReplay();
+}
+
+static bool matchesClaim(const ReplayCheck_t *check) {
+  return check->score == check->claim.score &&
+         check->level == check->claim.level &&
+         check->lines == check->claim.lines;
+}
+
+ReplayVerdict_t verifyReplay(const char *path, const EngineOps_t *ops,
+                             ReplayCheck_t *check) {
+  memset(check, 0, sizeof(*check));
+  ReplayPlayer_t player;
+  if (!openReplay(&player, path, ops)) return check->verdict = REPLAY_INVALID;
+  check->claim = player.claim;
+
+  playReplayEntries(&player, player.claim.entries);
+  bool reached = player.entries == player.claim.entries;
+  check->missed_ticks = player.missed_ticks;
+  Frame_t frame;
+  fillReplayFrame(&player, &frame);
+  check->score = frame.score;
+  check->level = frame.level;
+  check->lines = frame.lines;
+
+  // Whatever came after the claim, typically the terminating input, still
+  // counts towards the work done.
+  fastForwardReplay(&player);
+  check->entries = player.entries;
+  check->millis = replayElapsed(&player);
+  closeReplay(&player);
+
+  if (!check->claim.present)
+    check->verdict = REPLAY_UNCLAIMED;
+  else if (!reached)
+    check->verdict = REPLAY_INVALID;
+  else
+    check->verdict = matchesClaim(check) && check->missed_ticks == 0
+                         ? REPLAY_VERIFIED
+                         : REPLAY_MISMATCH;
+  return check->verdict;
+}
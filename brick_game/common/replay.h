@@ -0,0 +1,194 @@
+#ifndef SRC_BRICK_GAME_COMMON_REPLAY_H_
+#define SRC_BRICK_GAME_COMMON_REPLAY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "engine.h"
+
+#define REPLAY_MAGIC "BGRP"
+#define REPLAY_INDEX_MAGIC "BGIX"
+#define REPLAY_VERSION 5
+#define REPLAY_GAME_MAX 16
+#define REPLAY_ADVANCE (-2)   // entry action for one stepGameClock()
+#define REPLAY_KEYFRAME (-3)  // entry action followed by a saved game
+#define REPLAY_END (-4)       // entry action closing the stream
+#define REPLAY_KEYFRAME_MAX 4096
+#define REPLAY_KEYFRAME_INTERVAL 1024  // entries between keyframes
+#define REPLAY_RECORD_ENV "BRICKGAME_RECORD"
+#define REPLAY_KEYFRAME_ENV "BRICKGAME_KEYFRAME_INTERVAL"
+#define REPLAY_TICK_SLACK 100  // ms an engine tick may run behind its timer
+
+// A session is fully determined by the game, its seed, the game clock at
+// creation, its auto-repeat rates and every call the engine made into it
+// afterwards. The file is
+// this header followed by one entry per call, each a varint of milliseconds
+// since the previous entry and a varint of (action + 4) << 1 | hold, so a
+// typical entry takes two bytes.
+//
+// Every keyframe_interval entries the recorder also saves the whole game as
+// a keyframe entry followed by a varint size and the ops->save() blob. An
+// end entry closes the stream, and a footer locates the keyframe index
+// behind it, so a seek loads the nearest keyframe and replays only the
+// entries after it. A recording cut short has neither and still plays.
+//
+// The footer also carries the result the session claims: score, level and
+// lines of the last frame the player saw, and how many entries and game
+// milliseconds in it was taken. verifyReplay() plays the entries again and
+// checks the claim.
+typedef struct {
+  char magic[4];
+  uint16_t version;
+  uint16_t header_size;
+  char game[REPLAY_GAME_MAX];
+  uint64_t seed;
+  uint64_t start_millis;
+  uint32_t das_millis;  // auto-repeat rates the game was created with
+  uint32_t arr_millis;
+} ReplayHeader_t;
+
+typedef struct {
+  unsigned long long delta;  // game milliseconds since the previous entry
+  int action;  // UserAction_t, -1 for the empty action, or REPLAY_ADVANCE
+  bool hold;
+} ReplayEntry_t;
+
+typedef struct {
+  uint64_t entries;  // entries before the keyframe
+  uint64_t millis;   // game clock it was saved at
+  uint64_t offset;   // file offset of its entry
+} ReplayKeyframe_t;
+
+typedef struct {
+  uint64_t entries;  // entries applied when the frame was taken
+  uint64_t millis;   // game time since the start at that point
+  int32_t score;
+  int32_t level;
+  int32_t lines;
+  uint32_t present;  // 0 when the session never published a frame
+} ReplayClaim_t;
+
+typedef struct {
+  uint64_t index_offset;
+  ReplayClaim_t claim;
+  uint32_t keyframes;
+  char magic[4];
+} ReplayFooter_t;
+
+typedef struct {
+  FILE *file;
+  const EngineOps_t *ops;
+  void *game;
+  unsigned long long start_millis;
+  unsigned long long last_millis;
+  unsigned long long entries;
+  unsigned long long keyframe_interval;  // 0 records no keyframes
+  ReplayKeyframe_t *keyframes;
+  size_t keyframe_count;
+  size_t keyframe_capacity;
+  void *blob;
+  ReplayClaim_t claim;
+} ReplayRecorder_t;
+
+bool startReplayRecording(ReplayRecorder_t *recorder, const char *path,
+                          const EngineOps_t *ops, void *game, uint64_t seed,
+                          unsigned long long start_millis,
+                          unsigned long long keyframe_interval);
+// millis is the game clock the call ran at.
+void recordReplayEntry(ReplayRecorder_t *recorder, unsigned long long millis,
+                       int action, bool hold);
+// Takes the frame as the session's result so far; the last one taken before
+// the recording stops goes into the footer.
+void claimReplayResult(ReplayRecorder_t *recorder, const Frame_t *frame);
+void stopReplayRecording(ReplayRecorder_t *recorder);
+
+bool writeReplayEntry(FILE *file, const ReplayEntry_t *entry);
+// False at the end of the stream, including a truncated last entry.
+bool readReplayEntry(FILE *file, ReplayEntry_t *entry);
+
+// Plays a recording back through a fresh game on the calling thread, on a
+// virtual clock that only moves with the replay. The score stores stay
+// suspended during every call, so playback never touches the records.
+typedef struct {
+  FILE *file;
+  ReplayHeader_t header;
+  const EngineOps_t *ops;
+  void *game;
+  unsigned long long clock;  // virtual game clock
+  ReplayEntry_t next;
+  bool finished;
+  unsigned long long entries;  // applied so far
+  ReplayKeyframe_t *keyframes;
+  size_t keyframe_count;
+  void *blob;
+  ReplayClaim_t claim;  // from the footer, zeroed without one
+  // When the game asked to be stepped again, NO_TIMEOUT if it did not, and
+  // how many of those times went by without an advance entry.
+  unsigned long long deadline;
+  unsigned long long missed_ticks;
+} ReplayPlayer_t;
+
+// Reads the header and the claim without creating a game; the claim is zeroed
+// when the recording was cut short. Fails on anything but a replay.
+bool peekReplay(const char *path, ReplayHeader_t *header, ReplayClaim_t *claim);
+
+// Fails when the file is not a replay of the game behind ops.
+bool openReplay(ReplayPlayer_t *player, const char *path,
+                const EngineOps_t *ops);
+void closeReplay(ReplayPlayer_t *player);
+// Moves the virtual clock millis forward, applying every entry due on the
+// way. Returns the number of entries applied.
+unsigned long long advanceReplay(ReplayPlayer_t *player,
+                                 unsigned long long millis);
+// Applies everything that is left back to back, at full CPU speed.
+unsigned long long fastForwardReplay(ReplayPlayer_t *player);
+// Applies the next count entries back to back; player->next is the entry
+// due next. Returns the number applied, fewer at the end of the stream.
+unsigned long long playReplayEntries(ReplayPlayer_t *player,
+                                     unsigned long long count);
+// Moves playback to millis after the start, forwards or backwards, from the
+// nearest keyframe at or before it. Without a usable keyframe a seek
+// backwards replays from the start. Returns the number of entries replayed.
+unsigned long long seekReplay(ReplayPlayer_t *player,
+                              unsigned long long millis);
+unsigned long long replayElapsed(const ReplayPlayer_t *player);
+void fillReplayFrame(ReplayPlayer_t *player, Frame_t *frame);
+
+typedef enum {
+  REPLAY_VERIFIED,   // the replay reaches the claimed result
+  REPLAY_MISMATCH,   // it reaches something else, or skips game ticks
+  REPLAY_UNCLAIMED,  // it plays, but claims nothing to check
+  REPLAY_INVALID     // not a replay of this game, or cut short of its claim
+} ReplayVerdict_t;
+
+typedef struct {
+  ReplayVerdict_t verdict;
+  ReplayClaim_t claim;
+  int score;  // reached at the claimed entry
+  int level;
+  int lines;
+  unsigned long long entries;  // replayed in total
+  unsigned long long millis;   // game time covered
+  unsigned long long missed_ticks;  // before the claimed entry
+} ReplayCheck_t;
+
+// Replays the whole file through a fresh game on the calling thread at full
+// CPU speed and compares the frame at the claimed entry with the claim.
+// Gravity only runs on advance entries, so the claimed part must also step
+// the game the way the engine thread does: right after inputs and whenever
+// the time left returned by the last step runs out, an advance entry follows
+// within REPLAY_TICK_SLACK ms. A replay with ticks left out is a mismatch.
+// Thread-safe as long as each thread drives its own games.
+ReplayVerdict_t verifyReplay(const char *path, const EngineOps_t *ops,
+                             ReplayCheck_t *check);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_REPLAY_H_
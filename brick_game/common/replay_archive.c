@@ -0,0 +1,246 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "replay_archive.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "clock.h"
+#include "metrics.h"
+
+#define RECORD_COLUMNS \
+  "id, game, score, level, lines, duration, recorded, seed, size"
+
+static const char *const SCHEMA =
+    "CREATE TABLE IF NOT EXISTS replays ("
+    "id INTEGER PRIMARY KEY,"
+    "game TEXT NOT NULL,"
+    "score INTEGER NOT NULL,"
+    "level INTEGER NOT NULL,"
+    "lines INTEGER NOT NULL,"
+    "duration INTEGER NOT NULL,"
+    "recorded INTEGER NOT NULL,"
+    "seed INTEGER NOT NULL,"
+    "size INTEGER NOT NULL);"
+    "CREATE TABLE IF NOT EXISTS replay_payloads ("
+    "id INTEGER PRIMARY KEY,"
+    "payload BLOB NOT NULL);"
+    "CREATE INDEX IF NOT EXISTS replays_by_score "
+    "ON replays (game, score DESC);"
+    "CREATE INDEX IF NOT EXISTS replays_by_date "
+    "ON replays (game, recorded);";
+
+static const char *const STATEMENTS[ARCHIVE_STMTS] = {
+    [ARCHIVE_STMT_INSERT] =
+        "INSERT INTO replays (game, score, level, lines, duration, recorded, "
+        "seed, size) VALUES (?, ?, ?, ?, ?, ?, ?, ?);",
+    [ARCHIVE_STMT_INSERT_PAYLOAD] =
+        "INSERT INTO replay_payloads (id, payload) VALUES (?, zeroblob(?));",
+    [ARCHIVE_STMT_TOP] = "SELECT " RECORD_COLUMNS
+                         " FROM replays WHERE game = ? "
+                         "ORDER BY score DESC LIMIT ?;",
+    [ARCHIVE_STMT_RANGE] = "SELECT " RECORD_COLUMNS
+                           " FROM replays WHERE game = ? "
+                           "AND recorded BETWEEN ? AND ? ORDER BY recorded;",
+    [ARCHIVE_STMT_BEGIN] = "BEGIN IMMEDIATE;",
+    [ARCHIVE_STMT_COMMIT] = "COMMIT;",
+    [ARCHIVE_STMT_ROLLBACK] = "ROLLBACK;",
+};
+
+// Runs a statement that returns no rows and leaves it reset.
+static int run(ReplayArchive_t *archive, ArchiveStatement_t statement) {
+  sqlite3_stmt *stmt = archive->statements[statement];
+  unsigned long long start = monotonicNanos();
+  int rc = sqlite3_step(stmt);
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+  recordMetricLatency(METRIC_DB_LATENCY, monotonicNanos() - start);
+  addMetricCounter(METRIC_DB_OPS, 1);
+  return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+int openReplayArchive(ReplayArchive_t *archive, const char *path) {
+  if (archive->db) return SQLITE_OK;
+  memset(archive, 0, sizeof(*archive));
+
+  int rc = sqlite3_open(path, &archive->db);
+  if (rc == SQLITE_OK) {
+    sqlite3_busy_timeout(archive->db, REPLAY_ARCHIVE_BUSY_TIMEOUT_MS);
+    rc = sqlite3_exec(archive->db,
+                      "PRAGMA journal_mode=WAL;"
+                      "PRAGMA synchronous=NORMAL;",
+                      NULL, NULL, NULL);
+  }
+  if (rc == SQLITE_OK) rc = sqlite3_exec(archive->db, SCHEMA, NULL, NULL, NULL);
+  for (int i = 0; rc == SQLITE_OK && i < ARCHIVE_STMTS; i++) {
+    rc = sqlite3_prepare_v3(archive->db, STATEMENTS[i], -1,
+                            SQLITE_PREPARE_PERSISTENT, &archive->statements[i],
+                            NULL);
+  }
+  if (rc != SQLITE_OK) closeReplayArchive(archive);
+  return rc;
+}
+
+void closeReplayArchive(ReplayArchive_t *archive) {
+  for (int i = 0; i < ARCHIVE_STMTS; i++)
+    sqlite3_finalize(archive->statements[i]);
+  if (archive->db) sqlite3_close(archive->db);
+  memset(archive, 0, sizeof(*archive));
+}
+
+static int insertRecord(ReplayArchive_t *archive, const ReplayHeader_t *header,
+                        const ReplayClaim_t *claim, long long recorded,
+                        long long size) {
+  sqlite3_stmt *stmt = archive->statements[ARCHIVE_STMT_INSERT];
+  sqlite3_bind_text(stmt, 1, header->game,
+                    (int)strnlen(header->game, REPLAY_GAME_MAX),
+                    SQLITE_TRANSIENT);
+  sqlite3_bind_int(stmt, 2, claim->score);
+  sqlite3_bind_int(stmt, 3, claim->level);
+  sqlite3_bind_int(stmt, 4, claim->lines);
+  sqlite3_bind_int64(stmt, 5, (sqlite3_int64)claim->millis);
+  sqlite3_bind_int64(stmt, 6, recorded);
+  // The seed is stored bit for bit; SQLite integers are signed.
+  sqlite3_bind_int64(stmt, 7, (sqlite3_int64)header->seed);
+  sqlite3_bind_int64(stmt, 8, size);
+  return run(archive, ARCHIVE_STMT_INSERT);
+}
+
+// Reserves the payload as a zeroblob and fills it in chunks, so the whole
+// file never sits in memory.
+static int writePayload(ReplayArchive_t *archive, long long id, FILE *file,
+                        long long size) {
+  sqlite3_stmt *stmt = archive->statements[ARCHIVE_STMT_INSERT_PAYLOAD];
+  sqlite3_bind_int64(stmt, 1, id);
+  sqlite3_bind_int64(stmt, 2, size);
+  int rc = run(archive, ARCHIVE_STMT_INSERT_PAYLOAD);
+  if (rc != SQLITE_OK) return rc;
+
+  sqlite3_blob *blob;
+  rc = sqlite3_blob_open(archive->db, "main", "replay_payloads", "payload", id,
+                         1, &blob);
+  if (rc != SQLITE_OK) return rc;
+  unsigned char chunk[REPLAY_ARCHIVE_CHUNK];
+  long long offset = 0;
+  while (rc == SQLITE_OK && offset < size) {
+    size_t read = fread(chunk, 1, sizeof(chunk), file);
+    if (read == 0) {
+      rc = SQLITE_IOERR;
+    } else {
+      rc = sqlite3_blob_write(blob, chunk, (int)read, (int)offset);
+      offset += (long long)read;
+    }
+  }
+  int closed = sqlite3_blob_close(blob);
+  return rc == SQLITE_OK ? closed : rc;
+}
+
+int archiveReplay(ReplayArchive_t *archive, const char *path,
+                  long long recorded, long long *id) {
+  if (!archive->db) return SQLITE_MISUSE;
+  ReplayHeader_t header;
+  ReplayClaim_t claim;
+  if (!peekReplay(path, &header, &claim)) return SQLITE_FORMAT;
+  FILE *file = fopen(path, "rb");
+  if (!file) return SQLITE_CANTOPEN;
+  fseek(file, 0, SEEK_END);
+  long long size = ftell(file);
+  rewind(file);
+
+  int rc = run(archive, ARCHIVE_STMT_BEGIN);
+  if (rc == SQLITE_OK) {
+    rc = insertRecord(archive, &header, &claim, recorded, size);
+    long long row = sqlite3_last_insert_rowid(archive->db);
+    if (rc == SQLITE_OK) rc = writePayload(archive, row, file, size);
+    if (rc == SQLITE_OK) rc = run(archive, ARCHIVE_STMT_COMMIT);
+    if (rc != SQLITE_OK) {
+      run(archive, ARCHIVE_STMT_ROLLBACK);
+    } else if (id) {
+      *id = row;
+    }
+  }
+  fclose(file);
+  return rc;
+}
+
+int extractReplay(ReplayArchive_t *archive, long long id, const char *path) {
+  if (!archive->db) return SQLITE_MISUSE;
+  sqlite3_blob *blob;
+  int rc = sqlite3_blob_open(archive->db, "main", "replay_payloads", "payload",
+                             id, 0, &blob);
+  if (rc != SQLITE_OK) return rc;
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    sqlite3_blob_close(blob);
+    return SQLITE_CANTOPEN;
+  }
+
+  unsigned char chunk[REPLAY_ARCHIVE_CHUNK];
+  int size = sqlite3_blob_bytes(blob);
+  for (int offset = 0; rc == SQLITE_OK && offset < size;) {
+    int length = size - offset < (int)sizeof(chunk) ? size - offset
+                                                    : (int)sizeof(chunk);
+    rc = sqlite3_blob_read(blob, chunk, length, offset);
+    if (rc == SQLITE_OK && fwrite(chunk, 1, (size_t)length, file) !=
+                               (size_t)length)
+      rc = SQLITE_IOERR;
+    offset += length;
+  }
+  sqlite3_blob_close(blob);
+  if (fclose(file) != 0 && rc == SQLITE_OK) rc = SQLITE_IOERR;
+  return rc;
+}
+
+static void readRecord(sqlite3_stmt *stmt, ReplayRecord_t *record) {
+  memset(record, 0, sizeof(*record));
+  record->id = sqlite3_column_int64(stmt, 0);
+  const unsigned char *game = sqlite3_column_text(stmt, 1);
+  if (game) strncpy(record->game, (const char *)game, REPLAY_GAME_MAX - 1);
+  record->score = sqlite3_column_int(stmt, 2);
+  record->level = sqlite3_column_int(stmt, 3);
+  record->lines = sqlite3_column_int(stmt, 4);
+  record->duration = (unsigned long long)sqlite3_column_int64(stmt, 5);
+  record->recorded = sqlite3_column_int64(stmt, 6);
+  record->seed = (unsigned long long)sqlite3_column_int64(stmt, 7);
+  record->size = sqlite3_column_int64(stmt, 8);
+}
+
+// Steps a bound query to the end or until the visitor stops it.
+static int visitRows(ReplayArchive_t *archive, ArchiveStatement_t statement,
+                     ReplayRecordVisitor_t visit, void *context) {
+  sqlite3_stmt *stmt = archive->statements[statement];
+  unsigned long long start = monotonicNanos();
+  ReplayRecord_t record;
+  int rc;
+  while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    readRecord(stmt, &record);
+    if (!visit(&record, context)) {
+      rc = SQLITE_DONE;
+      break;
+    }
+  }
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+  recordMetricLatency(METRIC_DB_LATENCY, monotonicNanos() - start);
+  addMetricCounter(METRIC_DB_OPS, 1);
+  return rc == SQLITE_DONE ? SQLITE_OK : rc;
+}
+
+int topReplays(ReplayArchive_t *archive, const char *game, int limit,
+               ReplayRecordVisitor_t visit, void *context) {
+  if (!archive->db) return SQLITE_MISUSE;
+  sqlite3_stmt *stmt = archive->statements[ARCHIVE_STMT_TOP];
+  sqlite3_bind_text(stmt, 1, game, -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int(stmt, 2, limit);
+  return visitRows(archive, ARCHIVE_STMT_TOP, visit, context);
+}
+
+int replaysBetween(ReplayArchive_t *archive, const char *game, long long from,
+                   long long to, ReplayRecordVisitor_t visit, void *context) {
+  if (!archive->db) return SQLITE_MISUSE;
+  sqlite3_stmt *stmt = archive->statements[ARCHIVE_STMT_RANGE];
+  sqlite3_bind_text(stmt, 1, game, -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 2, from);
+  sqlite3_bind_int64(stmt, 3, to);
+  return visitRows(archive, ARCHIVE_STMT_RANGE, visit, context);
+}
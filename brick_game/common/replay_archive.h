@@ -0,0 +1,77 @@
+#ifndef SRC_BRICK_GAME_COMMON_REPLAY_ARCHIVE_H_
+#define SRC_BRICK_GAME_COMMON_REPLAY_ARCHIVE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sqlite3.h>
+#include <stdbool.h>
+
+#include "replay.h"
+
+#define REPLAY_ARCHIVE_BUSY_TIMEOUT_MS 250
+#define REPLAY_ARCHIVE_CHUNK 16384  // bytes per incremental BLOB read/write
+
+typedef enum {
+  ARCHIVE_STMT_INSERT,
+  ARCHIVE_STMT_INSERT_PAYLOAD,
+  ARCHIVE_STMT_TOP,
+  ARCHIVE_STMT_RANGE,
+  ARCHIVE_STMT_BEGIN,
+  ARCHIVE_STMT_COMMIT,
+  ARCHIVE_STMT_ROLLBACK,
+  ARCHIVE_STMTS
+} ArchiveStatement_t;
+
+// Replays with their metadata, one row in `replays` per session. The payload
+// lives in its own table, `replay_payloads`, under the same id, so metadata
+// rows stay a few dozen bytes and queries over millions of them never read a
+// payload page. Payloads are streamed in and out REPLAY_ARCHIVE_CHUNK bytes at
+// a time through SQLite's incremental BLOB I/O, so neither side holds a whole
+// replay in memory. The connection is tuned like the score store: WAL,
+// synchronous=NORMAL and statements prepared once.
+typedef struct {
+  sqlite3 *db;
+  sqlite3_stmt *statements[ARCHIVE_STMTS];
+} ReplayArchive_t;
+
+typedef struct {
+  long long id;
+  char game[REPLAY_GAME_MAX];
+  int score;
+  int level;
+  int lines;
+  unsigned long long duration;  // game milliseconds up to the claim
+  long long recorded;           // Unix time, seconds
+  unsigned long long seed;
+  long long size;  // payload bytes
+} ReplayRecord_t;
+
+// Called once per row; returning false stops the query.
+typedef bool (*ReplayRecordVisitor_t)(const ReplayRecord_t *record,
+                                      void *context);
+
+// All functions return an SQLite result code.
+int openReplayArchive(ReplayArchive_t *archive, const char *path);
+void closeReplayArchive(ReplayArchive_t *archive);
+
+// Copies the replay file into the archive in one transaction. Game and seed
+// come from its header, score, level, lines and duration from its claim.
+int archiveReplay(ReplayArchive_t *archive, const char *path,
+                  long long recorded, long long *id);
+// Writes the payload stored under id back out as a replay file.
+int extractReplay(ReplayArchive_t *archive, long long id, const char *path);
+
+// Metadata only, served by the (game, score) and (game, recorded) indexes.
+int topReplays(ReplayArchive_t *archive, const char *game, int limit,
+               ReplayRecordVisitor_t visit, void *context);
+// Replays recorded in [from, to], oldest first.
+int replaysBetween(ReplayArchive_t *archive, const char *game, long long from,
+                   long long to, ReplayRecordVisitor_t visit, void *context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_REPLAY_ARCHIVE_H_
@@ -0,0 +1,22 @@
+#include "rng.h"
+
+void seedRng(Rng_t *rng, uint64_t seed) {
+  uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  z ^= z >> 31;
+  rng->state = z ? z : 0x9E3779B97F4A7C15ULL;
+}
+
+uint32_t nextRandom(Rng_t *rng) {
+  uint64_t x = rng->state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  rng->state = x;
+  return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+int randomBelow(Rng_t *rng, int bound) {
+  return (int)(((uint64_t)nextRandom(rng) * (uint64_t)bound) >> 32);
+}
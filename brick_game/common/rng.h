@@ -0,0 +1,26 @@
+#ifndef SRC_BRICK_GAME_COMMON_RNG_H_
+#define SRC_BRICK_GAME_COMMON_RNG_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+// Per-game random source, so a session is a function of its seed and its
+// inputs and nothing else in the process can shift the sequence.
+// xorshift64*, with the seed spread by splitmix64.
+typedef struct {
+  uint64_t state;
+} Rng_t;
+
+void seedRng(Rng_t *rng, uint64_t seed);
+uint32_t nextRandom(Rng_t *rng);
+// Uniform enough for bounds this small: 0 <= result < bound.
+int randomBelow(Rng_t *rng, int bound);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_RNG_H_
@@ -0,0 +1,230 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "rollback.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "score_store.h"
+
+#define WINDOW_MASK (ROLLBACK_WINDOW - 1)
+#define PACKET_HEADER offsetof(RollbackPacket_t, inputs)
+
+static const RollbackInput_t NO_INPUT = {-1, 0};
+
+// Simulation runs on the session's virtual clock with the score stores and
+// event dumps held off, as replays do: neither board is a record.
+static void enterSession(RollbackSession_t *session) {
+  setGameClock(&session->clock);
+  suspendScoreStores(true);
+  suspendEventDumps(true);
+}
+
+static void leaveSession(void) {
+  suspendEventDumps(false);
+  suspendScoreStores(false);
+  setGameClock(NULL);
+}
+
+static bool sameInput(RollbackInput_t a, RollbackInput_t b) {
+  return a.action == b.action && a.hold == b.hold;
+}
+
+// The input the remote board runs with at tick: the real one once known,
+// otherwise a held key keeps repeating and anything else is not.
+static RollbackInput_t remoteInput(const RollbackSession_t *session,
+                                   uint32_t tick) {
+  uint32_t slot = tick & WINDOW_MASK;
+  if (session->known[slot] == tick + 1) return session->remote_inputs[slot];
+  return session->last_confirmed.hold ? session->last_confirmed : NO_INPUT;
+}
+
+static void applyInput(RollbackSession_t *session, void *game,
+                       RollbackInput_t input) {
+  if (input.action >= 0)
+    session->ops->input(game, (UserAction_t)input.action, input.hold != 0);
+  stepGameClock(session->ops, game);
+}
+
+static void setTickClock(RollbackSession_t *session, uint32_t tick) {
+  session->clock = session->start_millis +
+                   (unsigned long long)(tick + 1) * ROLLBACK_TICK_MILLIS;
+}
+
+static bool saveRemote(RollbackSession_t *session, uint32_t tick) {
+  uint32_t slot = tick & WINDOW_MASK;
+  session->snapshot_sizes[slot] =
+      session->ops->save(session->games[1 - session->local],
+                         session->snapshots[slot], ROLLBACK_SNAPSHOT_MAX);
+  return session->snapshot_sizes[slot] != 0;
+}
+
+bool startRollbackSession(RollbackSession_t *session, const EngineOps_t *ops,
+                          int local, unsigned long long seed,
+                          unsigned long long start_millis) {
+  memset(session, 0, sizeof(*session));
+  if (!ops->save || !ops->load || local < 0 || local >= ROLLBACK_PLAYERS)
+    return false;
+  session->ops = ops;
+  session->local = local;
+  session->start_millis = start_millis;
+  session->clock = start_millis;
+  session->rollback_from = UINT32_MAX;
+  session->last_confirmed = NO_INPUT;
+
+  enterSession(session);
+  for (int player = 0; player < ROLLBACK_PLAYERS; player++) {
+    session->games[player] = ops->create();
+    ops->seed(session->games[player], seed);
+  }
+  // Both boards start the same, so a game too big to snapshot fails here.
+  bool ok = saveRemote(session, 0);
+  leaveSession();
+  if (!ok) stopRollbackSession(session);
+  return ok;
+}
+
+void stopRollbackSession(RollbackSession_t *session) {
+  if (session->ops) {
+    enterSession(session);
+    for (int player = 0; player < ROLLBACK_PLAYERS; player++) {
+      if (session->games[player]) session->ops->destroy(session->games[player]);
+    }
+    leaveSession();
+  }
+  memset(session, 0, sizeof(*session));
+}
+
+bool advanceRollback(RollbackSession_t *session, RollbackInput_t input) {
+  // The remote player may be the one ahead, with confirmed past tick.
+  if (session->tick >= session->confirmed + ROLLBACK_MAX_TICKS) {
+    session->stats.stalls++;
+    return false;
+  }
+  uint32_t tick = session->tick;
+  uint32_t slot = tick & WINDOW_MASK;
+  RollbackInput_t remote = remoteInput(session, tick);
+  session->local_inputs[slot] = input;
+  session->simulated[slot] = remote;
+
+  enterSession(session);
+  saveRemote(session, tick);
+  setTickClock(session, tick);
+  applyInput(session, session->games[session->local], input);
+  applyInput(session, session->games[1 - session->local], remote);
+  leaveSession();
+  session->tick++;
+  return true;
+}
+
+void addRemoteInput(RollbackSession_t *session, uint32_t tick,
+                    RollbackInput_t input) {
+  if (tick < session->confirmed ||
+      tick - session->confirmed >= ROLLBACK_WINDOW)
+    return;
+  uint32_t slot = tick & WINDOW_MASK;
+  if (session->known[slot] == tick + 1) return;
+  session->remote_inputs[slot] = input;
+  session->known[slot] = tick + 1;
+
+  if (tick < session->tick && !sameInput(session->simulated[slot], input) &&
+      tick < session->rollback_from)
+    session->rollback_from = tick;
+  while (session->known[session->confirmed & WINDOW_MASK] ==
+         session->confirmed + 1) {
+    session->last_confirmed =
+        session->remote_inputs[session->confirmed & WINDOW_MASK];
+    session->confirmed++;
+  }
+}
+
+uint32_t reconcileRollback(RollbackSession_t *session) {
+  uint32_t from = session->rollback_from;
+  if (from == UINT32_MAX) return 0;
+  session->rollback_from = UINT32_MAX;
+  unsigned long long start = monotonicNanos();
+  void *remote = session->games[1 - session->local];
+
+  // The snapshot taken before the first wrong tick is still good; every one
+  // after it is taken again on the way back up.
+  enterSession(session);
+  uint32_t slot = from & WINDOW_MASK;
+  session->ops->load(remote, session->snapshots[slot],
+                     session->snapshot_sizes[slot]);
+  for (uint32_t tick = from; tick < session->tick; tick++) {
+    if (tick != from) saveRemote(session, tick);
+    RollbackInput_t input = remoteInput(session, tick);
+    session->simulated[tick & WINDOW_MASK] = input;
+    setTickClock(session, tick);
+    applyInput(session, remote, input);
+  }
+  leaveSession();
+
+  uint32_t ticks = session->tick - from;
+  session->stats.rollbacks++;
+  session->stats.resimulated += ticks;
+  if (ticks > session->stats.deepest) session->stats.deepest = ticks;
+  session->stats.rollback_nanos += monotonicNanos() - start;
+  return ticks;
+}
+
+void fillRollbackFrame(RollbackSession_t *session, int player, Frame_t *frame) {
+  enterSession(session);
+  session->ops->fill(session->games[player], frame);
+  leaveSession();
+}
+
+bool openRollbackLink(int fds[2]) {
+  if (socketpair(AF_UNIX, SOCK_DGRAM, 0, fds) != 0) return false;
+  for (int i = 0; i < 2; i++) {
+    int flags = fcntl(fds[i], F_GETFL);
+    if (flags < 0 || fcntl(fds[i], F_SETFL, flags | O_NONBLOCK) != 0) {
+      close(fds[0]);
+      close(fds[1]);
+      return false;
+    }
+  }
+  return true;
+}
+
+void fillRollbackPacket(const RollbackSession_t *session,
+                        RollbackPacket_t *packet) {
+  uint32_t first = session->acked;
+  if (session->tick - first > ROLLBACK_WINDOW)
+    first = session->tick - ROLLBACK_WINDOW;
+  packet->first = first;
+  packet->ack = session->confirmed;
+  packet->count = session->tick - first;
+  for (uint32_t i = 0; i < packet->count; i++)
+    packet->inputs[i] = session->local_inputs[(first + i) & WINDOW_MASK];
+}
+
+void applyRollbackPacket(RollbackSession_t *session,
+                         const RollbackPacket_t *packet) {
+  for (uint32_t i = 0; i < packet->count && i < ROLLBACK_WINDOW; i++)
+    addRemoteInput(session, packet->first + i, packet->inputs[i]);
+  // Acknowledgements only move forward, and never past what was sent.
+  if (packet->ack > session->acked && packet->ack <= session->tick)
+    session->acked = packet->ack;
+}
+
+bool sendRollbackInputs(const RollbackSession_t *session, int fd) {
+  RollbackPacket_t packet;
+  fillRollbackPacket(session, &packet);
+  size_t size = PACKET_HEADER + packet.count * sizeof(packet.inputs[0]);
+  return send(fd, &packet, size, 0) == (ssize_t)size;
+}
+
+uint32_t receiveRollbackInputs(RollbackSession_t *session, int fd) {
+  RollbackPacket_t packet;
+  ssize_t size;
+  while ((size = recv(fd, &packet, sizeof(packet), 0)) >= 0) {
+    // Anything but a whole packet is dropped like a lost one.
+    if ((size_t)size >= PACKET_HEADER && packet.count <= ROLLBACK_WINDOW &&
+        (size_t)size == PACKET_HEADER + packet.count * sizeof(packet.inputs[0]))
+      applyRollbackPacket(session, &packet);
+  }
+  return reconcileRollback(session);
+}
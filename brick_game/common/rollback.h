@@ -0,0 +1,116 @@
+#ifndef SRC_BRICK_GAME_COMMON_ROLLBACK_H_
+#define SRC_BRICK_GAME_COMMON_ROLLBACK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "engine.h"
+
+#define ROLLBACK_PLAYERS 2
+#define ROLLBACK_MAX_TICKS 10       // furthest a peer runs ahead of the other
+#define ROLLBACK_WINDOW 32          // ticks of inputs and snapshots kept
+#define ROLLBACK_SNAPSHOT_MAX 1024  // bytes of ops->save() per game
+#define ROLLBACK_TICK_MILLIS 16     // game time per tick, about 60 Hz
+
+// Two-player versus with rollback: both peers run both boards from the same
+// seed on a fixed tick, the local one from local inputs and the remote one
+// from the remote player's inputs as they arrive. An input that has not
+// arrived by its tick is predicted: the last one repeated while its key is
+// held, nothing otherwise. The remote board is saved before every tick, so
+// when an input turns out to differ from its prediction the board is loaded
+// as it was at that tick and re-simulated up to the present, all within the
+// current frame. The boards never interact, so the local one is never rolled
+// back.
+//
+// Needs a game whose create() returns independent instances with a save() of
+// at most ROLLBACK_SNAPSHOT_MAX bytes; Tetris keeps one game per thread and
+// so cannot hold both boards. A session and its games belong to the thread
+// that started it.
+typedef struct {
+  int8_t action;  // UserAction_t, -1 for none
+  uint8_t hold;
+} RollbackInput_t;
+
+typedef struct {
+  uint64_t rollbacks;       // mispredictions corrected
+  uint64_t resimulated;     // ticks simulated again because of them
+  uint32_t deepest;         // most ticks re-simulated at once
+  uint64_t stalls;          // advances refused for running too far ahead
+  uint64_t rollback_nanos;  // time spent loading and re-simulating
+} RollbackStats_t;
+
+typedef struct {
+  const EngineOps_t *ops;
+  void *games[ROLLBACK_PLAYERS];
+  int local;
+  unsigned long long start_millis;
+  unsigned long long clock;  // virtual game clock, shared by both boards
+  uint32_t tick;             // ticks simulated so far
+  uint32_t confirmed;        // remote inputs known for every tick below this
+  uint32_t acked;            // local inputs the remote peer has confirmed
+  uint32_t rollback_from;    // earliest misprediction, UINT32_MAX for none
+  RollbackInput_t local_inputs[ROLLBACK_WINDOW];
+  // Remote inputs by tick: the one received, when known[] holds tick + 1,
+  // and the one the board was simulated with.
+  RollbackInput_t remote_inputs[ROLLBACK_WINDOW];
+  uint32_t known[ROLLBACK_WINDOW];
+  RollbackInput_t simulated[ROLLBACK_WINDOW];
+  RollbackInput_t last_confirmed;
+  unsigned char snapshots[ROLLBACK_WINDOW][ROLLBACK_SNAPSHOT_MAX];
+  size_t snapshot_sizes[ROLLBACK_WINDOW];
+  RollbackStats_t stats;
+} RollbackSession_t;
+
+// local is the index of this peer's player, 0 or 1. Both peers pass the same
+// seed and start_millis. Fails when ops cannot save and load its games.
+bool startRollbackSession(RollbackSession_t *session, const EngineOps_t *ops,
+                          int local, unsigned long long seed,
+                          unsigned long long start_millis);
+void stopRollbackSession(RollbackSession_t *session);
+
+// Runs the next tick on both boards with the given local input. Returns false
+// and simulates nothing while the session is ROLLBACK_MAX_TICKS ahead of the
+// remote inputs; the caller keeps receiving and tries again.
+bool advanceRollback(RollbackSession_t *session, RollbackInput_t input);
+// Takes the remote player's input for a tick. Inputs already known or beyond
+// the window are ignored. A misprediction is corrected by the next
+// reconcileRollback().
+void addRemoteInput(RollbackSession_t *session, uint32_t tick,
+                    RollbackInput_t input);
+// Rolls the remote board back to the earliest misprediction and simulates it
+// up to the present again. Returns the number of ticks re-simulated.
+uint32_t reconcileRollback(RollbackSession_t *session);
+
+void fillRollbackFrame(RollbackSession_t *session, int player, Frame_t *frame);
+
+// Every local input the remote peer has not acknowledged yet, so a lost
+// datagram is covered by the next one. Host byte order; the link is local.
+typedef struct {
+  uint32_t first;  // tick of inputs[0]
+  uint32_t ack;    // remote inputs confirmed by the sender
+  uint32_t count;
+  RollbackInput_t inputs[ROLLBACK_WINDOW];
+} RollbackPacket_t;
+
+// A connected pair of non-blocking local datagram sockets, one per peer.
+bool openRollbackLink(int fds[2]);
+void fillRollbackPacket(const RollbackSession_t *session,
+                        RollbackPacket_t *packet);
+// Takes the inputs and the acknowledgement a packet carries.
+void applyRollbackPacket(RollbackSession_t *session,
+                         const RollbackPacket_t *packet);
+bool sendRollbackInputs(const RollbackSession_t *session, int fd);
+// Drains every datagram waiting on fd, then reconciles. Returns the number
+// of ticks re-simulated.
+uint32_t receiveRollbackInputs(RollbackSession_t *session, int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_ROLLBACK_H_
@@ -0,0 +1,137 @@
+#include "score_store.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "clock.h"
+#include "metrics.h"
+
+#define SCORE_SQL_MAX 256
+
+static _Thread_local bool suspended = false;
+
+void suspendScoreStores(bool suspend) { suspended = suspend; }
+
+static int execute(sqlite3 *db, const char *sql) {
+  int rc = sqlite3_exec(db, sql, NULL, NULL, NULL);
+  addMetricCounter(METRIC_DB_OPS, 1);
+  return rc;
+}
+
+// Steps a cached statement once and leaves it reset, so no read transaction
+// stays open between calls and holds back WAL checkpoints.
+static int step(ScoreStore_t *store, ScoreStatement_t statement, int *row) {
+  sqlite3_stmt *stmt = store->statements[statement];
+  unsigned long long start = monotonicNanos();
+  int rc = sqlite3_step(stmt);
+  if (rc == SQLITE_ROW && row) *row = sqlite3_column_int(stmt, 0);
+  sqlite3_reset(stmt);
+  recordMetricLatency(METRIC_DB_LATENCY, monotonicNanos() - start);
+  addMetricCounter(METRIC_DB_OPS, 1);
+
+  if (rc == SQLITE_ROW || rc == SQLITE_DONE) return SQLITE_OK;
+  if (store->batch_depth > 0) store->batch_failed = true;
+  return rc;
+}
+
+static int prepare(ScoreStore_t *store, ScoreStatement_t statement,
+                   const char *sql) {
+  return sqlite3_prepare_v3(store->db, sql, -1, SQLITE_PREPARE_PERSISTENT,
+                            &store->statements[statement], NULL);
+}
+
+static int createTable(sqlite3 *db, const char *table) {
+  char sql[SCORE_SQL_MAX];
+  snprintf(sql, sizeof(sql),
+           "CREATE TABLE IF NOT EXISTS %s ("
+           "id INTEGER PRIMARY KEY,"
+           "value INTEGER NOT NULL);"
+           "INSERT OR IGNORE INTO %s (id, value) VALUES (1, 0);",
+           table, table);
+  return execute(db, sql);
+}
+
+static int prepareStatements(ScoreStore_t *store, const char *table) {
+  char read[SCORE_SQL_MAX], write[SCORE_SQL_MAX];
+  snprintf(read, sizeof(read), "SELECT value FROM %s WHERE id = 1;", table);
+  snprintf(write, sizeof(write),
+           "INSERT OR REPLACE INTO %s (id, value) VALUES (1, ?);", table);
+
+  int rc = prepare(store, SCORE_STMT_READ, read);
+  if (rc != SQLITE_OK) {
+    // Only a fresh file lacks the table; an existing one skips the DDL.
+    rc = createTable(store->db, table);
+    if (rc == SQLITE_OK) rc = prepare(store, SCORE_STMT_READ, read);
+  }
+  if (rc == SQLITE_OK) rc = prepare(store, SCORE_STMT_WRITE, write);
+  if (rc == SQLITE_OK) rc = prepare(store, SCORE_STMT_BEGIN, "BEGIN IMMEDIATE;");
+  if (rc == SQLITE_OK) rc = prepare(store, SCORE_STMT_COMMIT, "COMMIT;");
+  if (rc == SQLITE_OK) rc = prepare(store, SCORE_STMT_ROLLBACK, "ROLLBACK;");
+  return rc;
+}
+
+int openScoreStore(ScoreStore_t *store, const char *path, const char *table) {
+  if (store->db) return SQLITE_OK;
+  if (suspended) return SQLITE_CANTOPEN;
+  memset(store, 0, sizeof(*store));
+
+  int rc = sqlite3_open(path, &store->db);
+  if (rc == SQLITE_OK) {
+    sqlite3_busy_timeout(store->db, SCORE_STORE_BUSY_TIMEOUT_MS);
+    rc = execute(store->db,
+                 "PRAGMA journal_mode=WAL;"
+                 "PRAGMA synchronous=NORMAL;");
+  }
+  if (rc == SQLITE_OK) rc = prepareStatements(store, table);
+  if (rc != SQLITE_OK) closeScoreStore(store);
+  return rc;
+}
+
+void closeScoreStore(ScoreStore_t *store) {
+  for (int i = 0; i < SCORE_STMTS; i++) sqlite3_finalize(store->statements[i]);
+  // A batch still open at this point is rolled back by the close.
+  if (store->db) sqlite3_close(store->db);
+  memset(store, 0, sizeof(*store));
+}
+
+bool isScoreStoreOpen(const ScoreStore_t *store) { return store->db != NULL; }
+
+int readScore(ScoreStore_t *store, int *score) {
+  if (!store->db) return SQLITE_MISUSE;
+  *score = 0;
+  return step(store, SCORE_STMT_READ, score);
+}
+
+int writeScore(ScoreStore_t *store, int score) {
+  if (!store->db) return SQLITE_MISUSE;
+  if (suspended) return SQLITE_READONLY;
+  int rc = sqlite3_bind_int(store->statements[SCORE_STMT_WRITE], 1, score);
+  if (rc != SQLITE_OK) return rc;
+  return step(store, SCORE_STMT_WRITE, NULL);
+}
+
+int beginScoreBatch(ScoreStore_t *store) {
+  if (!store->db) return SQLITE_MISUSE;
+  if (store->batch_depth++ > 0) return SQLITE_OK;
+
+  store->batch_failed = false;
+  int rc = step(store, SCORE_STMT_BEGIN, NULL);
+  // Without the transaction the statements still run, one commit each.
+  if (rc != SQLITE_OK) store->batch_failed = true;
+  return rc;
+}
+
+int commitScoreBatch(ScoreStore_t *store) {
+  if (!store->db || store->batch_depth == 0) return SQLITE_MISUSE;
+  if (--store->batch_depth > 0) return SQLITE_OK;
+  if (sqlite3_get_autocommit(store->db))
+    return store->batch_failed ? SQLITE_ABORT : SQLITE_OK;
+
+  if (store->batch_failed) {
+    step(store, SCORE_STMT_ROLLBACK, NULL);
+    return SQLITE_ABORT;
+  }
+  int rc = step(store, SCORE_STMT_COMMIT, NULL);
+  if (rc != SQLITE_OK) step(store, SCORE_STMT_ROLLBACK, NULL);
+  return rc;
+}
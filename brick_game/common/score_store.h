@@ -0,0 +1,57 @@
+#ifndef SRC_BRICK_GAME_COMMON_SCORE_STORE_H_
+#define SRC_BRICK_GAME_COMMON_SCORE_STORE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <sqlite3.h>
+#include <stdbool.h>
+
+#define SCORE_STORE_BUSY_TIMEOUT_MS 250
+
+typedef enum {
+  SCORE_STMT_READ,
+  SCORE_STMT_WRITE,
+  SCORE_STMT_BEGIN,
+  SCORE_STMT_COMMIT,
+  SCORE_STMT_ROLLBACK,
+  SCORE_STMTS
+} ScoreStatement_t;
+
+// One high-score row in its own table. The connection runs in WAL mode with
+// synchronous=NORMAL, so a commit appends to the log without an fsync and
+// only checkpoints sync. Statements are prepared once when the store opens
+// and live as long as the connection. Every statement counts towards
+// METRIC_DB_OPS and its duration goes to METRIC_DB_LATENCY.
+typedef struct {
+  sqlite3 *db;
+  sqlite3_stmt *statements[SCORE_STMTS];
+  int batch_depth;
+  bool batch_failed;
+} ScoreStore_t;
+
+// All functions return an SQLite result code. Opening an open store is a
+// no-op; the table is created only when the file does not have it yet.
+int openScoreStore(ScoreStore_t *store, const char *path, const char *table);
+void closeScoreStore(ScoreStore_t *store);
+bool isScoreStoreOpen(const ScoreStore_t *store);
+
+int readScore(ScoreStore_t *store, int *score);
+int writeScore(ScoreStore_t *store, int score);
+
+// Groups the statements up to the matching commit in one write transaction.
+// Batches nest; only the outermost commit reaches the database, and it rolls
+// back instead if any statement inside failed.
+int beginScoreBatch(ScoreStore_t *store);
+int commitScoreBatch(ScoreStore_t *store);
+
+// While suspended, stores used from the calling thread neither open nor
+// write, so replayed sessions leave the records alone.
+void suspendScoreStores(bool suspended);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_SCORE_STORE_H_
@@ -0,0 +1,32 @@
+#include "seqlock.h"
+
+#include <string.h>
+
+void initFrameSeqlock(FrameSeqlock_t *lock) {
+  memset(&lock->frame, 0, sizeof(lock->frame));
+  __atomic_store_n(&lock->sequence, 0, __ATOMIC_RELEASE);
+}
+
+void publishFrame(FrameSeqlock_t *lock, const Frame_t *frame) {
+  unsigned sequence = __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED);
+
+  // An odd sequence marks the frame as being written.
+  __atomic_store_n(&lock->sequence, sequence + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(&lock->frame, frame, sizeof(*frame));
+  __atomic_store_n(&lock->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+unsigned long long readPublishedFrame(const FrameSeqlock_t *lock,
+                                      Frame_t *frame) {
+  unsigned before, after;
+  do {
+    before = __atomic_load_n(&lock->sequence, __ATOMIC_ACQUIRE);
+    if (before & 1u) continue;
+    memcpy(frame, &lock->frame, sizeof(*frame));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    after = __atomic_load_n(&lock->sequence, __ATOMIC_RELAXED);
+    if (before == after) break;
+  } while (1);
+  return frame->frame_id;
+}
@@ -0,0 +1,26 @@
+#ifndef SRC_BRICK_GAME_COMMON_SEQLOCK_H_
+#define SRC_BRICK_GAME_COMMON_SEQLOCK_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "frame.h"
+
+// Single-writer frame publication. Readers never block the writer and never
+// allocate: they copy the frame and retry if a write overlapped the copy.
+typedef struct {
+  unsigned sequence;
+  Frame_t frame;
+} FrameSeqlock_t;
+
+void initFrameSeqlock(FrameSeqlock_t *lock);
+void publishFrame(FrameSeqlock_t *lock, const Frame_t *frame);
+unsigned long long readPublishedFrame(const FrameSeqlock_t *lock,
+                                      Frame_t *frame);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_SEQLOCK_H_
@@ -0,0 +1,251 @@
+#include "spectator.h"
+
+#include <string.h>
+
+#define KIND_KEYFRAME 0
+#define KIND_DELTA 1
+
+static uint8_t *putVarint(uint8_t *out, uint64_t value) {
+  do {
+    *out = (uint8_t)(value & 0x7F);
+    value >>= 7;
+    if (value) *out |= 0x80;
+    out++;
+  } while (value);
+  return out;
+}
+
+static bool getVarint(const uint8_t **in, const uint8_t *end,
+                      uint64_t *value) {
+  *value = 0;
+  for (int shift = 0; shift < 64 && *in < end; shift += 7) {
+    uint8_t byte = *(*in)++;
+    *value |= (uint64_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+  return false;
+}
+
+static uint64_t zigzag(int value) {
+  return ((uint64_t)(uint32_t)value << 1) ^ (uint64_t)(int64_t)(value >> 31);
+}
+
+static int unzigzag(uint64_t value) {
+  return (int)(uint32_t)((value >> 1) ^ (~(value & 1) + 1));
+}
+
+static void gatherCells(GameInfo_t info, int *cells) {
+  memset(cells, 0, SPECTATOR_CELLS * sizeof(int));
+  for (int row = 0; info.field && row < FIELD_H; row++)
+    memcpy(cells + row * FIELD_W, info.field[row], FIELD_W * sizeof(int));
+  int *next = cells + FIELD_H * FIELD_W;
+  for (int row = 0; info.next && row < NEXT_H; row++)
+    memcpy(next + row * NEXT_W, info.next[row], NEXT_W * sizeof(int));
+}
+
+void startSpectatorEncoder(SpectatorEncoder_t *encoder,
+                           uint32_t keyframe_interval) {
+  memset(encoder, 0, sizeof(*encoder));
+  encoder->keyframe_interval = keyframe_interval;
+  encoder->keyframe_due = true;
+}
+
+void requestSpectatorKeyframe(SpectatorEncoder_t *encoder) {
+  encoder->keyframe_due = true;
+}
+
+// The XOR against the previous cells, as alternating runs of unchanged and
+// changed cells. The previous cells become the current ones on the way.
+static uint8_t *putCells(uint8_t *out, int *previous, const int *cells) {
+  int i = 0;
+  while (i < SPECTATOR_CELLS) {
+    int start = i;
+    while (i < SPECTATOR_CELLS && previous[i] == cells[i]) i++;
+    out = putVarint(out, (uint64_t)(i - start));
+    if (i == SPECTATOR_CELLS) break;
+
+    start = i;
+    while (i < SPECTATOR_CELLS && previous[i] != cells[i]) i++;
+    out = putVarint(out, (uint64_t)(i - start));
+    for (int j = start; j < i; j++) {
+      out = putVarint(out, zigzag(previous[j] ^ cells[j]));
+      previous[j] = cells[j];
+    }
+  }
+  return out;
+}
+
+size_t encodeSpectatorFrame(SpectatorEncoder_t *encoder, GameInfo_t info,
+                            uint8_t *out) {
+  int cells[SPECTATOR_CELLS];
+  gatherCells(info, cells);
+  const int scalars[SPECTATOR_SCALARS] = {info.score, info.high_score,
+                                          info.level, info.speed, info.pause};
+
+  if (encoder->keyframe_interval &&
+      encoder->since_keyframe >= encoder->keyframe_interval)
+    encoder->keyframe_due = true;
+  bool keyframe = encoder->keyframe_due;
+  if (keyframe) {
+    memset(encoder->cells, 0, sizeof(encoder->cells));
+    encoder->keyframe_due = false;
+    encoder->since_keyframe = 0;
+  }
+  encoder->since_keyframe++;
+
+  // The body goes after room for the longest size, then moves up to it.
+  uint8_t *body = out + SPECTATOR_SIZE_MAX;
+  uint8_t *cursor = body;
+  *cursor++ = keyframe ? KIND_KEYFRAME : KIND_DELTA;
+  if (keyframe)
+    cursor = putVarint(cursor, encoder->sequence);
+  else
+    *cursor++ = (uint8_t)encoder->sequence;
+  encoder->sequence++;
+  uint8_t *mask = cursor++;
+  *mask = 0;
+  for (int i = 0; i < SPECTATOR_SCALARS; i++) {
+    if (!keyframe && scalars[i] == encoder->scalars[i]) continue;
+    *mask |= (uint8_t)(1 << i);
+    cursor = putVarint(cursor, zigzag(scalars[i]));
+    encoder->scalars[i] = scalars[i];
+  }
+  cursor = putCells(cursor, encoder->cells, cells);
+
+  size_t size = (size_t)(cursor - body);
+  size_t prefix = (size_t)(putVarint(out, size) - out);
+  memmove(out + prefix, body, size);
+  return prefix + size;
+}
+
+void startSpectatorDecoder(SpectatorDecoder_t *decoder) {
+  memset(decoder, 0, sizeof(*decoder));
+}
+
+static void setScalar(Frame_t *frame, int index, int value) {
+  int *scalars[SPECTATOR_SCALARS] = {&frame->score, &frame->high_score,
+                                     &frame->level, &frame->speed,
+                                     &frame->pause};
+  *scalars[index] = value;
+}
+
+// Applies the body to a copy, so a corrupt one leaves the frame alone.
+static bool applyBody(SpectatorDecoder_t *decoder, const uint8_t *in,
+                      const uint8_t *end, int kind, uint32_t sequence) {
+  Frame_t frame = decoder->frame;
+  if (kind == KIND_KEYFRAME) memset(&frame, 0, sizeof(frame));
+  if (in == end) return false;
+  uint8_t mask = *in++;
+  if (mask >> SPECTATOR_SCALARS) return false;
+  for (int i = 0; i < SPECTATOR_SCALARS; i++) {
+    uint64_t value;
+    if (!(mask & (1 << i))) continue;
+    if (!getVarint(&in, end, &value)) return false;
+    setScalar(&frame, i, unzigzag(value));
+  }
+
+  int *cells = &frame.field[0][0];
+  int *next = &frame.next[0][0];
+  uint64_t i = 0;
+  while (i < SPECTATOR_CELLS) {
+    uint64_t run;
+    if (!getVarint(&in, end, &run) || run > SPECTATOR_CELLS - i) return false;
+    i += run;
+    if (i == SPECTATOR_CELLS) break;
+    if (!getVarint(&in, end, &run) || run == 0 || run > SPECTATOR_CELLS - i)
+      return false;
+    for (; run > 0; run--, i++) {
+      uint64_t value;
+      if (!getVarint(&in, end, &value)) return false;
+      int *cell = i < FIELD_H * FIELD_W ? cells + i
+                                        : next + (i - FIELD_H * FIELD_W);
+      *cell ^= unzigzag(value);
+    }
+  }
+  if (in != end) return false;
+
+  frame.frame_id = sequence;
+  decoder->frame = frame;
+  return true;
+}
+
+SpectatorResult_t decodeSpectatorMessage(SpectatorDecoder_t *decoder,
+                                         const uint8_t *data, size_t size,
+                                         size_t *used) {
+  *used = 0;
+  const uint8_t *in = data;
+  size_t head = size < SPECTATOR_SIZE_MAX ? size : SPECTATOR_SIZE_MAX;
+  uint64_t length;
+  if (!getVarint(&in, data + head, &length)) {
+    if (size < SPECTATOR_SIZE_MAX) return SPECTATOR_PARTIAL;
+    length = 0;
+  }
+  if (length == 0 || length > SPECTATOR_MESSAGE_MAX - SPECTATOR_SIZE_MAX) {
+    *used = size;
+    decoder->synced = false;
+    return SPECTATOR_CORRUPT;
+  }
+  if ((size_t)(data + size - in) < length) return SPECTATOR_PARTIAL;
+  const uint8_t *end = in + length;
+  *used = (size_t)(end - data);
+
+  int kind = *in++;
+  uint64_t sequence;
+  if (kind == KIND_KEYFRAME) {
+    if (!getVarint(&in, end, &sequence) || sequence > UINT32_MAX) {
+      decoder->synced = false;
+      return SPECTATOR_CORRUPT;
+    }
+  } else if (kind == KIND_DELTA && in < end) {
+    // Deltas carry the low byte: enough to notice one went missing.
+    sequence = decoder->sequence + 1;
+    if (!decoder->synced || *in++ != (uint8_t)sequence) {
+      decoder->synced = false;
+      decoder->skipped++;
+      return SPECTATOR_SKIPPED;
+    }
+  } else {
+    decoder->synced = false;
+    return SPECTATOR_CORRUPT;
+  }
+  if (!applyBody(decoder, in, end, kind, (uint32_t)sequence)) {
+    decoder->synced = false;
+    return SPECTATOR_CORRUPT;
+  }
+
+  decoder->sequence = (uint32_t)sequence;
+  decoder->synced = true;
+  if (kind == KIND_KEYFRAME)
+    decoder->keyframes++;
+  else
+    decoder->deltas++;
+  return SPECTATOR_FRAME;
+}
+
+bool startSpectatorStream(SpectatorStream_t *stream, const char *path,
+                          uint32_t keyframe_interval) {
+  memset(stream, 0, sizeof(*stream));
+  stream->file = fopen(path, "wb");
+  if (!stream->file) return false;
+  startSpectatorEncoder(&stream->encoder, keyframe_interval);
+  return true;
+}
+
+bool writeSpectatorFrame(SpectatorStream_t *stream, Frame_t *frame) {
+  if (!stream->file) return false;
+  uint8_t message[SPECTATOR_MESSAGE_MAX];
+  int *field_rows[FIELD_H];
+  int *next_rows[NEXT_H];
+  size_t size = encodeSpectatorFrame(
+      &stream->encoder, frameToGameInfo(frame, field_rows, next_rows),
+      message);
+  stream->frames++;
+  stream->bytes += size;
+  return fwrite(message, 1, size, stream->file) == size &&
+         fflush(stream->file) == 0;
+}
+
+void stopSpectatorStream(SpectatorStream_t *stream) {
+  if (stream->file) fclose(stream->file);
+  memset(stream, 0, sizeof(*stream));
+}
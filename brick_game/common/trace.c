@@ -0,0 +1,151 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock.h"
+
+#define TRACE_INSTANT ((unsigned long long)-1)
+#define TRACE_PATH_MAX 4096
+
+typedef struct {
+  const char *name;
+  unsigned long long start;
+  unsigned long long duration;  // TRACE_INSTANT for instant events
+} TraceEvent_t;
+
+typedef struct TraceBuffer {
+  struct TraceBuffer *next;
+  const char *thread_name;
+  int tid;
+  unsigned long long written;
+  TraceEvent_t events[TRACE_BUFFER_EVENTS];
+} TraceBuffer_t;
+
+static int enabled = -1;  // -1 until the environment has been read
+static char trace_path[TRACE_PATH_MAX];
+static TraceBuffer_t *buffers = NULL;
+static int next_tid = 0;
+static _Thread_local TraceBuffer_t *thread_buffer = NULL;
+
+static void writeTraceAtExit(void) { stopTracing(); }
+
+bool tracingEnabled(void) {
+  int value = __atomic_load_n(&enabled, __ATOMIC_RELAXED);
+  if (value < 0) {
+    const char *path = getenv("BRICKGAME_TRACE");
+    value = path != NULL && *path != '\0' && startTracing(path);
+    if (!value) __atomic_store_n(&enabled, 0, __ATOMIC_RELAXED);
+  }
+  return value;
+}
+
+bool startTracing(const char *path) {
+  if (strlen(path) >= TRACE_PATH_MAX) return false;
+
+  static bool exit_hook = false;
+  if (!exit_hook) exit_hook = atexit(writeTraceAtExit) == 0;
+
+  strcpy(trace_path, path);
+  for (TraceBuffer_t *buffer = __atomic_load_n(&buffers, __ATOMIC_ACQUIRE);
+       buffer; buffer = buffer->next) {
+    buffer->written = 0;
+  }
+  __atomic_store_n(&enabled, 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+static TraceBuffer_t *getThreadBuffer(void) {
+  if (thread_buffer) return thread_buffer;
+
+  TraceBuffer_t *buffer = calloc(1, sizeof(TraceBuffer_t));
+  if (!buffer) return NULL;
+  buffer->tid = __atomic_add_fetch(&next_tid, 1, __ATOMIC_RELAXED);
+  buffer->next = __atomic_load_n(&buffers, __ATOMIC_RELAXED);
+  while (!__atomic_compare_exchange_n(&buffers, &buffer->next, buffer, true,
+                                      __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+  }
+  thread_buffer = buffer;
+  return buffer;
+}
+
+static void recordEvent(const char *name, unsigned long long start,
+                        unsigned long long duration) {
+  TraceBuffer_t *buffer = getThreadBuffer();
+  if (!buffer) return;
+  TraceEvent_t *event =
+      &buffer->events[buffer->written % TRACE_BUFFER_EVENTS];
+  event->name = name;
+  event->start = start;
+  event->duration = duration;
+  __atomic_store_n(&buffer->written, buffer->written + 1, __ATOMIC_RELEASE);
+}
+
+void setTraceThreadName(const char *name) {
+  if (!tracingEnabled()) return;
+  TraceBuffer_t *buffer = getThreadBuffer();
+  if (buffer) buffer->thread_name = name;
+}
+
+void beginTraceSpan(TraceSpan_t *span, const char *name) {
+  span->name = NULL;
+  if (!tracingEnabled()) return;
+  span->name = name;
+  span->start = monotonicNanos();
+}
+
+void endTraceSpan(const TraceSpan_t *span) {
+  if (!span->name) return;
+  recordEvent(span->name, span->start, monotonicNanos() - span->start);
+}
+
+void traceInstant(const char *name) {
+  if (!tracingEnabled()) return;
+  recordEvent(name, monotonicNanos(), TRACE_INSTANT);
+}
+
+static void writeEvent(FILE *out, const TraceBuffer_t *buffer,
+                       const TraceEvent_t *event, bool *first) {
+  fprintf(out, "%s\n{\"name\":\"%s\",\"pid\":1,\"tid\":%d,\"ts\":%.3f",
+          *first ? "" : ",", event->name, buffer->tid,
+          event->start / 1000.0);
+  if (event->duration == TRACE_INSTANT) {
+    fputs(",\"ph\":\"i\",\"s\":\"t\"}", out);
+  } else {
+    fprintf(out, ",\"ph\":\"X\",\"dur\":%.3f}", event->duration / 1000.0);
+  }
+  *first = false;
+}
+
+bool stopTracing(void) {
+  if (__atomic_load_n(&enabled, __ATOMIC_RELAXED) != 1) return true;
+  __atomic_store_n(&enabled, 0, __ATOMIC_RELAXED);
+
+  FILE *out = fopen(trace_path, "w");
+  if (!out) return false;
+
+  bool first = true;
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", out);
+  for (TraceBuffer_t *buffer = __atomic_load_n(&buffers, __ATOMIC_ACQUIRE);
+       buffer; buffer = buffer->next) {
+    if (buffer->thread_name) {
+      fprintf(out,
+              "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+              "\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+              first ? "" : ",", buffer->tid, buffer->thread_name);
+      first = false;
+    }
+    unsigned long long written =
+        __atomic_load_n(&buffer->written, __ATOMIC_ACQUIRE);
+    unsigned long long oldest =
+        written > TRACE_BUFFER_EVENTS ? written - TRACE_BUFFER_EVENTS : 0;
+    for (unsigned long long i = oldest; i < written; i++) {
+      writeEvent(out, buffer, &buffer->events[i % TRACE_BUFFER_EVENTS],
+                 &first);
+    }
+    buffer->written = 0;
+  }
+  fputs("\n]}\n", out);
+  return fclose(out) == 0;
+}
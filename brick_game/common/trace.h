@@ -0,0 +1,37 @@
+#ifndef SRC_BRICK_GAME_COMMON_TRACE_H_
+#define SRC_BRICK_GAME_COMMON_TRACE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#define TRACE_BUFFER_EVENTS 65536
+
+// Timeline of scoped spans in Chrome trace-event format, for Perfetto or
+// chrome://tracing. Off unless BRICKGAME_TRACE names an output file, in
+// which case the trace is written at exit. Every thread records into its own
+// ring of the latest TRACE_BUFFER_EVENTS events, without locks. Names must
+// be string literals: only the pointer is stored.
+typedef struct {
+  const char *name;
+  unsigned long long start;
+} TraceSpan_t;
+
+bool tracingEnabled(void);
+bool startTracing(const char *path);
+// Writes the trace and turns tracing off. Call once the traced threads are
+// idle; returns false if the file could not be written.
+bool stopTracing(void);
+
+void setTraceThreadName(const char *name);
+void beginTraceSpan(TraceSpan_t *span, const char *name);
+void endTraceSpan(const TraceSpan_t *span);
+void traceInstant(const char *name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_TRACE_H_
@@ -0,0 +1,35 @@
+#include "triple_buffer.h"
+
+#include <string.h>
+
+#define FRESH_BIT 4u
+#define INDEX_MASK 3u
+
+void initTripleBuffer(TripleBuffer_t *buffer) {
+  memset(buffer->buffers, 0, sizeof(buffer->buffers));
+  buffer->back = 0;
+  buffer->front = 2;
+  __atomic_store_n(&buffer->middle, 1u, __ATOMIC_RELEASE);
+}
+
+Frame_t *getBackFrame(TripleBuffer_t *buffer) {
+  return &buffer->buffers[buffer->back];
+}
+
+void swapBackFrame(TripleBuffer_t *buffer) {
+  unsigned previous = __atomic_exchange_n(
+      &buffer->middle, buffer->back | FRESH_BIT, __ATOMIC_ACQ_REL);
+  buffer->back = previous & INDEX_MASK;
+}
+
+Frame_t *getFrontFrame(TripleBuffer_t *buffer, bool *fresh) {
+  bool swapped = false;
+  if (__atomic_load_n(&buffer->middle, __ATOMIC_ACQUIRE) & FRESH_BIT) {
+    unsigned previous =
+        __atomic_exchange_n(&buffer->middle, buffer->front, __ATOMIC_ACQ_REL);
+    buffer->front = previous & INDEX_MASK;
+    swapped = true;
+  }
+  if (fresh) *fresh = swapped;
+  return &buffer->buffers[buffer->front];
+}
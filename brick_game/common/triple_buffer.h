@@ -0,0 +1,37 @@
+#ifndef SRC_BRICK_GAME_COMMON_TRIPLE_BUFFER_H_
+#define SRC_BRICK_GAME_COMMON_TRIPLE_BUFFER_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "frame.h"
+
+// One writer and one reader exchange whole frames without copying and
+// without ever waiting on each other. The writer always has a private back
+// buffer, the reader always has a private front buffer, and the middle one
+// is swapped atomically.
+typedef struct {
+  Frame_t buffers[3];
+  unsigned middle;
+  unsigned back;
+  unsigned front;
+} TripleBuffer_t;
+
+void initTripleBuffer(TripleBuffer_t *buffer);
+
+// Writer side.
+Frame_t *getBackFrame(TripleBuffer_t *buffer);
+void swapBackFrame(TripleBuffer_t *buffer);
+
+// Reader side. Returns the newest completed frame; sets *fresh when it was
+// not returned before.
+Frame_t *getFrontFrame(TripleBuffer_t *buffer, bool *fresh);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_COMMON_TRIPLE_BUFFER_H_
@@ -1,5 +1,7 @@
 #include "controller.h"
 
+#include <cstring>
+
 namespace brickgame {
 
 Controller::Controller() : model_(std::make_unique<SnakeModel>()) {}
@@ -35,4 +37,117 @@ void Controller::freeGameInfo(GameInfo_t* info) {
   }
 }
 
-}  // namespace brickgame
\ No newline at end of file
+void Controller::fillFrame(Frame_t* frame) { model_->fillFrame(frame); }
+
+void Controller::seed(unsigned long long seed) { model_->seed(seed); }
+
+Controller::Snapshot Controller::snapshot() const {
+  return model_->snapshot();
+}
+
+void Controller::restore(const Snapshot& snapshot) {
+  model_->restore(snapshot);
+}
+
+const EventRing_t* Controller::events() const { return model_->events(); }
+
+void Controller::repeatRates(int* das, int* arr) const {
+  model_->repeatRates(das, arr);
+}
+
+void Controller::setRepeatRates(int das, int arr) {
+  model_->setRepeatRates(das, arr);
+}
+
+}  // namespace brickgame
+
+namespace {
+
+void* createGame() { return new brickgame::Controller(); }
+
+void seedGame(void* game, unsigned long long seed) {
+  static_cast<brickgame::Controller*>(game)->seed(seed);
+}
+
+void destroyGame(void* game) {
+  delete static_cast<brickgame::Controller*>(game);
+}
+
+void gameInput(void* game, UserAction_t action, bool hold) {
+  static_cast<brickgame::Controller*>(game)->userInput(action, hold);
+}
+
+unsigned long long gameTick(void* game) {
+  return static_cast<brickgame::Controller*>(game)->processTimer();
+}
+
+void gameFill(void* game, Frame_t* frame) {
+  static_cast<brickgame::Controller*>(game)->fillFrame(frame);
+}
+
+using Snapshot = brickgame::Controller::Snapshot;
+
+size_t saveGame(void* game, void* buffer, size_t capacity) {
+  if (capacity < sizeof(Snapshot)) return 0;
+  Snapshot snapshot = static_cast<brickgame::Controller*>(game)->snapshot();
+  std::memcpy(buffer, &snapshot, sizeof(snapshot));
+  return sizeof(snapshot);
+}
+
+bool validDirection(brickgame::SnakeModel::Direction_t direction) {
+  using Direction_t = brickgame::SnakeModel::Direction_t;
+  int value = static_cast<int>(direction);
+  return value >= static_cast<int>(Direction_t::UP) &&
+         value <= static_cast<int>(Direction_t::RIGHT);
+}
+
+// A blob from a replay file has to hold a state the game can reach: the
+// body outside the menu and the game over screen has a head for move() to
+// read, and the enums, speeds and auto-repeat are in range.
+bool validSnapshot(const Snapshot& snapshot) {
+  using State_t = brickgame::SnakeFSM::State_t;
+  const int body = sizeof(snapshot.body) / sizeof(snapshot.body[0]);
+  int state = static_cast<int>(snapshot.state);
+  if (state < static_cast<int>(State_t::INITIAL) ||
+      state > static_cast<int>(State_t::WIN))
+    return false;
+  bool headless = snapshot.state == State_t::INITIAL ||
+                  snapshot.state == State_t::GAME_OVER;
+  return snapshot.length >= (headless ? 0 : 1) && snapshot.length <= body &&
+         validDirection(snapshot.current_direction) &&
+         validDirection(snapshot.next_direction) &&
+         snapshot.base_speed > 0 && snapshot.current_speed > 0 &&
+         validAutoRepeat(&snapshot.auto_repeat);
+}
+
+bool loadGame(void* game, const void* buffer, size_t size) {
+  if (size != sizeof(Snapshot)) return false;
+  Snapshot snapshot;
+  std::memcpy(&snapshot, buffer, sizeof(snapshot));
+  if (!validSnapshot(snapshot)) return false;
+  static_cast<brickgame::Controller*>(game)->restore(snapshot);
+  return true;
+}
+
+const EventRing_t* gameEvents(void* game) {
+  return static_cast<brickgame::Controller*>(game)->events();
+}
+
+void gameRepeatRates(void* game, int* das, int* arr) {
+  static_cast<brickgame::Controller*>(game)->repeatRates(das, arr);
+}
+
+void setGameRepeatRates(void* game, int das, int arr) {
+  static_cast<brickgame::Controller*>(game)->setRepeatRates(das, arr);
+}
+
+}  // namespace
+
+extern "C" const EngineOps_t* getEngineOps(void) {
+  static const EngineOps_t ops = {"snake", createGame, seedGame,
+                                  destroyGame, gameInput, gameTick,
+                                  gameFill, saveGame, loadGame,
+                                  gameEvents, gameRepeatRates,
+                                  setGameRepeatRates};
+  return &ops;
+}
\ No newline at end of file
@@ -3,11 +3,14 @@
 
 #include <memory>
 
+#include "./../common/engine.h"
 #include "model.h"
 namespace brickgame {
 
 class Controller {
  public:
+  using Snapshot = SnakeModel::Snapshot;
+
   Controller();
   ~Controller();
 
@@ -15,6 +18,13 @@ class Controller {
   GameInfo_t updateCurrentState();
   unsigned long long processTimer();
   void freeGameInfo(GameInfo_t* info);
+  void fillFrame(Frame_t* frame);
+  void seed(unsigned long long seed);
+  Snapshot snapshot() const;
+  void restore(const Snapshot& snapshot);
+  const EventRing_t* events() const;
+  void repeatRates(int* das, int* arr) const;
+  void setRepeatRates(int das, int arr);
 
  private:
   std::unique_ptr<SnakeModel> model_;
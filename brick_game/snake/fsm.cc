@@ -1,5 +1,7 @@
 #include "fsm.h"
 
+#include "./../common/trace.h"
+
 namespace brickgame {
 
 SnakeFSM::SnakeFSM()
@@ -24,8 +26,11 @@ bool SnakeFSM::canTransitTo(State_t newState) const {
 }
 
 void SnakeFSM::transitTo(State_t newState) {
+  static const char* const STATE_NAMES[] = {"INITIAL", "SPAWN",     "MOVING",
+                                            "PAUSED",  "GAME_OVER", "WIN"};
   if (canTransitTo(newState)) {
     currentState_ = newState;
+    traceInstant(STATE_NAMES[static_cast<int>(newState)]);
   }
 }
 
@@ -35,5 +40,6 @@ void SnakeFSM::moving() { transitTo(State_t::MOVING); }
 void SnakeFSM::paused() { transitTo(State_t::PAUSED); }
 void SnakeFSM::gameOver() { transitTo(State_t::GAME_OVER); }
 void SnakeFSM::win() { transitTo(State_t::WIN); }
+void SnakeFSM::restore(State_t state) { currentState_ = state; }
 
 }  // namespace brickgame
\ No newline at end of file
@@ -21,6 +21,8 @@ class SnakeFSM {
   void paused();
   void gameOver();
   void win();
+  // Jumps straight to a saved state, bypassing the transition table.
+  void restore(State_t state);
 
  private:
   bool canTransitTo(State_t newState) const;
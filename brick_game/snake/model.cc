@@ -14,19 +14,36 @@ SnakeModel::SnakeModel()
       is_accelerated_(false),
       apple_x_(-1),
       apple_y_(-1),
-      db_(nullptr),
-      last_update_time_(std::chrono::steady_clock::now()) {
-  initDB();
-  high_score_ = getHighScoreFromDB();
+      store_(),
+      last_update_millis_(gameMillis()) {
+  snake_.reserve(MAX_SNAKE_LEN + 1);
+  initAutoRepeat(&auto_repeat_);
+  initEventRing(&events_, "snake");
+  seedRng(&rng_, monotonicNanos());
 }
 
 SnakeModel::~SnakeModel() {
-  saveMaxScore();
+  // Storage is opened by the first game; without one there is nothing to save.
+  if (isScoreStoreOpen(&store_)) saveMaxScore();
   closeDB();
+  releaseEventRing(&events_);
 }
 
 void SnakeModel::handleInput(UserAction_t action, bool hold) {
-  static_cast<void>(hold);
+  bool was_held = isInputHeld(&auto_repeat_, action);
+  if (!acceptHeldInput(&auto_repeat_, action, hold)) {
+    if (was_held && !hold && action == Action) resetAcceleration();
+    return;
+  }
+  TraceSpan_t span;
+  beginTraceSpan(&span, "userInput");
+  SnakeFSM::State_t previous = fsm_.getState();
+  applyInput(action);
+  noteTransition(previous);
+  endTraceSpan(&span);
+}
+
+void SnakeModel::applyInput(UserAction_t action) {
   SnakeFSM::State_t currentState = fsm_.getState();
 
   switch (action) {
@@ -35,6 +52,7 @@ void SnakeModel::handleInput(UserAction_t action, bool hold) {
           currentState == SnakeFSM::State_t::GAME_OVER ||
           currentState == SnakeFSM::State_t::WIN) {
         reset();
+        high_score_ = getHighScoreFromDB();
         spawnSnake();
       }
       break;
@@ -93,50 +111,95 @@ GameInfo_t SnakeModel::getGameInfo() {
 }
 
 unsigned long long SnakeModel::processTimer() {
-  if (fsm_.getState() == SnakeFSM::State_t::MOVING) {
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
-                       now - last_update_time_)
-                       .count();
-
-    if (elapsed >= current_speed_) {
-      move();
-      last_update_time_ = now;
-    }
+  TraceSpan_t span;
+  beginTraceSpan(&span, "processTimer");
+  SnakeFSM::State_t previous = fsm_.getState();
+  unsigned long long time_left = advance();
+  noteTransition(previous);
+  endTraceSpan(&span);
+  return time_left;
+}
+
+unsigned long long SnakeModel::advance() {
+  if (fsm_.getState() != SnakeFSM::State_t::MOVING) {
+    return static_cast<unsigned long long>(-1);
+  }
+
+  unsigned long long now = gameMillis();
+  long long elapsed = static_cast<long long>(now - last_update_millis_);
+
+  if (elapsed >= current_speed_) {
+    move();
+    last_update_millis_ = now;
+    elapsed = 0;
   }
 
-  return 0;
+  if (fsm_.getState() != SnakeFSM::State_t::MOVING) {
+    return static_cast<unsigned long long>(-1);
+  }
+  return static_cast<unsigned long long>(current_speed_ - elapsed);
+}
+
+void SnakeModel::noteTransition(SnakeFSM::State_t previous) {
+  SnakeFSM::State_t state = fsm_.getState();
+  if (state == previous) return;
+
+  emitGameEvent(&events_, EVENT_STATE_CHANGED, static_cast<int>(previous),
+                static_cast<int>(state), score_);
+  if (state == SnakeFSM::State_t::GAME_OVER ||
+      state == SnakeFSM::State_t::WIN) {
+    dumpEventRing(&events_);
+  }
 }
 
 void SnakeModel::update() { processTimer(); }
 
 int** SnakeModel::getField() const {
+  Frame_t frame;
+  fillFrame(&frame);
+
   int** field = new int*[FIELD_H];
   for (int i = 0; i < FIELD_H; ++i) {
-    field[i] = new int[FIELD_W]{0};
+    field[i] = new int[FIELD_W];
+    std::copy(frame.field[i], frame.field[i] + FIELD_W, field[i]);
   }
+  return field;
+}
+
+void SnakeModel::fillFrame(Frame_t* frame) const {
+  for (auto& row : frame->field) std::fill(row, row + FIELD_W, 0);
+  for (auto& row : frame->next) std::fill(row, row + NEXT_W, 0);
 
   // apple = 1
   if (apple_x_ >= 0 && apple_x_ < FIELD_H && apple_y_ >= 0 &&
       apple_y_ < FIELD_W) {
-    field[apple_x_][apple_y_] = 1;
+    frame->field[apple_x_][apple_y_] = 1;
   }
 
+  frame->focus_row = FIELD_H / 2;
+  frame->focus_col = FIELD_W / 2;
   if (!snake_.empty()) {
     // body = 2, head = 3
     for (const auto& segment : snake_) {
       if (segment.first >= 0 && segment.first < FIELD_H &&
           segment.second >= 0 && segment.second < FIELD_W) {
-        field[segment.first][segment.second] = 2;
+        frame->field[segment.first][segment.second] = 2;
       }
     }
     int head_x = snake_[0].first, head_y = snake_[0].second;
     if (head_x >= 0 && head_x < FIELD_H && head_y >= 0 && head_y < FIELD_W) {
-      field[head_x][head_y] = 3;
+      frame->field[head_x][head_y] = 3;
     }
+    frame->focus_row = head_x;
+    frame->focus_col = head_y;
   }
 
-  return field;
+  frame->score = score_;
+  frame->high_score = high_score_;
+  frame->level = level_;
+  frame->lines = 0;
+  frame->speed = base_speed_;
+  frame->pause = getPauseState();
 }
 
 int** SnakeModel::getNext() const {
@@ -183,6 +246,7 @@ void SnakeModel::spawnSnake() {
 void SnakeModel::move() {
   if (fsm_.getState() != SnakeFSM::State_t::MOVING) return;
 
+  advanceEventTick(&events_);
   current_direction_ = next_direction_;
   int head_x = snake_[0].first;
   int head_y = snake_[0].second;
@@ -205,10 +269,12 @@ void SnakeModel::move() {
   snake_.insert(snake_.begin(), {head_x, head_y});
   if (head_x == apple_x_ && head_y == apple_y_) {
     score_++;
+    emitGameEvent(&events_, EVENT_APPLE_EATEN, head_x, head_y, score_);
+    addMetricCounter(METRIC_APPLES_EATEN, 1);
     updateLevel();
     saveMaxScore();
     generateApple();
-    resetAcceleration();
+    if (!isInputHeld(&auto_repeat_, Action)) resetAcceleration();
   } else {
     snake_.pop_back();
   }
@@ -241,10 +307,67 @@ void SnakeModel::reset() {
   next_direction_ = Direction_t::UP;
   base_speed_ = INIT_SPEED;
   current_speed_ = base_speed_;
-  last_update_time_ = std::chrono::steady_clock::now();
+  last_update_millis_ = gameMillis();
   fsm_.initial();
 }
 
+void SnakeModel::seed(unsigned long long seed) { seedRng(&rng_, seed); }
+
+SnakeModel::Snapshot SnakeModel::snapshot() const {
+  Snapshot snapshot;
+  snapshot.state = fsm_.getState();
+  snapshot.current_direction = current_direction_;
+  snapshot.next_direction = next_direction_;
+  snapshot.is_accelerated = is_accelerated_;
+  snapshot.score = score_;
+  snapshot.high_score = high_score_;
+  snapshot.level = level_;
+  snapshot.base_speed = base_speed_;
+  snapshot.current_speed = current_speed_;
+  snapshot.apple_x = apple_x_;
+  snapshot.apple_y = apple_y_;
+  snapshot.auto_repeat = auto_repeat_;
+  snapshot.rng = rng_;
+  snapshot.last_update_millis = last_update_millis_;
+  snapshot.length = static_cast<int>(snake_.size());
+  for (int i = 0; i < snapshot.length; ++i) {
+    snapshot.body[i][0] = static_cast<int8_t>(snake_[i].first);
+    snapshot.body[i][1] = static_cast<int8_t>(snake_[i].second);
+  }
+  return snapshot;
+}
+
+void SnakeModel::restore(const Snapshot &snapshot) {
+  fsm_.restore(snapshot.state);
+  current_direction_ = snapshot.current_direction;
+  next_direction_ = snapshot.next_direction;
+  is_accelerated_ = snapshot.is_accelerated;
+  score_ = snapshot.score;
+  high_score_ = snapshot.high_score;
+  level_ = snapshot.level;
+  base_speed_ = snapshot.base_speed;
+  current_speed_ = snapshot.current_speed;
+  apple_x_ = snapshot.apple_x;
+  apple_y_ = snapshot.apple_y;
+  auto_repeat_ = snapshot.auto_repeat;
+  rng_ = snapshot.rng;
+  last_update_millis_ = snapshot.last_update_millis;
+  snake_.clear();
+  for (int i = 0; i < snapshot.length; ++i)
+    snake_.emplace_back(snapshot.body[i][0], snapshot.body[i][1]);
+}
+
+const EventRing_t *SnakeModel::events() const { return &events_; }
+
+void SnakeModel::repeatRates(int *das, int *arr) const {
+  *das = (int)auto_repeat_.das;
+  *arr = (int)auto_repeat_.arr;
+}
+
+void SnakeModel::setRepeatRates(int das, int arr) {
+  setAutoRepeatRates(&auto_repeat_, das, arr);
+}
+
 void SnakeModel::changeDirection(Direction_t new_direction) {
   if ((current_direction_ == Direction_t::UP &&
        new_direction != Direction_t::DOWN) ||
@@ -272,24 +395,28 @@ bool SnakeModel::checkCollision() const {
 }
 
 void SnakeModel::generateApple() {
-  std::vector<std::pair<int, int>> empty_cells;
-  for (int i = 0; i < FIELD_H; ++i) {
-    for (int j = 0; j < FIELD_W; ++j) {
-      bool is_empty = true;
-      for (const auto& segment : snake_) {
-        if (segment.first == i && segment.second == j) {
-          is_empty = false;
-          break;
-        }
-      }
-      if (is_empty) empty_cells.push_back({i, j});
+  bool occupied[FIELD_H][FIELD_W] = {};
+  int empty_cells = FIELD_H * FIELD_W;
+  for (const auto& segment : snake_) {
+    if (segment.first >= 0 && segment.first < FIELD_H &&
+        segment.second >= 0 && segment.second < FIELD_W &&
+        !occupied[segment.first][segment.second]) {
+      occupied[segment.first][segment.second] = true;
+      empty_cells--;
     }
   }
 
-  if (!empty_cells.empty()) {
-    int index = rand() % empty_cells.size();
-    apple_x_ = empty_cells[index].first;
-    apple_y_ = empty_cells[index].second;
+  if (empty_cells > 0) {
+    int index = randomBelow(&rng_, empty_cells);
+    for (int i = 0; i < FIELD_H; ++i) {
+      for (int j = 0; j < FIELD_W; ++j) {
+        if (!occupied[i][j] && index-- == 0) {
+          apple_x_ = i;
+          apple_y_ = j;
+          return;
+        }
+      }
+    }
   } else {
     fsm_.win();
     saveMaxScore();
@@ -317,61 +444,64 @@ void SnakeModel::updateLevel() {
     level_ = new_level;
     base_speed_ = INIT_SPEED - (level_ - 1) * SPEED_STEP;
     current_speed_ = base_speed_;
+    emitGameEvent(&events_, EVENT_LEVEL_UP, level_, 0, base_speed_);
   }
 }
 
 void SnakeModel::saveMaxScore() {
+  // Most calls do not set a record; the cached high score answers those
+  // without touching the store.
+  if (score_ <= high_score_) return;
+  PerfSample_t sample;
+  beginPerfSample(&sample);
+  unsigned long long start = monotonicNanos();
+  // Another process may have stored a higher score since it was cached, so
+  // the stored value is read again inside the batch before writing.
+  bool open = openDB();
+  if (open) beginScoreBatch(&store_);
   int high_score = getHighScoreFromDB();
-  if (score_ > high_score) {
-    saveHighScoreToDB(score_);
+  bool written = score_ > high_score && saveHighScoreToDB(score_) == 0;
+  if (open && commitScoreBatch(&store_) == SQLITE_OK && written) {
     high_score_ = score_;
+    emitGameEvent(&events_, EVENT_SCORE_PERSISTED, 0, 0, score_);
+  } else if (high_score > high_score_) {
+    high_score_ = high_score;
   }
+  recordMetricLatency(METRIC_PERSIST_LATENCY, monotonicNanos() - start);
+  endPerfSample(&sample, PERF_SITE_PERSIST);
 }
 
 int SnakeModel::initDB() {
-  int rc = sqlite3_open("snake.db", &db_);
-  if (rc) return -1;
-
-  const char* sql =
-      "CREATE TABLE IF NOT EXISTS snake_scores ("
-      "id INTEGER PRIMARY KEY,"
-      "value INTEGER NOT NULL);"
-      "INSERT OR IGNORE INTO snake_scores (id, value) VALUES (1, 0);";
-  char* err;
-  rc = sqlite3_exec(db_, sql, 0, 0, &err);
-  if (rc != SQLITE_OK) {
-    sqlite3_free(err);
-    return -1;
-  }
-  return 0;
+  int rc = openScoreStore(&store_, "snake.db", "snake_scores");
+  return rc == SQLITE_OK ? 0 : -1;
 }
 
-void SnakeModel::closeDB() {
-  if (db_) sqlite3_close(db_);
+// The store is opened on first use, off the first-frame path, and kept for
+// the life of the model.
+bool SnakeModel::openDB() {
+  initDB();
+  return isScoreStoreOpen(&store_);
 }
 
-int SnakeModel::getHighScoreFromDB() {
-  if (!db_) return 0;
-  sqlite3_stmt* stmt;
-  const char* sql = "SELECT value FROM snake_scores WHERE id = 1;";
-  if (sqlite3_prepare_v2(db_, sql, -1, &stmt, 0) != SQLITE_OK) return 0;
+void SnakeModel::closeDB() { closeScoreStore(&store_); }
 
+int SnakeModel::getHighScoreFromDB() {
+  if (!openDB()) return 0;
+  TraceSpan_t span;
+  beginTraceSpan(&span, "db read");
   int score = 0;
-  if (sqlite3_step(stmt) == SQLITE_ROW) {
-    score = sqlite3_column_int(stmt, 0);
-  }
-  sqlite3_finalize(stmt);
+  readScore(&store_, &score);
+  endTraceSpan(&span);
   return score;
 }
 
-void SnakeModel::saveHighScoreToDB(int score) {
-  if (!db_) return;
-  sqlite3_stmt* stmt;
-  const char* sql = "UPDATE snake_scores SET value = ? WHERE id = 1;";
-  sqlite3_prepare_v2(db_, sql, -1, &stmt, 0);
-  sqlite3_bind_int(stmt, 1, score);
-  sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+int SnakeModel::saveHighScoreToDB(int score) {
+  if (!openDB()) return -1;
+  TraceSpan_t span;
+  beginTraceSpan(&span, "db write");
+  int rc = writeScore(&store_, score);
+  endTraceSpan(&span);
+  return rc == SQLITE_OK ? 0 : -1;
 }
 
 }  // namespace brickgame
\ No newline at end of file
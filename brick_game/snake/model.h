@@ -1,12 +1,19 @@
 #ifndef SRC_BRICK_GAME_SNAKE_BACKEND_MODEL_H_
 #define SRC_BRICK_GAME_SNAKE_BACKEND_MODEL_H_
 
-#include <sqlite3.h>
-
-#include <chrono>
+#include <cstdint>
 #include <cstdlib>
 
 #include "./../../brick_game.h"
+#include "./../common/auto_repeat.h"
+#include "./../common/clock.h"
+#include "./../common/event_ring.h"
+#include "./../common/frame.h"
+#include "./../common/metrics.h"
+#include "./../common/perf_counters.h"
+#include "./../common/rng.h"
+#include "./../common/score_store.h"
+#include "./../common/trace.h"
 #include "fsm.h"
 
 namespace brickgame {
@@ -22,11 +29,25 @@ class SnakeModel {
   void update();
   unsigned long long processTimer();
   GameInfo_t getGameInfo();
+  void fillFrame(Frame_t *frame) const;
 
   SnakeFSM::State_t getState() const;
   void reset();
+  void seed(unsigned long long seed);
+  struct Snapshot;
+  Snapshot snapshot() const;
+  void restore(const Snapshot &snapshot);
+  const EventRing_t *events() const;
+  void repeatRates(int *das, int *arr) const;
+  void setRepeatRates(int das, int arr);
 
  private:
+  // Gives the benchmarks direct access to the private hot paths.
+  friend class SnakeModelBench;
+
+  void applyInput(UserAction_t action);
+  unsigned long long advance();
+  void noteTransition(SnakeFSM::State_t previous);
   void move();
   void spawnSnake();
   void pause();
@@ -39,9 +60,10 @@ class SnakeModel {
   void saveMaxScore();
 
   int initDB();
+  bool openDB();
   void closeDB();
   int getHighScoreFromDB();
-  void saveHighScoreToDB(int score);
+  int saveHighScoreToDB(int score);
 
   int **getField() const;
   int **getNext() const;
@@ -52,7 +74,7 @@ class SnakeModel {
   int getPauseState() const;
 
   static const int NEW_LEVEL_THRESHOLD_SNAKE = 5;
-  static const int MAX_SPEED = 0;
+  static const int MAX_SPEED = 20;
   static const int MAX_SNAKE_LEN = 200;
 
   SnakeFSM fsm_;
@@ -65,10 +87,37 @@ class SnakeModel {
   int base_speed_;
   int current_speed_;
   bool is_accelerated_;
+  AutoRepeat_t auto_repeat_;
   int apple_x_;
   int apple_y_;
-  sqlite3 *db_;
-  std::chrono::time_point<std::chrono::steady_clock> last_update_time_;
+  ScoreStore_t store_;
+  EventRing_t events_;
+  Rng_t rng_;
+  unsigned long long last_update_millis_;
+
+ public:
+  // The whole game, RNG included, as one POD of a few hundred bytes that
+  // copies with memcpy. The storage handle and the event log stay behind,
+  // so a game clones without touching either; restoring into the reserved
+  // body allocates nothing.
+  struct Snapshot {
+    SnakeFSM::State_t state;
+    Direction_t current_direction;
+    Direction_t next_direction;
+    bool is_accelerated;
+    int score;
+    int high_score;
+    int level;
+    int base_speed;
+    int current_speed;
+    int apple_x;
+    int apple_y;
+    AutoRepeat_t auto_repeat;
+    Rng_t rng;
+    unsigned long long last_update_millis;
+    int length;
+    int8_t body[MAX_SNAKE_LEN + 1][2];
+  };
 };
 
 }  // namespace brickgame
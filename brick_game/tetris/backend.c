@@ -1,107 +1,116 @@
 #include "backend.h"
 
-sqlite3 **getDB() {
-  static sqlite3 *db = NULL;
-  return &db;
+ScoreStore_t *getScoreStore() {
+  static ScoreStore_t store;
+  return &store;
 }
 
 int initDB() {
-  sqlite3 **pdb = getDB();
-  int rc = sqlite3_open("tetris.db", pdb);
-  if (rc) return -1;
-
-  const char *sql =
-      "CREATE TABLE IF NOT EXISTS tetris_scores ("
-      "id INTEGER PRIMARY KEY,"
-      "value INTEGER NOT NULL);"
-      "INSERT OR IGNORE INTO tetris_scores (id, value) VALUES (1, 0);";
-  char *err;
-  rc = sqlite3_exec(*pdb, sql, 0, 0, &err);
-  if (rc != SQLITE_OK) {
-    sqlite3_free(err);
-    sqlite3_close(*pdb);
-    *pdb = NULL;
-    return -1;
-  }
-  return 0;
+  int rc = openScoreStore(getScoreStore(), "tetris.db", "tetris_scores");
+  return rc == SQLITE_OK ? 0 : -1;
 }
 
-void closeDB() {
-  sqlite3 **pdb = getDB();
-  if (*pdb) {
-    sqlite3_close(*pdb);
-    *pdb = NULL;
-  }
+// The store is opened on first use and kept until termination.
+ScoreStore_t *openDB() {
+  initDB();
+  return isScoreStoreOpen(getScoreStore()) ? getScoreStore() : NULL;
 }
 
-int getHighScoreFromDB() {
-  sqlite3 **pdb = getDB();
-  if (!*pdb) return 0;
-  sqlite3_stmt *stmt;
-  const char *sql = "SELECT value FROM tetris_scores WHERE id = 1;";
-  int rc = sqlite3_prepare_v2(*pdb, sql, -1, &stmt, 0);
-  if (rc != SQLITE_OK) return 0;
+void closeDB() { closeScoreStore(getScoreStore()); }
 
+int getHighScoreFromDB() {
+  ScoreStore_t *store = openDB();
+  if (!store) return 0;
+  TraceSpan_t span;
+  beginTraceSpan(&span, "db read");
   int score = 0;
-  if (sqlite3_step(stmt) == SQLITE_ROW) {
-    score = sqlite3_column_int(stmt, 0);
-  }
-  sqlite3_finalize(stmt);
+  readScore(store, &score);
+  endTraceSpan(&span);
   return score;
 }
 
-void saveHighScoreToDB(int score) {
-  sqlite3 **pdb = getDB();
-  if (!*pdb) return;
-  sqlite3_stmt *stmt;
-  const char *sql = "UPDATE tetris_scores SET value = ? WHERE id = 1;";
-  sqlite3_prepare_v2(*pdb, sql, -1, &stmt, 0);
-  sqlite3_bind_int(stmt, 1, score);
-  sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+int saveHighScoreToDB(int score) {
+  ScoreStore_t *store = openDB();
+  if (!store) return -1;
+  TraceSpan_t span;
+  beginTraceSpan(&span, "db write");
+  int rc = writeScore(store, score);
+  endTraceSpan(&span);
+  return rc == SQLITE_OK ? 0 : -1;
 }
 
 GameInfo_t updateCurrentState() {
-  State_t *state = getCurrentState();
+  Frame_t frame;
+  fillFrame(&frame);
+
   GameInfo_t info = {0};
   int **field = createMatrix(FIELD_H, FIELD_W);
-  copyMatrix(field, state->field, FIELD_H, FIELD_W);
+  for (int i = 0; i < FIELD_H; i++) {
+    for (int j = 0; j < FIELD_W; j++) {
+      field[i][j] = frame.field[i][j];
+    }
+  }
+  int **next = createMatrix(NEXT_H, NEXT_W);
+  for (int i = 0; i < NEXT_H; i++) {
+    for (int j = 0; j < NEXT_W; j++) {
+      next[i][j] = frame.next[i][j];
+    }
+  }
+  info.field = field;
+  info.next = next;
+  info.score = frame.score;
+  info.high_score = frame.high_score;
+  info.level = frame.level;
+  info.speed = frame.speed;
+  info.pause = frame.pause;
+  return info;
+}
+
+void fillFrame(Frame_t *frame) {
+  const State_t *state = getCurrentState();
+
+  for (int i = 0; i < FIELD_H; i++) {
+    for (int j = 0; j < FIELD_W; j++) {
+      frame->field[i][j] = state->field ? state->field[i][j] : 0;
+    }
+  }
   for (int i = 0; i < state->block_size; i++) {
     for (int j = 0; j < state->block_size; j++) {
       int new_x = state->x - i;
       int new_y = state->y + j;
       if (state->block[i][j] == 1 && new_x >= 0 && new_y < FIELD_W) {
-        field[new_x][new_y] = 1;
+        frame->field[new_x][new_y] = 1;
       }
     }
   }
-  info.field = field;
-  info.score = state->score;
-  info.level = state->level;
-  info.speed = state->speed;
-  int **next = createMatrix(4, 4);
-  for (int i = 0; i < 4; i++) {
-    for (int j = 0; j < 4; j++) {
-      next[i][j] = 0;
+
+  for (int i = 0; i < NEXT_H; i++) {
+    for (int j = 0; j < NEXT_W; j++) {
+      frame->next[i][j] = 0;
     }
   }
-  int offset_x = (4 - state->next_block_size) / 2,
-      offset_y = (4 - state->next_block_size) / 2;
+  int offset_x = (NEXT_H - state->next_block_size) / 2,
+      offset_y = (NEXT_W - state->next_block_size) / 2;
   for (int i = 0; i < state->next_block_size; i++) {
     for (int j = 0; j < state->next_block_size; j++) {
-      next[offset_x + i][offset_y + j] = state->next_block[i][j];
+      frame->next[offset_x + i][offset_y + j] = state->next_block[i][j];
     }
   }
-  info.next = next;
-  info.high_score = getHighScoreFromDB();
-  info.pause = Empty;
+
+  frame->focus_row = state->x < 0 ? 0 : state->x;
+  frame->focus_col = state->y + state->block_size / 2;
+  frame->score = state->score;
+  frame->high_score = state->high_score;
+  frame->level = state->level;
+  frame->lines = state->lines;
+  frame->speed = state->speed;
+  frame->pause = Empty;
   if (state->status == Paused) {
-    info.pause = GamePause;
+    frame->pause = GamePause;
   }
   if (state->status == GameOver) {
-    info.pause = GOTryAgain;
+    frame->pause = GOTryAgain;
   }
-  return info;
 }
 
 void freeGameInfo(GameInfo_t* info) {
@@ -121,10 +130,26 @@ void freeGameInfo(GameInfo_t* info) {
   }
 }
 
+static void traceStatus(int status) {
+  static const char *const STATUS_NAMES[] = {
+      "Initial", "Spawn", "Moving", "Shifting", "Attaching", "GameOver",
+      "Paused"};
+  if (status >= Initial && status <= Paused) {
+    traceInstant(STATUS_NAMES[status]);
+  }
+}
+
 void userInput(UserAction_t action, bool hold) {
-  (void)hold;
-  if (action == Start) initializeState();
   State_t *state = getCurrentState();
+  if (!acceptHeldInput(&state->auto_repeat, action, hold)) return;
+  if (hold && (action == Left || action == Right))
+    startAutoRepeat(&state->auto_repeat, action, currentTime());
+
+  TraceSpan_t span;
+  beginTraceSpan(&span, "userInput");
+  int previous_status = state->status;
+
+  if (action == Start) initializeState();
 
   switch (action) {
 
@@ -165,6 +190,7 @@ void userInput(UserAction_t action, bool hold) {
       break;
 
     default:
+      advanceEventTick(getEventRing());
       if (state->status == Moving) {
         state->status = Shifting;
         shiftBlock();
@@ -174,51 +200,185 @@ void userInput(UserAction_t action, bool hold) {
         attachBlock();
       }
   }
+
+  if (state->status != previous_status) {
+    traceStatus(state->status);
+    emitGameEvent(getEventRing(), EVENT_STATE_CHANGED, previous_status,
+                  state->status, state->score);
+    if (state->status == GameOver) dumpEventRing(getEventRing());
+  }
+  endTraceSpan(&span);
 }
 
+void setAutoRepeat(int das, int arr) {
+  setAutoRepeatRates(&getCurrentState()->auto_repeat, das, arr);
+}
+
+void seedGame(unsigned long long seed) {
+  State_t *state = getCurrentState();
+  seedRng(&state->rng, seed);
+  releaseAllInputs(&state->auto_repeat);
+  state->status = Initial;
+}
+
+// One game per thread: the engine thread, every replay worker and every test
+// drive their own, and releaseGame() hands the thread's game back.
+static _Thread_local State_t current_state;
+static _Thread_local bool state_initialized = false;
+static _Thread_local EventRing_t event_ring;
+static _Thread_local bool event_ring_initialized = false;
+
 State_t *getCurrentState() {
-  static State_t state = {0};
-  static bool initialized = false;
-  
-  if (!initialized) {
-    state.field = NULL;
-    state.block = NULL;
-    state.next_block = NULL;
-    state.status = Initial;
-    initialized = true;
+  State_t *state = &current_state;
+
+  if (!state_initialized) {
+    memset(state, 0, sizeof(*state));
+    state->status = Initial;
+    initAutoRepeat(&state->auto_repeat);
+    seedRng(&state->rng, monotonicNanos());
+    state_initialized = true;
+  }
+
+  return state;
+}
+
+EventRing_t *getEventRing() {
+  if (!event_ring_initialized) {
+    initEventRing(&event_ring, "tetris");
+    event_ring_initialized = true;
+  }
+
+  return &event_ring;
+}
+
+void releaseGame() {
+  if (state_initialized) {
+    freeMatrix(current_state.field, FIELD_H);
+    freeMatrix(current_state.block, BLOCK_MAX);
+    freeMatrix(current_state.next_block, BLOCK_MAX);
+    state_initialized = false;
+  }
+  if (event_ring_initialized) {
+    releaseEventRing(&event_ring);
+    event_ring_initialized = false;
+  }
+}
+
+// Buffers are allocated on the first start and reused by every restart.
+static void allocateBuffers(State_t *state) {
+  if (state->field) return;
+  state->field = createMatrix(FIELD_H, FIELD_W);
+  state->block = createMatrix(BLOCK_MAX, BLOCK_MAX);
+  state->next_block = createMatrix(BLOCK_MAX, BLOCK_MAX);
+}
+
+static void packMatrix(uint8_t *cells, int **matrix, int height, int width) {
+  if (!matrix) {
+    memset(cells, 0, (size_t)(height * width));
+    return;
+  }
+  for (int i = 0; i < height; i++) {
+    const int *row = matrix[i];
+    uint8_t *packed = cells + i * width;
+    for (int j = 0; j < width; j++) packed[j] = (uint8_t)row[j];
+  }
+}
+
+static void unpackMatrix(int **matrix, const uint8_t *cells, int height,
+                         int width) {
+  for (int i = 0; i < height; i++) {
+    int *row = matrix[i];
+    const uint8_t *packed = cells + i * width;
+    for (int j = 0; j < width; j++) row[j] = packed[j];
   }
-  
-  return &state;
+}
+
+void snapshotGame(TetrisSnapshot_t *snapshot) {
+  const State_t *state = getCurrentState();
+  // Before the first start there are no buffers; their cells stay empty.
+  packMatrix(&snapshot->field[0][0], state->field, FIELD_H, FIELD_W);
+  packMatrix(&snapshot->block[0][0], state->block, BLOCK_MAX, BLOCK_MAX);
+  packMatrix(&snapshot->next_block[0][0], state->next_block, BLOCK_MAX,
+             BLOCK_MAX);
+  snapshot->status = state->status;
+  snapshot->previous_status = state->previous_status;
+  snapshot->block_size = state->block_size;
+  snapshot->block_type = state->block_type;
+  snapshot->next_block_size = state->next_block_size;
+  snapshot->next_block_type = state->next_block_type;
+  snapshot->next_block_rotation = state->next_block_rotation;
+  snapshot->x = state->x;
+  snapshot->y = state->y;
+  snapshot->score = state->score;
+  snapshot->high_score = state->high_score;
+  snapshot->level = state->level;
+  snapshot->lines = state->lines;
+  snapshot->speed = state->speed;
+  snapshot->pause = state->pause;
+  snapshot->start_time = state->start_time;
+  snapshot->time_left = state->time_left;
+  snapshot->pause_start_time = state->pause_start_time;
+  snapshot->terminate_requested = state->terminate_requested;
+  snapshot->auto_repeat = state->auto_repeat;
+  snapshot->rng = state->rng;
+}
+
+void restoreGame(const TetrisSnapshot_t *snapshot) {
+  State_t *state = getCurrentState();
+  allocateBuffers(state);
+  unpackMatrix(state->field, &snapshot->field[0][0], FIELD_H, FIELD_W);
+  unpackMatrix(state->block, &snapshot->block[0][0], BLOCK_MAX, BLOCK_MAX);
+  unpackMatrix(state->next_block, &snapshot->next_block[0][0], BLOCK_MAX,
+               BLOCK_MAX);
+  state->status = snapshot->status;
+  state->previous_status = snapshot->previous_status;
+  state->block_size = snapshot->block_size;
+  state->block_type = snapshot->block_type;
+  state->next_block_size = snapshot->next_block_size;
+  state->next_block_type = snapshot->next_block_type;
+  state->next_block_rotation = snapshot->next_block_rotation;
+  state->x = snapshot->x;
+  state->y = snapshot->y;
+  state->score = snapshot->score;
+  state->high_score = snapshot->high_score;
+  state->level = snapshot->level;
+  state->lines = snapshot->lines;
+  state->speed = snapshot->speed;
+  state->pause = snapshot->pause;
+  state->start_time = snapshot->start_time;
+  state->time_left = snapshot->time_left;
+  state->pause_start_time = snapshot->pause_start_time;
+  state->terminate_requested = snapshot->terminate_requested;
+  state->auto_repeat = snapshot->auto_repeat;
+  state->rng = snapshot->rng;
 }
 
 void initializeState() {
-  initDB();
   State_t *state = getCurrentState();
+  allocateBuffers(state);
 
   state->terminate_requested = false;
   state->status = Initial;
 
-  int **field = createMatrix(FIELD_H, FIELD_W);
-
-  state->field = field;
+  for (int i = 0; i < FIELD_H; i++) {
+    memset(state->field[i], 0, FIELD_W * sizeof(int));
+  }
   state->score = 0;
+  state->high_score = getHighScoreFromDB();
   state->level = 1;
+  state->lines = 0;
   state->speed = INIT_SPEED;
-  state->time_left = state->speed;
+  // The first block is due right away, whatever the last game left behind.
+  state->start_time = currentTime();
+  state->time_left = 0;
   state->pause = 0;
   state->x = -1;
   state->y = 4;
 
-  int next_block_size;
-  int **next_block = generateNewBlock(&next_block_size);
-  int **block = createMatrix(next_block_size, next_block_size);
-  copyMatrix(block, next_block, next_block_size, next_block_size);
-  state->next_block_size = next_block_size;
-  state->next_block = next_block;
-  state->block_size = next_block_size;
-  state->block = block;
-
-  srand(currentTime());
+  generateNewBlock(state->next_block, &state->next_block_size);
+  copyMatrix(state->block, state->next_block, BLOCK_MAX, BLOCK_MAX);
+  state->block_size = state->next_block_size;
+  state->block_type = state->next_block_type;
 }
 
 void startGame() {
@@ -242,36 +402,17 @@ void pauseGame() {
     state->pause = Empty;
     unsigned long long pause_duration = currentTime() - state->pause_start_time;
     state->start_time += pause_duration;
+    state->auto_repeat.next_repeat += pause_duration;
   }
 }
 
-void finishAndRestartGame() {
-  closeDB();
-
-  State_t *state = getCurrentState();
-
-  if (state->block) {
-    freeMatrix(state->block, state->block_size);
-    state->block = NULL;
-  }
-  
-  if (state->next_block) {
-    freeMatrix(state->next_block, state->next_block_size);
-    state->next_block = NULL;
-  }
-  
-  if (state->field) {
-    freeMatrix(state->field, FIELD_H);
-    state->field = NULL;
-  }
-
-  initializeState();
-}
+void finishAndRestartGame() { initializeState(); }
 
 void requestTermination() {
   State_t *state = getCurrentState();
   state->terminate_requested = true;
   finishAndRestartGame();
+  closeDB();
 }
 
 int **createMatrix(int height, int width) {
@@ -335,7 +476,7 @@ void rotate(int **new_block, int **old_block, int size) {
   }
 }
 
-int **generateNewBlock(int *block_size) {
+void generateNewBlock(int **block, int *block_size) {
   static const struct {
     int size;
     int coords[4][2];
@@ -347,10 +488,13 @@ int **generateNewBlock(int *block_size) {
                  [T_BLOCK] = {3, {{0, 0}, {0, 1}, {0, 2}, {1, 1}}},
                  [S_BLOCK] = {3, {{1, 0}, {1, 1}, {0, 1}, {0, 2}}}};
 
-  int block_type = rand() % 7;
+  State_t *state = getCurrentState();
+  int block_type = randomBelow(&state->rng, 7);
   *block_size = BLOCKS[block_type].size;
 
-  int **block = createMatrix(*block_size, *block_size);
+  for (int i = 0; i < BLOCK_MAX; i++) {
+    memset(block[i], 0, BLOCK_MAX * sizeof(int));
+  }
   for (int i = 0; i < 4; i++) {
     int x = BLOCKS[block_type].coords[i][0];
     int y = BLOCKS[block_type].coords[i][1];
@@ -359,22 +503,28 @@ int **generateNewBlock(int *block_size) {
     }
   }
 
-  int **temp = createMatrix(*block_size, *block_size);
-  for (int i = rand() % 4; i > 0; i--) {
+  int rotation = randomBelow(&state->rng, 4);
+  state->next_block_type = block_type;
+  state->next_block_rotation = rotation;
+
+  int cells[BLOCK_MAX][BLOCK_MAX];
+  int *temp[BLOCK_MAX] = {cells[0], cells[1], cells[2], cells[3]};
+  for (int i = rotation; i > 0; i--) {
     rotate(temp, block, *block_size);
     copyMatrix(block, temp, *block_size, *block_size);
   }
-
-  freeMatrix(temp, *block_size);
-  return block;
 }
 
 void spawnNewBlock() {
   State_t *state = getCurrentState();
 
-  freeMatrix(state->block, state->block_size);
+  int **spawned = state->next_block;
+  state->next_block = state->block;
+  state->block = spawned;
   state->block_size = state->next_block_size;
-  state->block = state->next_block;
+  state->block_type = state->next_block_type;
+  emitGameEvent(getEventRing(), EVENT_PIECE_SPAWNED, state->block_type,
+                state->next_block_rotation, 0);
 
   state->x = -1;
   if (state->block_size == 2) {
@@ -383,10 +533,7 @@ void spawnNewBlock() {
     state->y = 3;
   }
 
-  int next_block_size;
-  int **next_block = generateNewBlock(&next_block_size);
-  state->next_block_size = next_block_size;
-  state->next_block = next_block;
+  generateNewBlock(state->next_block, &state->next_block_size);
 
   state->status = Moving;
   state->start_time = currentTime();
@@ -512,6 +659,8 @@ void attachBlock() {
     }
   }
 
+  emitGameEvent(getEventRing(), EVENT_PIECE_LOCKED, state->block_type,
+                state->y, state->x);
   if (game_over == 1) {
     state->status = GameOver;
     state->pause = GOTryAgain;
@@ -550,14 +699,12 @@ int canRotateBlock(int **new_block) {
 void rotateBlock() {
   State_t *state = getCurrentState();
 
-  int **new_block = createMatrix(state->block_size, state->block_size);
+  int cells[BLOCK_MAX][BLOCK_MAX];
+  int *new_block[BLOCK_MAX] = {cells[0], cells[1], cells[2], cells[3]};
   rotate(new_block, state->block, state->block_size);
 
   if (canRotateBlock(new_block) == 1) {
-    freeMatrix(state->block, state->block_size);
-    state->block = new_block;
-  } else {
-    freeMatrix(new_block, state->block_size);
+    copyMatrix(state->block, new_block, state->block_size, state->block_size);
   }
 
   int attached = isBlockAttached();
@@ -569,21 +716,32 @@ void rotateBlock() {
   }
 }
 
-unsigned long long currentTime() {
-  struct timespec ts;
-  timespec_get(&ts, TIME_UTC);
-  return (unsigned long long)ts.tv_sec * 1000 +
-         (unsigned long long)ts.tv_nsec / 1000000;
+void applyAutoRepeat() {
+  State_t *state = getCurrentState();
+  int repeats = dueAutoRepeats(&state->auto_repeat, currentTime());
+
+  for (int i = 0; i < repeats && state->status == Moving; i++) {
+    if (state->auto_repeat.repeating == Left)
+      moveBlockLeft();
+    else
+      moveBlockRight();
+  }
 }
 
+unsigned long long currentTime() { return gameMillis(); }
+
 unsigned long long processTimer() {
   State_t *state = getCurrentState();
+  TraceSpan_t span;
+  beginTraceSpan(&span, "processTimer");
 
   unsigned long long time_left;
 
-  if (state->status == Initial) {
+  if (state->status == Initial || state->status == Paused ||
+      state->status == GameOver) {
     time_left = -1;
   } else {
+    if (state->status == Moving) applyAutoRepeat();
     unsigned long long elapsed_time = currentTime() - state->start_time;
     if (elapsed_time >= state->time_left) {
       time_left = 0;
@@ -592,17 +750,40 @@ unsigned long long processTimer() {
       state->start_time = currentTime();
       time_left = state->time_left;
     }
+
+    unsigned long long repeat_left =
+        autoRepeatTimeLeft(&state->auto_repeat, currentTime());
+    if (repeat_left == 0) repeat_left = 1;
+    if (state->status == Moving && repeat_left < time_left)
+      time_left = repeat_left;
   }
+  endTraceSpan(&span);
   return time_left;
 }
 
 void saveMaxScore() {
-  const State_t *state = getCurrentState();
+  State_t *state = getCurrentState();
+  // Most locks do not set a record; the cached high score answers those
+  // without touching the store.
+  if (state->score <= state->high_score) return;
+  PerfSample_t sample;
+  beginPerfSample(&sample);
+  unsigned long long start = monotonicNanos();
+  // Another process may have stored a higher score since it was cached, so
+  // the stored value is read again inside the batch before writing.
+  ScoreStore_t *store = openDB();
+  if (store) beginScoreBatch(store);
   int high_score = getHighScoreFromDB();
 
-  if (state->score > high_score) {
-    saveHighScoreToDB(state->score);
+  bool written =
+      state->score > high_score && saveHighScoreToDB(state->score) == 0;
+  if (store && commitScoreBatch(store) == SQLITE_OK && written) {
+    high_score = state->score;
+    emitGameEvent(getEventRing(), EVENT_SCORE_PERSISTED, 0, 0, high_score);
   }
+  state->high_score = high_score;
+  recordMetricLatency(METRIC_PERSIST_LATENCY, monotonicNanos() - start);
+  endPerfSample(&sample, PERF_SITE_PERSIST);
 }
 
 void updateLevel() {
@@ -613,12 +794,17 @@ void updateLevel() {
     state->status = Win;
   }
   state->speed -= (new_level - state->level) * SPEED_STEP;
+  if (new_level > state->level) {
+    emitGameEvent(getEventRing(), EVENT_LEVEL_UP, new_level, 0, state->speed);
+  }
   state->level = new_level;
 }
 
 void deleteLines() {
   State_t *state = getCurrentState();
   int full_lines = 0;
+  TraceSpan_t span;
+  beginTraceSpan(&span, "deleteLines");
 
   for (int i = FIELD_H - 1; i > 0; i--) {
     int block_count = 0;
@@ -646,7 +832,14 @@ void deleteLines() {
   } else if (full_lines == 4) {
     state->score += 1500;
   }
+  if (full_lines > 0) {
+    state->lines += full_lines;
+    emitGameEvent(getEventRing(), EVENT_LINES_CLEARED, full_lines, 0,
+                  state->score);
+    addMetricCounter(METRIC_LINES_CLEARED, (unsigned long long)full_lines);
+  }
 
   saveMaxScore();
   updateLevel();
+  endTraceSpan(&span);
 }
\ No newline at end of file
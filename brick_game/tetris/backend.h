@@ -7,13 +7,25 @@ extern "C" {
 
 #include <sqlite3.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include "./../../brick_game.h"
+#include "./../common/auto_repeat.h"
+#include "./../common/clock.h"
+#include "./../common/event_ring.h"
+#include "./../common/frame.h"
+#include "./../common/metrics.h"
+#include "./../common/perf_counters.h"
+#include "./../common/rng.h"
+#include "./../common/score_store.h"
+#include "./../common/trace.h"
 
 #define NEW_LEVEL_THRESHOLD 600
+#define BLOCK_MAX 4  // blocks live in BLOCK_MAX x BLOCK_MAX buffers
 
 typedef enum {
   Initial,
@@ -31,20 +43,58 @@ typedef struct {
   int **field;
   int **block;
   int block_size;
+  int block_type;
   int **next_block;
   int next_block_size;
+  int next_block_type;
+  int next_block_rotation;
   int x;
   int y;
   int score;
+  int high_score;
   int level;
+  int lines;
   int speed;
   int pause;
   unsigned long long start_time;
   unsigned long long time_left;
   unsigned long long pause_start_time;
   bool terminate_requested;
+  AutoRepeat_t auto_repeat;
+  Rng_t rng;
 } State_t;
 
+// Everything State_t holds, flattened into one POD of a few hundred bytes
+// that copies with memcpy: cells shrink to bytes and there are no buffers
+// or storage handles to follow, so a game clones in well under a
+// microsecond.
+typedef struct {
+  uint8_t field[FIELD_H][FIELD_W];
+  uint8_t block[BLOCK_MAX][BLOCK_MAX];
+  uint8_t next_block[BLOCK_MAX][BLOCK_MAX];
+  int status;
+  int previous_status;
+  int block_size;
+  int block_type;
+  int next_block_size;
+  int next_block_type;
+  int next_block_rotation;
+  int x;
+  int y;
+  int score;
+  int high_score;
+  int level;
+  int lines;
+  int speed;
+  int pause;
+  unsigned long long start_time;
+  unsigned long long time_left;
+  unsigned long long pause_start_time;
+  bool terminate_requested;
+  AutoRepeat_t auto_repeat;
+  Rng_t rng;
+} TetrisSnapshot_t;
+
 typedef enum {
   I_BLOCK,
   L_BLOCK,
@@ -56,10 +106,21 @@ typedef enum {
 } Block_t;
 
 GameInfo_t updateCurrentState();
+void fillFrame(Frame_t *frame);
 void freeGameInfo(GameInfo_t *info);
 void userInput(UserAction_t action, bool hold);
-
+void setAutoRepeat(int das, int arr);
+// Starts over from the initial screen with pieces drawn from this seed.
+void seedGame(unsigned long long seed);
+// Copies the whole game, RNG included, to and from a TetrisSnapshot_t.
+void snapshotGame(TetrisSnapshot_t *snapshot);
+void restoreGame(const TetrisSnapshot_t *snapshot);
+
+// The calling thread's game and event ring, created on first use.
 State_t *getCurrentState();
+EventRing_t *getEventRing();
+// Frees the calling thread's game; the next call starts a fresh one.
+void releaseGame();
 void initializeState();
 void startGame();
 void pauseGame();
@@ -70,7 +131,7 @@ int **createMatrix(int height, int width);
 void copyMatrix(int **dest, int **src, int height, int width);
 void freeMatrix(int **matrix, int size);
 void rotate(int **new_block, int **old_block, int size);
-int **generateNewBlock(int *block_size);
+void generateNewBlock(int **block, int *block_size);
 void spawnNewBlock();
 
 void moveBlockLeft();
@@ -80,6 +141,7 @@ int isBlockAttached();
 void attachBlock();
 int canRotateBlock(int **new_block);
 void rotateBlock();
+void applyAutoRepeat();
 
 unsigned long long currentTime();
 unsigned long long processTimer();
@@ -88,11 +150,12 @@ void saveMaxScore();
 void updateLevel();
 void deleteLines();
 
-sqlite3 **getDB();
+ScoreStore_t *getScoreStore();
 int initDB();
+ScoreStore_t *openDB();
 void closeDB();
 int getHighScoreFromDB();
-void saveHighScoreToDB(int score);
+int saveHighScoreToDB(int score);
 
 #ifdef __cplusplus
 }
@@ -1,9 +1,14 @@
 #include "controller.h"
 
+#include <cstring>
+
 namespace brickgame {
 
 Controller::Controller() {}
 
+// The game lives in the backend, one per thread; it goes with its controller.
+Controller::~Controller() { ::releaseGame(); }
+
 void Controller::userInput(UserAction_t action, bool hold) {
   ::userInput(action, hold);
 }
@@ -14,4 +19,117 @@ unsigned long long Controller::processTimer() { return ::processTimer(); }
 
 void Controller::freeGameInfo(GameInfo_t* info) { return ::freeGameInfo(info); }
 
-}  // namespace brickgame
\ No newline at end of file
+void Controller::fillFrame(Frame_t* frame) { ::fillFrame(frame); }
+
+Controller::Snapshot Controller::snapshot() const {
+  Snapshot snapshot;
+  ::snapshotGame(&snapshot);
+  return snapshot;
+}
+
+void Controller::restore(const Snapshot& snapshot) {
+  ::restoreGame(&snapshot);
+}
+
+const EventRing_t* Controller::events() const { return ::getEventRing(); }
+
+void Controller::repeatRates(int* das, int* arr) const {
+  const AutoRepeat_t& repeat = ::getCurrentState()->auto_repeat;
+  *das = static_cast<int>(repeat.das);
+  *arr = static_cast<int>(repeat.arr);
+}
+
+void Controller::setRepeatRates(int das, int arr) { ::setAutoRepeat(das, arr); }
+
+}  // namespace brickgame
+
+namespace {
+
+void* createGame() { return new brickgame::Controller(); }
+
+void seedGame(void*, unsigned long long seed) { ::seedGame(seed); }
+
+void destroyGame(void* game) {
+  delete static_cast<brickgame::Controller*>(game);
+}
+
+void gameInput(void* game, UserAction_t action, bool hold) {
+  static_cast<brickgame::Controller*>(game)->userInput(action, hold);
+}
+
+unsigned long long gameTick(void* game) {
+  return static_cast<brickgame::Controller*>(game)->processTimer();
+}
+
+void gameFill(void* game, Frame_t* frame) {
+  static_cast<brickgame::Controller*>(game)->fillFrame(frame);
+}
+
+using Snapshot = brickgame::Controller::Snapshot;
+
+size_t saveGame(void* game, void* buffer, size_t capacity) {
+  if (capacity < sizeof(Snapshot)) return 0;
+  Snapshot snapshot = static_cast<brickgame::Controller*>(game)->snapshot();
+  std::memcpy(buffer, &snapshot, sizeof(snapshot));
+  return sizeof(snapshot);
+}
+
+bool inRange(int value, int low, int high) {
+  return value >= low && value <= high;
+}
+
+// A blob from a replay file indexes the BLOCK_MAX buffers and the field, so
+// every size, state and position has to be one the game can reach: filled
+// block cells may stick out above the field but nowhere else.
+bool validSnapshot(const Snapshot& snapshot) {
+  if (!inRange(snapshot.status, Initial, Paused) ||
+      !inRange(snapshot.previous_status, Initial, Paused) ||
+      !inRange(snapshot.block_size, 0, BLOCK_MAX) ||
+      !inRange(snapshot.next_block_size, 0, BLOCK_MAX) ||
+      !inRange(snapshot.block_type, I_BLOCK, S_BLOCK) ||
+      !inRange(snapshot.next_block_type, I_BLOCK, S_BLOCK) ||
+      !inRange(snapshot.x, -1, FIELD_H + BLOCK_MAX - 1) ||
+      !inRange(snapshot.y, -BLOCK_MAX, FIELD_W - 1) ||
+      !validAutoRepeat(&snapshot.auto_repeat))
+    return false;
+  for (int i = 0; i < snapshot.block_size; i++) {
+    for (int j = 0; j < snapshot.block_size; j++) {
+      if (snapshot.block[i][j] == 0) continue;
+      if (snapshot.x - i >= FIELD_H || !inRange(snapshot.y + j, 0, FIELD_W - 1))
+        return false;
+    }
+  }
+  return true;
+}
+
+bool loadGame(void* game, const void* buffer, size_t size) {
+  if (size != sizeof(Snapshot)) return false;
+  Snapshot snapshot;
+  std::memcpy(&snapshot, buffer, sizeof(snapshot));
+  if (!validSnapshot(snapshot)) return false;
+  static_cast<brickgame::Controller*>(game)->restore(snapshot);
+  return true;
+}
+
+const EventRing_t* gameEvents(void* game) {
+  return static_cast<brickgame::Controller*>(game)->events();
+}
+
+void gameRepeatRates(void* game, int* das, int* arr) {
+  static_cast<brickgame::Controller*>(game)->repeatRates(das, arr);
+}
+
+void setGameRepeatRates(void* game, int das, int arr) {
+  static_cast<brickgame::Controller*>(game)->setRepeatRates(das, arr);
+}
+
+}  // namespace
+
+extern "C" const EngineOps_t* getEngineOps(void) {
+  static const EngineOps_t ops = {"tetris", createGame, seedGame,
+                                  destroyGame, gameInput, gameTick,
+                                  gameFill, saveGame, loadGame,
+                                  gameEvents, gameRepeatRates,
+                                  setGameRepeatRates};
+  return &ops;
+}
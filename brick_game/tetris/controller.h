@@ -1,18 +1,28 @@
 #ifndef SRC_BRICK_GAME_TETRIS_BACKEND_CONTROLLER_H_
 #define SRC_BRICK_GAME_TETRIS_BACKEND_CONTROLLER_H_
 
+#include "./../common/engine.h"
 #include "backend.h"
 namespace brickgame {
 
 class Controller {
  public:
+  using Snapshot = TetrisSnapshot_t;
+
   Controller();
+  ~Controller();
   void userInput(UserAction_t action, bool hold);
   GameInfo_t updateCurrentState();
   unsigned long long processTimer();
   void freeGameInfo(GameInfo_t* info);
+  void fillFrame(Frame_t* frame);
+  Snapshot snapshot() const;
+  void restore(const Snapshot& snapshot);
+  const EventRing_t* events() const;
+  void repeatRates(int* das, int* arr) const;
+  void setRepeatRates(int das, int arr);
 };
 
 }  // namespace brickgame
 
-#endif  // SRC_BRICK_GAME_TETRIS_BACKEND_CONTROLLER_H_
\ No newline at end of file
+#endif  // SRC_BRICK_GAME_TETRIS_BACKEND_CONTROLLER_H_
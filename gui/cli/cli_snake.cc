@@ -1,30 +1,22 @@
-#include "./../../brick_game/snake/controller.h"
-#include "./frontend.h"
-
-using namespace brickgame;
-
-void snakeGame() {
-  Controller controller;
-  bool running = true;
-  while (running) {
-    int input = getch();
-    UserAction_t action = getSignal(input);
-
-    if (action == Terminate) {
-      running = false;
-    }
+#include <cstring>
 
-    controller.userInput(action, false);
-
-    GameInfo_t info = controller.updateCurrentState();
-    renderGUI(info);
-    controller.freeGameInfo(&info);
-  }
-}
+#include "./frontend.h"
+#include "./game_loop.h"
+#include "./../../brick_game/common/metrics.h"
+#include "./../../brick_game/common/perf_counters.h"
 
-int main() {
+int main(int argc, char **argv) {
+  startMetricsServer("cli_snake");
   initializeGUI();
-  snakeGame();
+  if (argc == 3 && strcmp(argv[1], "--replay") == 0)
+    replayLoop(getEngineOps(), argv[2]);
+  else if (argc == 3 && strcmp(argv[1], "--spectate") == 0)
+    spectateLoop(argv[2]);
+  else
+    gameLoop(getEngineOps());
   cleanupGUI();
+  stopMetricsServer();
+  printInputLatencyReport(stderr, getInputLatency());
+  printPerfReport(stderr);
   return 0;
-}
\ No newline at end of file
+}
@@ -1,35 +1,22 @@
-#include "./../../brick_game/tetris/backend.h"
-#include "./frontend.h"
-
-void tetrisGame() {
-  bool termination_requested = false;
-  GameInfo_t info = updateCurrentState();
-  renderGUI(info);
-  freeGameInfo(&info);
-
-  while (!termination_requested) {
-    unsigned long long time_left = processTimer();
-    timeout(time_left);
-    int c = getch();
-    
-    if (c == TERMINATE_KEY) {
-      userInput(Terminate, false);
-      termination_requested = true;
-    } else {
-      userInput(getSignal(c), false);
-    }
+#include <string.h>
 
-    if (!termination_requested) {
-      info = updateCurrentState();
-      renderGUI(info);
-      freeGameInfo(&info);
-    }
-  }
-}
+#include "./frontend.h"
+#include "./game_loop.h"
+#include "./../../brick_game/common/metrics.h"
+#include "./../../brick_game/common/perf_counters.h"
 
-int main() {
+int main(int argc, char **argv) {
+  startMetricsServer("cli_tetris");
   initializeGUI();
-  tetrisGame();
+  if (argc == 3 && strcmp(argv[1], "--replay") == 0)
+    replayLoop(getEngineOps(), argv[2]);
+  else if (argc == 3 && strcmp(argv[1], "--spectate") == 0)
+    spectateLoop(argv[2]);
+  else
+    gameLoop(getEngineOps());
   cleanupGUI();
+  stopMetricsServer();
+  printInputLatencyReport(stderr, getInputLatency());
+  printPerfReport(stderr);
   return 0;
-}
\ No newline at end of file
+}
@@ -1,5 +1,8 @@
 #include "frontend.h"
 
+#include "./../../brick_game/common/clock.h"
+#include "./../../brick_game/common/trace.h"
+
 void initializeGUI() {
   initscr();
   cbreak();
@@ -22,37 +25,38 @@ void initColors() {
   init_pair(7, COLOR_WHITE, COLOR_GREEN);  // gameover
 }
 
-void renderGUI(GameInfo_t game_info) {
-  struct timespec render_delay = {
-      .tv_sec = 0,
-      .tv_nsec = 16666667L  // ~60 FPS (16.666 ms)
-  };
-  thrd_sleep(&render_delay, NULL);
+static void refreshWindow(WINDOW *window) {
+  TraceSpan_t span;
+  beginTraceSpan(&span, "wrefresh");
+  wrefresh(window);
+  endTraceSpan(&span);
+}
 
+void renderGUI(GameInfo_t game_info) {
   WINDOW *controls = printControls();
-  wrefresh(controls);
+  refreshWindow(controls);
 
   WINDOW *game = printGameField(game_info);
-  wrefresh(game);
+  refreshWindow(game);
 
   WINDOW *info = printGameInfo(game_info);
-  wrefresh(info);
+  refreshWindow(info);
 
   if (game_info.pause == GamePause) {
     WINDOW *pause = printPauseMessage();
-    wrefresh(pause);
+    refreshWindow(pause);
     delwin(pause);
   }
 
   if (game_info.pause == GOTryAgain) {
     WINDOW *gameover = printGameOverMessage();
-    wrefresh(gameover);
+    refreshWindow(gameover);
     delwin(gameover);
   }
 
   if (game_info.pause == Win) {
     WINDOW *win = printWinMessage();
-    wrefresh(win);
+    refreshWindow(win);
     delwin(win);
   }
 
@@ -75,29 +79,38 @@ WINDOW *printControls() {
   mvwprintw(controls_window, 12, 2, "MOVE RIGHT    >");
   mvwprintw(controls_window, 14, 2, "MOVE DOWN     v");
   mvwprintw(controls_window, 16, 2, "EXIT          ESC");
+  mvwprintw(controls_window, 18, 2, "ZOOM/FOLLOW   Z/F");
+  mvwprintw(controls_window, 19, 2, "SCROLL        IJKL");
+  mvwprintw(controls_window, 20, 2, "DEBUG/HUD     D/H");
 
   return controls_window;
 }
 
 WINDOW *printGameField(GameInfo_t game_info) {
+  const Viewport_t *viewport = getViewport();
   WINDOW *game_window =
       newwin(GAME_FIELD_H, GAME_FIELD_W, TOP_MARGIN, CONTROLS_W);
 
   box(game_window, 0, 0);
 
   mvwprintw(game_window, 0, (GAME_FIELD_W - 12) / 2, " BRICK GAME ");
+  if (viewport->scale > 1) {
+    mvwprintw(game_window, GAME_FIELD_H - 1, 2, " 1:%d ", viewport->scale);
+  }
 
-  for (int i = 0; i < FIELD_H; i++) {
-    for (int j = 0; j < FIELD_W; j++) {
-      if (game_info.field[i][j] == 1) {
+  const int rows = visibleRows(viewport), cols = visibleCols(viewport);
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      int cell = sampleViewportCell(viewport, game_info.field, i, j);
+      if (cell == 1) {
         wattron(game_window, COLOR_PAIR(2));
         mvwprintw(game_window, i + 1, 3 * j + 1, "   ");
         wattroff(game_window, COLOR_PAIR(2));
-      } else if (game_info.field[i][j] == 2) {
+      } else if (cell == 2) {
         wattron(game_window, COLOR_PAIR(5));
         mvwprintw(game_window, i + 1, 3 * j + 1, "   ");
         wattroff(game_window, COLOR_PAIR(5));
-      } else if (game_info.field[i][j] == 3) {
+      } else if (cell == 3) {
         wattron(game_window, COLOR_PAIR(6));
         mvwprintw(game_window, i + 1, 3 * j + 1, "   ");
         wattroff(game_window, COLOR_PAIR(6));
@@ -112,6 +125,23 @@ WINDOW *printGameField(GameInfo_t game_info) {
   return game_window;
 }
 
+static void printPerfHud(WINDOW *window, const HudStats_t *stats) {
+  const double millis = NANOS_PER_MILLI;
+  mvwprintw(window, 12, 2, "FPS %-5.1f TPS %.1f", stats->fps,
+            stats->ticks_per_sec);
+  mvwprintw(window, 13, 2, "p50/p99 FRAME, TICK");
+  mvwprintw(window, 14, 2, "%.2f/%.2f ms", stats->frame.p50 / millis,
+            stats->frame.p99 / millis);
+  mvwprintw(window, 15, 2, "%.3f/%.3f ms", stats->tick.p50 / millis,
+            stats->tick.p99 / millis);
+  if (stats->allocs_per_frame < 0) {
+    mvwprintw(window, 16, 2, "ALLOCS/FRAME n/a");
+  } else {
+    mvwprintw(window, 16, 2, "ALLOCS/FRAME %.1f", stats->allocs_per_frame);
+  }
+  mvwprintw(window, 17, 2, "DB OPS/S %.1f", stats->db_ops_per_sec);
+}
+
 WINDOW *printGameInfo(GameInfo_t game_info) {
   WINDOW *info_window =
       newwin(GAME_FIELD_H, GAME_INFO_W, TOP_MARGIN, CONTROLS_W + GAME_FIELD_W);
@@ -131,10 +161,25 @@ WINDOW *printGameInfo(GameInfo_t game_info) {
     }
   }
 
+  // The HUD needs the rows the regular layout leaves between the figures.
+  int spacing = *getHudOverlay() ? 1 : 3;
   mvwprintw(info_window, 8, 2, "HIGH SCORE:  %d", game_info.high_score);
-  mvwprintw(info_window, 11, 2, "SCORE:       %d", game_info.score);
-  mvwprintw(info_window, 14, 2, "LEVEL:       %d", game_info.level);
-  mvwprintw(info_window, 17, 2, "SPEED:       %d", game_info.speed);
+  mvwprintw(info_window, 8 + spacing, 2, "SCORE:       %d", game_info.score);
+  mvwprintw(info_window, 8 + 2 * spacing, 2, "LEVEL:       %d",
+            game_info.level);
+  mvwprintw(info_window, 8 + 3 * spacing, 2, "SPEED:       %d",
+            game_info.speed);
+
+  if (*getHudOverlay()) printPerfHud(info_window, &getPerfHud()->stats);
+
+  if (*getDebugOverlay()) {
+    LatencySummary_t latency = summarizeLatency(&getInputLatency()->histogram);
+    mvwprintw(info_window, 19, 2, "KEY LAG p50/p99/max");
+    mvwprintw(info_window, 20, 2, "%.1f/%.1f/%.1f ms",
+              (double)latency.p50 / NANOS_PER_MILLI,
+              (double)latency.p99 / NANOS_PER_MILLI,
+              (double)latency.max / NANOS_PER_MILLI);
+  }
 
   return info_window;
 }
@@ -216,4 +261,92 @@ UserAction_t getSignal(int input) {
       break;
   }
   return action;
-}
\ No newline at end of file
+}
+bool *getDebugOverlay() {
+  static bool enabled = false;
+  return &enabled;
+}
+
+PerfHud_t *getPerfHud() {
+  static PerfHud_t hud;
+  static bool initialized = false;
+
+  if (!initialized) {
+    initPerfHud(&hud);
+    initialized = true;
+  }
+
+  return &hud;
+}
+
+bool *getHudOverlay() {
+  static bool enabled = false;
+  return &enabled;
+}
+
+bool handleHudKey(int input) {
+  if (input != HUD_KEY) return false;
+  bool *enabled = getHudOverlay();
+  *enabled = !*enabled;
+  return true;
+}
+
+InputLatency_t *getInputLatency() {
+  static InputLatency_t latency;
+  static bool initialized = false;
+
+  if (!initialized) {
+    initInputLatency(&latency);
+    initialized = true;
+  }
+
+  return &latency;
+}
+
+bool handleDebugKey(int input) {
+  if (input != DEBUG_KEY) return false;
+  bool *enabled = getDebugOverlay();
+  *enabled = !*enabled;
+  return true;
+}
+
+Viewport_t *getViewport() {
+  static Viewport_t viewport;
+  static bool initialized = false;
+
+  if (!initialized) {
+    initViewport(&viewport, FIELD_H, FIELD_W, FIELD_H, FIELD_W);
+    initialized = true;
+  }
+
+  return &viewport;
+}
+
+bool handleViewportKey(int input) {
+  Viewport_t *viewport = getViewport();
+  bool handled = true;
+  switch (input) {
+    case ZOOM_KEY:
+      zoomViewport(viewport);
+      break;
+    case FOLLOW_KEY:
+      viewport->follow = !viewport->follow;
+      break;
+    case SCROLL_UP_KEY:
+      scrollViewport(viewport, -1, 0);
+      break;
+    case SCROLL_LEFT_KEY:
+      scrollViewport(viewport, 0, -1);
+      break;
+    case SCROLL_DOWN_KEY:
+      scrollViewport(viewport, 1, 0);
+      break;
+    case SCROLL_RIGHT_KEY:
+      scrollViewport(viewport, 0, 1);
+      break;
+    default:
+      handled = false;
+      break;
+  }
+  return handled;
+}
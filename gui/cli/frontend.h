@@ -7,9 +7,11 @@ extern "C" {
 
 #include <ncurses.h>
 #include <stdlib.h>
-#include <threads.h>
 
 #include "./../../brick_game.h"
+#include "./../common/input_latency.h"
+#include "./../common/perf_hud.h"
+#include "./../common/viewport.h"
 
 #define GAME_FIELD_H (FIELD_H + 2)
 #define GAME_FIELD_W (FIELD_W * 3 + 2)
@@ -31,6 +33,14 @@ extern "C" {
 #define TERMINATE_KEY 27
 #define PAUSE_KEY 112
 #define START_KEY 10
+#define ZOOM_KEY 'z'
+#define FOLLOW_KEY 'f'
+#define SCROLL_UP_KEY 'i'
+#define SCROLL_LEFT_KEY 'j'
+#define SCROLL_DOWN_KEY 'k'
+#define SCROLL_RIGHT_KEY 'l'
+#define DEBUG_KEY 'd'
+#define HUD_KEY 'h'
 
 void initializeGUI();
 void initColors();
@@ -43,6 +53,14 @@ void cleanupGUI();
 WINDOW *printGameOverMessage();
 WINDOW *printWinMessage();
 UserAction_t getSignal(int input);
+Viewport_t *getViewport();
+bool handleViewportKey(int input);
+InputLatency_t *getInputLatency();
+bool *getDebugOverlay();
+bool handleDebugKey(int input);
+PerfHud_t *getPerfHud();
+bool *getHudOverlay();
+bool handleHudKey(int input);
 
 #ifdef __cplusplus
 }
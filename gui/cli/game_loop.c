@@ -0,0 +1,260 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "game_loop.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "./../../brick_game/common/clock.h"
+#include "./../../brick_game/common/metrics.h"
+#include "./../../brick_game/common/replay.h"
+#include "./../../brick_game/common/spectator.h"
+#include "./../../brick_game/common/trace.h"
+#include "frontend.h"
+
+// Terminals report key presses only, so holds are inferred from the key
+// repeat: a key that comes again within HOLD_WINDOW_NS is held, and a held
+// key that stops repeating for RELEASE_WINDOW_NS is released. The engine
+// then repeats the action on its own clock.
+#define HOLD_WINDOW_NS (700 * NANOS_PER_MILLI)
+#define RELEASE_WINDOW_NS (100 * NANOS_PER_MILLI)
+
+typedef struct {
+  int key;
+  UserAction_t action;
+  unsigned long long last_seen;
+  bool held;
+} KeyHold_t;
+
+static void submitAction(EngineThread_t *engine, UserAction_t action,
+                         bool hold, unsigned long long stamp) {
+  InputEvent_t event = {action, hold, stamp};
+  submitInputEvent(engine, &event);
+}
+
+static void releaseKey(EngineThread_t *engine, KeyHold_t *hold,
+                       unsigned long long now) {
+  if (hold->held) submitAction(engine, hold->action, false, now);
+  hold->held = false;
+}
+
+static bool isHoldable(UserAction_t action) {
+  return action == Left || action == Right || action == Up ||
+         action == Down || action == Action;
+}
+
+static void trackKey(EngineThread_t *engine, KeyHold_t *hold, int key,
+                     UserAction_t action, unsigned long long now) {
+  if (key == hold->key && now - hold->last_seen <= HOLD_WINDOW_NS) {
+    if (!hold->held) submitAction(engine, action, true, now);
+    hold->held = true;
+  } else {
+    releaseKey(engine, hold, now);
+    submitAction(engine, action, false, now);
+    hold->key = key;
+    hold->action = action;
+  }
+  hold->last_seen = now;
+}
+
+static bool pollKeys(EngineThread_t *engine, KeyHold_t *hold, bool *redraw) {
+  bool running = true;
+  int c;
+  while ((c = getch()) != ERR) {
+    if (handleViewportKey(c) || handleDebugKey(c) || handleHudKey(c)) {
+      *redraw = true;
+      continue;
+    }
+    TraceSpan_t span;
+    beginTraceSpan(&span, "input");
+    unsigned long long now = monotonicNanos();
+    UserAction_t action = getSignal(c);
+    if (isHoldable(action)) {
+      trackKey(engine, hold, c, action, now);
+    } else {
+      releaseKey(engine, hold, now);
+      hold->key = ERR;
+      if (action == Terminate) running = false;
+      submitAction(engine, action, false, now);
+    }
+    endTraceSpan(&span);
+  }
+
+  unsigned long long now = monotonicNanos();
+  if (hold->held && now - hold->last_seen > RELEASE_WINDOW_NS) {
+    releaseKey(engine, hold, now);
+  }
+  return running;
+}
+
+// Frames where nothing drawn changed are skipped, unless the HUD is up and
+// has its own numbers to refresh. Their input is still on screen as of now,
+// so its latency is taken before the skip, not against a later frame.
+static void renderLatestFrame(EngineThread_t *engine, bool redraw,
+                              unsigned long long *version) {
+  bool fresh = false;
+  Frame_t *frame = acquireFrame(engine, &fresh);
+  if (!fresh && !redraw) return;
+  if (!redraw && !*getHudOverlay() && frame->version == *version) {
+    recordFramePresented(getInputLatency(), frame->input_stamp);
+    return;
+  }
+  *version = frame->version;
+
+  Viewport_t *viewport = getViewport();
+  if (viewport->follow) {
+    followViewport(viewport, frame->focus_row, frame->focus_col);
+  }
+
+  TraceSpan_t span;
+  beginTraceSpan(&span, "render");
+  updatePerfHud(getPerfHud());
+  unsigned long long start = monotonicNanos();
+  int *field_rows[FIELD_H];
+  int *next_rows[NEXT_H];
+  renderGUI(frameToGameInfo(frame, field_rows, next_rows));
+  recordFramePresented(getInputLatency(), frame->input_stamp);
+  recordMetricLatency(METRIC_RENDER_LATENCY, monotonicNanos() - start);
+  addMetricCounter(METRIC_FRAMES_RENDERED, 1);
+  endTraceSpan(&span);
+}
+
+static int millisUntil(unsigned long long deadline) {
+  unsigned long long now = monotonicNanos();
+  if (now >= deadline) return 0;
+  return (int)((deadline - now + NANOS_PER_MILLI - 1) / NANOS_PER_MILLI);
+}
+
+void gameLoop(const EngineOps_t *ops) {
+  EngineThread_t *engine = startEngineThread(ops);
+  if (!engine) return;
+  setTraceThreadName("ui");
+  getPerfHud();
+
+  struct pollfd keyboard = {.fd = STDIN_FILENO, .events = POLLIN};
+  unsigned long long next_render = monotonicNanos();
+  bool running = true;
+  bool redraw = false;
+  KeyHold_t hold = {.key = ERR, .held = false};
+  unsigned long long version = ~0ULL;
+
+  while (running) {
+    running = pollKeys(engine, &hold, &redraw);
+
+    if (running && monotonicNanos() >= next_render) {
+      renderLatestFrame(engine, redraw, &version);
+      redraw = false;
+      next_render = monotonicNanos() + RENDER_INTERVAL_NS;
+    }
+
+    if (running) poll(&keyboard, 1, millisUntil(next_render));
+  }
+
+  stopEngineThread(engine);
+}
+
+static void renderReplayFrame(ReplayPlayer_t *player) {
+  Frame_t frame;
+  fillReplayFrame(player, &frame);
+  Viewport_t *viewport = getViewport();
+  if (viewport->follow) {
+    followViewport(viewport, frame.focus_row, frame.focus_col);
+  }
+  int *field_rows[FIELD_H];
+  int *next_rows[NEXT_H];
+  renderGUI(frameToGameInfo(&frame, field_rows, next_rows));
+}
+
+void replayLoop(const EngineOps_t *ops, const char *path) {
+  ReplayPlayer_t player;
+  if (!openReplay(&player, path, ops)) return;
+
+  struct pollfd keyboard = {.fd = STDIN_FILENO, .events = POLLIN};
+  unsigned long long last = monotonicNanos();
+  bool running = true;
+  bool paused = false;
+
+  while (running) {
+    int c;
+    while ((c = getch()) != ERR) {
+      if (handleViewportKey(c) || handleDebugKey(c) || handleHudKey(c))
+        continue;
+      UserAction_t action = getSignal(c);
+      if (action == Terminate) running = false;
+      if (action == Pause) paused = !paused;
+      if (action == Start) fastForwardReplay(&player);
+    }
+
+    unsigned long long now = monotonicNanos();
+    if (!paused) advanceReplay(&player, (now - last) / NANOS_PER_MILLI);
+    // Whole milliseconds only, the rest carries over to the next frame.
+    last = now - (now - last) % NANOS_PER_MILLI;
+
+    renderReplayFrame(&player);
+    if (running) poll(&keyboard, 1, (int)(RENDER_INTERVAL_NS / NANOS_PER_MILLI));
+  }
+
+  closeReplay(&player);
+}
+
+// Decodes every whole message in the buffer and keeps the rest for the next
+// read. Returns true when a new frame came out.
+static bool decodeSpectatorBuffer(SpectatorDecoder_t *decoder, uint8_t *buffer,
+                                  size_t *filled) {
+  bool fresh = false;
+  size_t offset = 0;
+  size_t used = 0;
+  while (offset < *filled) {
+    SpectatorResult_t result = decodeSpectatorMessage(
+        decoder, buffer + offset, *filled - offset, &used);
+    if (result == SPECTATOR_PARTIAL) break;
+    if (result == SPECTATOR_FRAME) fresh = true;
+    offset += used;
+  }
+  memmove(buffer, buffer + offset, *filled - offset);
+  *filled -= offset;
+  return fresh;
+}
+
+void spectateLoop(const char *path) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return;
+  // Live: whatever is in the stream already is history, the picture starts
+  // at the next keyframe.
+  lseek(fd, 0, SEEK_END);
+
+  SpectatorDecoder_t decoder;
+  startSpectatorDecoder(&decoder);
+  uint8_t buffer[SPECTATOR_MESSAGE_MAX * 4];
+  size_t filled = 0;
+  struct pollfd keyboard = {.fd = STDIN_FILENO, .events = POLLIN};
+  bool running = true;
+
+  while (running) {
+    bool redraw = false;
+    int c;
+    while ((c = getch()) != ERR) {
+      if (handleViewportKey(c) || handleDebugKey(c) || handleHudKey(c))
+        redraw = true;
+      else if (getSignal(c) == Terminate)
+        running = false;
+    }
+
+    ssize_t count;
+    while ((count = read(fd, buffer + filled, sizeof(buffer) - filled)) > 0) {
+      filled += (size_t)count;
+      if (decodeSpectatorBuffer(&decoder, buffer, &filled)) redraw = true;
+    }
+
+    if (redraw && decoder.synced) {
+      int *field_rows[FIELD_H];
+      int *next_rows[NEXT_H];
+      renderGUI(frameToGameInfo(&decoder.frame, field_rows, next_rows));
+    }
+    if (running) poll(&keyboard, 1, (int)(RENDER_INTERVAL_NS / NANOS_PER_MILLI));
+  }
+
+  close(fd);
+}
@@ -0,0 +1,31 @@
+#ifndef SRC_BRICK_GAME_FRONTEND_CLI_GAME_LOOP_H_
+#define SRC_BRICK_GAME_FRONTEND_CLI_GAME_LOOP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "./../../brick_game/common/engine.h"
+
+#define RENDER_INTERVAL_NS 16666667ULL  // ~60 FPS
+
+// Input, simulation and render stages of the console frontend. The game
+// runs on its own engine thread; this thread stamps and forwards keys as
+// soon as they arrive and redraws at most once per RENDER_INTERVAL_NS from
+// the newest completed frame. ncurses is not thread-safe, so input and
+// render share the terminal thread but never wait on each other's work.
+void gameLoop(const EngineOps_t *ops);
+
+// Plays a recorded session back at its own pace on this thread. Pause
+// freezes the playback, Start skips to the end and Terminate leaves.
+void replayLoop(const EngineOps_t *ops, const char *path);
+
+// Follows a spectator stream another session writes to path, from the next
+// keyframe on, until Terminate. Needs no engine: the stream carries frames.
+void spectateLoop(const char *path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_FRONTEND_CLI_GAME_LOOP_H_
@@ -0,0 +1,75 @@
+#include "frame_image.h"
+
+#include <stdbool.h>
+#include <string.h>
+
+#define PAUSE_ALPHA 150  // of the black overlay over a paused field
+
+static const CellColor_t WHITE = {255, 255, 255};
+
+CellColor_t cellColor(int cell) {
+  static const CellColor_t palette[] = {
+      {255, 255, 255}, {0, 255, 0}, {0, 0, 255}, {0, 0, 128}};
+  if (cell < 0 || cell >= (int)(sizeof(palette) / sizeof(palette[0])))
+    return WHITE;
+  return palette[cell];
+}
+
+void frameImageSize(int block, int *width, int *height) {
+  *width = (FIELD_W + 1 + NEXT_W) * block;
+  *height = FIELD_H * block;
+}
+
+static void putPixel(uint8_t *pixel, CellColor_t color, int channels) {
+  pixel[0] = color.r;
+  pixel[1] = color.g;
+  pixel[2] = color.b;
+  if (channels == 4) pixel[3] = 255;
+}
+
+static void fillBlock(uint8_t *pixels, int width, int channels, int x, int y,
+                      int block, CellColor_t color) {
+  for (int row = 0; row < block; row++) {
+    uint8_t *pixel = pixels + ((size_t)(y + row) * width + x) * channels;
+    bool edge_row = row == 0 || row == block - 1;
+    for (int col = 0; col < block; col++, pixel += channels) {
+      bool edge = edge_row || col == 0 || col == block - 1;
+      putPixel(pixel, edge ? WHITE : color, channels);
+    }
+  }
+}
+
+static void dimField(uint8_t *pixels, int width, int channels, int block) {
+  for (int y = 0; y < FIELD_H * block; y++) {
+    uint8_t *pixel = pixels + (size_t)y * width * channels;
+    for (int x = 0; x < FIELD_W * block; x++, pixel += channels) {
+      for (int c = 0; c < 3; c++)
+        pixel[c] = (uint8_t)(pixel[c] * (255 - PAUSE_ALPHA) / 255);
+    }
+  }
+}
+
+void rasterizeFrame(const Frame_t *frame, int block, int channels,
+                    uint8_t *pixels) {
+  int width, height;
+  frameImageSize(block, &width, &height);
+  memset(pixels, 255, (size_t)width * height * channels);
+
+  for (int i = 0; i < FIELD_H; i++) {
+    for (int j = 0; j < FIELD_W; j++) {
+      int cell = frame->field[i][j];
+      if (cell != 0)
+        fillBlock(pixels, width, channels, j * block, i * block, block,
+                  cellColor(cell));
+    }
+  }
+  const int next_x = (FIELD_W + 1) * block;
+  for (int i = 0; i < NEXT_H; i++) {
+    for (int j = 0; j < NEXT_W; j++) {
+      if (frame->next[i][j] != 0)
+        fillBlock(pixels, width, channels, next_x + j * block, i * block,
+                  block, cellColor(1));
+    }
+  }
+  if (frame->pause == GamePause) dimField(pixels, width, channels, block);
+}
@@ -0,0 +1,34 @@
+#ifndef SRC_BRICK_GAME_FRONTEND_COMMON_FRAME_IMAGE_H_
+#define SRC_BRICK_GAME_FRONTEND_COMMON_FRAME_IMAGE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+#include "./../../brick_game/common/frame.h"
+
+typedef struct {
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+} CellColor_t;
+
+// The desktop's palette: 1 green, 2 blue, 3 dark blue, anything else white
+// like the empty background. Cells of the next piece are all green.
+CellColor_t cellColor(int cell);
+
+// The field and, one block to its right, the next piece, block pixels per
+// cell. Occupied cells get a one pixel white outline, and a paused game is
+// dimmed, as MainWindow::renderGUI draws them.
+void frameImageSize(int block, int *width, int *height);
+// Rows top down with no padding; channels is 3 for RGB, 4 for RGBA.
+void rasterizeFrame(const Frame_t *frame, int block, int channels,
+                    uint8_t *pixels);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_FRONTEND_COMMON_FRAME_IMAGE_H_
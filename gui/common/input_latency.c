@@ -0,0 +1,29 @@
+#include "input_latency.h"
+
+#include "./../../brick_game/common/clock.h"
+
+void initInputLatency(InputLatency_t *latency) {
+  initLatencyHistogram(&latency->histogram);
+  latency->last_stamp = 0;
+}
+
+void recordFramePresented(InputLatency_t *latency,
+                          unsigned long long input_stamp) {
+  if (input_stamp == 0 || input_stamp == latency->last_stamp) return;
+
+  latency->last_stamp = input_stamp;
+  unsigned long long now = monotonicNanos();
+  if (now > input_stamp) recordLatency(&latency->histogram, now - input_stamp);
+}
+
+void printInputLatencyReport(FILE *stream, const InputLatency_t *latency) {
+  LatencySummary_t summary = summarizeLatency(&latency->histogram);
+  if (summary.count == 0) return;
+
+  fprintf(stream,
+          "key-to-screen latency over %llu inputs: "
+          "p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+          summary.count, (double)summary.p50 / NANOS_PER_MILLI,
+          (double)summary.p99 / NANOS_PER_MILLI,
+          (double)summary.max / NANOS_PER_MILLI);
+}
@@ -0,0 +1,32 @@
+#ifndef SRC_BRICK_GAME_FRONTEND_COMMON_INPUT_LATENCY_H_
+#define SRC_BRICK_GAME_FRONTEND_COMMON_INPUT_LATENCY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+
+#include "./../../brick_game/common/latency.h"
+
+// Key-to-screen latency: from the arrival stamp of an input to the moment
+// the first frame that reflects it has been flushed to the screen.
+typedef struct {
+  LatencyHistogram_t histogram;
+  unsigned long long last_stamp;
+} InputLatency_t;
+
+void initInputLatency(InputLatency_t *latency);
+
+// Call right after the frame carrying input_stamp has been flushed. Every
+// input is counted once, on the first frame that reflects it.
+void recordFramePresented(InputLatency_t *latency,
+                          unsigned long long input_stamp);
+
+void printInputLatencyReport(FILE *stream, const InputLatency_t *latency);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_FRONTEND_COMMON_INPUT_LATENCY_H_
@@ -0,0 +1,63 @@
+#include "perf_hud.h"
+
+#include <string.h>
+
+#include "./../../brick_game/common/alloc_tracker.h"
+
+void initPerfHud(PerfHud_t *hud) {
+  memset(hud, 0, sizeof(*hud));
+  readMetrics(&hud->previous);
+  hud->window_start = monotonicNanos();
+  hud->stats.allocs_per_frame = -1;
+  if (allocTrackingSupported()) startAllocTracking();
+}
+
+static LatencySummary_t summarizeWindow(PerfHud_t *hud,
+                                        MetricLatency_t latency) {
+  const LatencyHistogram_t *now = &hud->current.latencies[latency];
+  const LatencyHistogram_t *then = &hud->previous.latencies[latency];
+  LatencyHistogram_t *window = &hud->window;
+
+  for (int i = 0; i < LATENCY_BUCKETS; i++) {
+    window->counts[i] = now->counts[i] - then->counts[i];
+  }
+  window->count = now->count - then->count;
+  window->sum = now->sum - then->sum;
+  window->max = now->max;
+  return summarizeLatency(window);
+}
+
+static double perSecond(const PerfHud_t *hud, MetricCounter_t counter,
+                        double seconds) {
+  return (double)(hud->current.counters[counter] -
+                  hud->previous.counters[counter]) /
+         seconds;
+}
+
+const HudStats_t *updatePerfHud(PerfHud_t *hud) {
+  unsigned long long now = monotonicNanos();
+  if (now - hud->window_start < HUD_WINDOW_NS) return &hud->stats;
+
+  readMetrics(&hud->current);
+  double seconds = (double)(now - hud->window_start) / 1e9;
+  HudStats_t *stats = &hud->stats;
+  stats->fps = perSecond(hud, METRIC_FRAMES_RENDERED, seconds);
+  stats->ticks_per_sec = perSecond(hud, METRIC_TICKS, seconds);
+  stats->db_ops_per_sec = perSecond(hud, METRIC_DB_OPS, seconds);
+  stats->frame = summarizeWindow(hud, METRIC_RENDER_LATENCY);
+  stats->tick = summarizeWindow(hud, METRIC_TICK_LATENCY);
+
+  if (allocTrackingSupported()) {
+    unsigned long long mallocs = currentAllocStats().mallocs;
+    unsigned long long frames =
+        hud->current.counters[METRIC_FRAMES_RENDERED] -
+        hud->previous.counters[METRIC_FRAMES_RENDERED];
+    stats->allocs_per_frame =
+        frames ? (double)(mallocs - hud->window_mallocs) / (double)frames : 0;
+    hud->window_mallocs = mallocs;
+  }
+
+  hud->previous = hud->current;
+  hud->window_start = now;
+  return stats;
+}
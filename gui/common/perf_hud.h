@@ -0,0 +1,46 @@
+#ifndef SRC_BRICK_GAME_FRONTEND_COMMON_PERF_HUD_H_
+#define SRC_BRICK_GAME_FRONTEND_COMMON_PERF_HUD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#include "./../../brick_game/common/clock.h"
+#include "./../../brick_game/common/metrics.h"
+
+#define HUD_WINDOW_NS (1000 * NANOS_PER_MILLI)
+
+typedef struct {
+  double fps;
+  double ticks_per_sec;
+  double db_ops_per_sec;
+  double allocs_per_frame;  // negative where allocations are not counted
+  LatencySummary_t frame;
+  LatencySummary_t tick;
+} HudStats_t;
+
+// Live performance figures over rolling HUD_WINDOW_NS windows, diffed from
+// the metrics registry. Allocations are those of the rendering thread, the
+// one that calls initPerfHud().
+typedef struct {
+  MetricsSnapshot_t previous;
+  MetricsSnapshot_t current;
+  LatencyHistogram_t window;
+  unsigned long long window_start;
+  unsigned long long window_mallocs;
+  HudStats_t stats;
+} PerfHud_t;
+
+void initPerfHud(PerfHud_t *hud);
+
+// Call once per rendered frame; recomputes the figures when a window has
+// elapsed, otherwise returns the previous ones.
+const HudStats_t *updatePerfHud(PerfHud_t *hud);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_FRONTEND_COMMON_PERF_HUD_H_
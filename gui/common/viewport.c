@@ -0,0 +1,85 @@
+#include "viewport.h"
+
+static int clamp(int value, int low, int high) {
+  if (value > high) value = high;
+  if (value < low) value = low;
+  return value;
+}
+
+static void clampViewport(Viewport_t *viewport) {
+  int span_h = viewport->rows * viewport->scale;
+  int span_w = viewport->cols * viewport->scale;
+  viewport->top = clamp(viewport->top, 0, viewport->board_h - span_h);
+  viewport->left = clamp(viewport->left, 0, viewport->board_w - span_w);
+}
+
+void initViewport(Viewport_t *viewport, int board_h, int board_w, int rows,
+                  int cols) {
+  viewport->board_h = board_h;
+  viewport->board_w = board_w;
+  viewport->rows = rows;
+  viewport->cols = cols;
+  viewport->scale = 1;
+  viewport->top = 0;
+  viewport->left = 0;
+  viewport->follow = false;
+}
+
+void zoomViewport(Viewport_t *viewport) {
+  int center_row = viewport->top + viewport->rows * viewport->scale / 2;
+  int center_col = viewport->left + viewport->cols * viewport->scale / 2;
+
+  viewport->scale *= 2;
+  if (viewport->scale > VIEWPORT_MAX_SCALE) viewport->scale = 1;
+
+  viewport->top = center_row - viewport->rows * viewport->scale / 2;
+  viewport->left = center_col - viewport->cols * viewport->scale / 2;
+  clampViewport(viewport);
+}
+
+void scrollViewport(Viewport_t *viewport, int d_row, int d_col) {
+  viewport->top += d_row * viewport->scale;
+  viewport->left += d_col * viewport->scale;
+  clampViewport(viewport);
+}
+
+void followViewport(Viewport_t *viewport, int row, int col) {
+  int margin = VIEWPORT_MARGIN * viewport->scale;
+  int span_h = viewport->rows * viewport->scale;
+  int span_w = viewport->cols * viewport->scale;
+
+  if (row < viewport->top + margin) viewport->top = row - margin;
+  if (row >= viewport->top + span_h - margin)
+    viewport->top = row - span_h + margin + 1;
+  if (col < viewport->left + margin) viewport->left = col - margin;
+  if (col >= viewport->left + span_w - margin)
+    viewport->left = col - span_w + margin + 1;
+  clampViewport(viewport);
+}
+
+int visibleRows(const Viewport_t *viewport) {
+  int rows = (viewport->board_h + viewport->scale - 1) / viewport->scale;
+  return rows < viewport->rows ? rows : viewport->rows;
+}
+
+int visibleCols(const Viewport_t *viewport) {
+  int cols = (viewport->board_w + viewport->scale - 1) / viewport->scale;
+  return cols < viewport->cols ? cols : viewport->cols;
+}
+
+int sampleViewportCell(const Viewport_t *viewport, int **field, int row,
+                       int col) {
+  int scale = viewport->scale;
+  int top = viewport->top + row * scale;
+  int left = viewport->left + col * scale;
+  if (scale == 1) return field[top][left];
+
+  int step = scale > VIEWPORT_SAMPLES ? scale / VIEWPORT_SAMPLES : 1;
+  int value = 0;
+  for (int i = top; i < top + scale && i < viewport->board_h; i += step) {
+    for (int j = left; j < left + scale && j < viewport->board_w; j += step) {
+      if (field[i][j] > value) value = field[i][j];
+    }
+  }
+  return value;
+}
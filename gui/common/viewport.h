@@ -0,0 +1,48 @@
+#ifndef SRC_BRICK_GAME_FRONTEND_COMMON_VIEWPORT_H_
+#define SRC_BRICK_GAME_FRONTEND_COMMON_VIEWPORT_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+#define VIEWPORT_MAX_SCALE 4
+#define VIEWPORT_MARGIN 3
+#define VIEWPORT_SAMPLES 4
+
+// Window of screen cells over a board that may be much larger than the
+// screen. With scale > 1 every screen cell stands for a scale x scale block
+// of board cells. Renderers iterate only rows x cols screen cells, so their
+// cost depends on the viewport, not on the board.
+typedef struct {
+  int board_h;
+  int board_w;
+  int rows;
+  int cols;
+  int scale;
+  int top;
+  int left;
+  bool follow;
+} Viewport_t;
+
+void initViewport(Viewport_t *viewport, int board_h, int board_w, int rows,
+                  int cols);
+void zoomViewport(Viewport_t *viewport);
+void scrollViewport(Viewport_t *viewport, int d_row, int d_col);
+void followViewport(Viewport_t *viewport, int row, int col);
+
+int visibleRows(const Viewport_t *viewport);
+int visibleCols(const Viewport_t *viewport);
+
+// Value of one screen cell: the highest cell value of its board block, so
+// the snake head wins over the body and any block wins over empty space.
+// At most VIEWPORT_SAMPLES x VIEWPORT_SAMPLES board cells are read.
+int sampleViewportCell(const Viewport_t *viewport, int **field, int row,
+                       int col);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SRC_BRICK_GAME_FRONTEND_COMMON_VIEWPORT_H_
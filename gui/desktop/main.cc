@@ -1,10 +1,15 @@
 #include "mainwindow.h"
 
+#include "./../../brick_game/common/metrics.h"
+
 using namespace brickgame;
 
 int main(int argc, char *argv[]) {
   QApplication app(argc, argv);
+  startMetricsServer(argv[0]);
   MainWindow window;
   window.show();
-  return app.exec();
+  int status = app.exec();
+  stopMetricsServer();
+  return status;
 }
\ No newline at end of file
@@ -1,6 +1,11 @@
 #include "mainwindow.h"
 
+#include "./../../brick_game/common/clock.h"
+#include "./../../brick_game/common/metrics.h"
+#include "./../../brick_game/common/trace.h"
+
 #define BLOCK_SIZE 20
+#define RENDER_INTERVAL_MS 16
 
 using namespace brickgame;
 
@@ -8,15 +13,24 @@ MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
       gameStarted(false),
       gameEnded(false),
-      gamePaused(false) {
-  controller = new Controller();
+      gamePaused(false),
+      viewportChanged(false) {
+  engine = startEngineThread(getEngineOps());
+  setTraceThreadName("ui");
+  initInputLatency(&inputLatency);
+  initPerfHud(&perfHud);
   initializeGUI();
   gameTimer = new QTimer(this);
+  gameTimer->setTimerType(Qt::PreciseTimer);
   connect(gameTimer, &QTimer::timeout, this, &MainWindow::updateGUI);
-  gameTimer->start(100);
+  gameTimer->start(RENDER_INTERVAL_MS);
 }
 
-MainWindow::~MainWindow() { delete controller; }
+MainWindow::~MainWindow() {
+  stopEngineThread(engine);
+  printInputLatencyReport(stderr, &inputLatency);
+  printPerfReport(stderr);
+}
 
 void MainWindow::initializeGUI() {
   QWidget *centralWidget = new QWidget(this);
@@ -36,7 +50,11 @@ void MainWindow::initializeGUI() {
       "MOVE RIGHT    >\n"
       "MOVE DOWN     v\n"
       "MOVE UP       ^\n"
-      "EXIT        ESC\n");
+      "EXIT        ESC\n"
+      "ZOOM          Z\n"
+      "FOLLOW        F\n"
+      "SCROLL     IJKL\n"
+      "DEBUG/HUD     D/H\n");
   leftPanel->addWidget(controlsLabel);
   leftPanel->addStretch();
   mainLayout->addLayout(leftPanel);
@@ -47,6 +65,9 @@ void MainWindow::initializeGUI() {
   gameScene = new QGraphicsScene(0, 0, FIELD_W * BLOCK_SIZE,
                                  FIELD_H * BLOCK_SIZE, this);
 
+  gameScene->setBackgroundBrush(Qt::white);
+  initViewport(&viewport, FIELD_H, FIELD_W, FIELD_H, FIELD_W);
+
   gameView->setScene(gameScene);
   gameView->setFixedSize(FIELD_W * BLOCK_SIZE + 2, FIELD_H * BLOCK_SIZE + 2);
   gameView->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
@@ -75,12 +96,18 @@ void MainWindow::initializeGUI() {
   scoreLabel = new QLabel("SCORE: 0");
   levelLabel = new QLabel("LEVEL: 1");
   speedLabel = new QLabel("SPEED: 500");
+  latencyLabel = new QLabel();
+  latencyLabel->setVisible(false);
+  hudLabel = new QLabel();
+  hudLabel->setVisible(false);
 
   QVBoxLayout *infoLayout = new QVBoxLayout();
   infoLayout->addWidget(highScoreLabel);
   infoLayout->addWidget(scoreLabel);
   infoLayout->addWidget(levelLabel);
   infoLayout->addWidget(speedLabel);
+  infoLayout->addWidget(latencyLabel);
+  infoLayout->addWidget(hudLabel);
 
   rightPanel->addWidget(nextLabel, 0, Qt::AlignCenter);
   rightPanel->addWidget(nextBlockView, 0, Qt::AlignCenter);
@@ -93,32 +120,56 @@ void MainWindow::initializeGUI() {
 }
 
 void MainWindow::updateGUI() {
-  unsigned long long time_left = controller->processTimer();
-  if (time_left == 0) {
-    controller->userInput(static_cast<UserAction_t>(-1), false);
+  bool fresh = false;
+  Frame_t *frame = acquireFrame(engine, &fresh);
+  if (!fresh && !viewportChanged) return;
+  viewportChanged = false;
+
+  if (viewport.follow) {
+    followViewport(&viewport, frame->focus_row, frame->focus_col);
   }
 
-  GameInfo_t info = controller->updateCurrentState();
+  TraceSpan_t render_span;
+  beginTraceSpan(&render_span, "render");
+  updatePerfHud(&perfHud);
+  unsigned long long start = monotonicNanos();
+  int *field_rows[FIELD_H];
+  int *next_rows[NEXT_H];
+  GameInfo_t info = frameToGameInfo(frame, field_rows, next_rows);
+  renderGUI(info);
+
+  // Paint now rather than on the next event loop pass, so the latency is
+  // measured when the frame actually reaches the screen.
+  TraceSpan_t paint_span;
+  beginTraceSpan(&paint_span, "paint");
+  gameView->viewport()->repaint();
+  endTraceSpan(&paint_span);
+  recordFramePresented(&inputLatency, frame->input_stamp);
+  recordMetricLatency(METRIC_RENDER_LATENCY, monotonicNanos() - start);
+  addMetricCounter(METRIC_FRAMES_RENDERED, 1);
+  updateLatencyOverlay();
+  updateHudOverlay();
+  endTraceSpan(&render_span);
 
   if (info.pause == GOTryAgain || info.pause == Win) {
-    gameEnded = true;
-    gameTimer->stop();
-
-    QString message = (info.pause == Win) ? "YOU WIN" : "GAME OVER";
-    if (QMessageBox::question(this, message, "TRY AGAIN?",
-                              QMessageBox::Yes | QMessageBox::No) ==
-        QMessageBox::Yes) {
-      controller->userInput(Start, false);
-      gameEnded = false;
-      gameTimer->start(100);
-    } else {
-      controller->freeGameInfo(&info);
-      quitApp();
-    }
+    showGameOverDialog(info.pause);
   }
+}
 
-  renderGUI(info);
-  controller->freeGameInfo(&info);
+void MainWindow::showGameOverDialog(int pause) {
+  gameEnded = true;
+  gameTimer->stop();
+
+  QString message = (pause == Win) ? "YOU WIN" : "GAME OVER";
+  if (QMessageBox::question(this, message, "TRY AGAIN?",
+                            QMessageBox::Yes | QMessageBox::No) ==
+      QMessageBox::Yes) {
+    submitInput(engine, Start, false);
+    gameEnded = false;
+    gameTimer->start(RENDER_INTERVAL_MS);
+  } else {
+    quitApp();
+  }
 }
 
 void MainWindow::renderGUI(GameInfo_t info) {
@@ -132,22 +183,17 @@ void MainWindow::renderGUI(GameInfo_t info) {
   gameScene->clear();
   nextBlockScene->clear();
 
-  for (int i = 0; i < FIELD_H; ++i) {
-    for (int j = 0; j < FIELD_W; ++j) {
-      QColor color = Qt::white;
-      switch (info.field[i][j]) {
-        case 1:
-          color = Qt::green;
-          break;
-        case 2:
-          color = Qt::blue;
-          break;
-        case 3:
-          color = Qt::darkBlue;
-          break;
-      }
-
-      QBrush brush(color);
+  // Empty cells are the scene background; only the visible, occupied cells
+  // of the viewport become scene items.
+  const int rows = visibleRows(&viewport), cols = visibleCols(&viewport);
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      int cell = sampleViewportCell(&viewport, info.field, i, j);
+      if (cell == 0) continue;
+
+      // Shared with the offline renderer, so videos match the window.
+      CellColor_t rgb = cellColor(cell);
+      QBrush brush(QColor(rgb.r, rgb.g, rgb.b));
       QPen pen(Qt::white);
       gameScene->addRect(j * BLOCK_SIZE, i * BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE,
                          pen, brush);
@@ -180,16 +226,41 @@ void MainWindow::renderGUI(GameInfo_t info) {
 }
 
 void MainWindow::keyPressEvent(QKeyEvent *event) {
+  if (handleViewportKey(event->key())) {
+    viewportChanged = true;
+    event->accept();
+    return;
+  }
+
+  if (event->key() == Qt::Key_D) {
+    latencyLabel->setVisible(!latencyLabel->isVisible());
+    updateLatencyOverlay();
+    event->accept();
+    return;
+  }
+
+  if (event->key() == Qt::Key_H) {
+    hudLabel->setVisible(!hudLabel->isVisible());
+    updateHudOverlay();
+    event->accept();
+    return;
+  }
+
+  // Game keys are reported as press and release; the engine repeats held
+  // actions itself, so the window system's auto-repeat is dropped.
+  if (isHoldableKey(event->key())) {
+    if (!event->isAutoRepeat()) {
+      handleUserInput(event->key(), true, monotonicNanos());
+    }
+    event->accept();
+    return;
+  }
+
   switch (event->key()) {
-    case Qt::Key_Left:
-    case Qt::Key_Right:
-    case Qt::Key_Up:
-    case Qt::Key_Down:
-    case Qt::Key_Space:
     case Qt::Key_Return:
     case Qt::Key_P:
     case Qt::Key_Escape:
-      handleUserInput(event->key());
+      handleUserInput(event->key(), false, monotonicNanos());
       event->accept();
       return;
     default:
@@ -198,16 +269,49 @@ void MainWindow::keyPressEvent(QKeyEvent *event) {
   QMainWindow::keyPressEvent(event);
 }
 
-void MainWindow::handleUserInput(int input) {
-  UserAction_t action = getSignal(input);
+void MainWindow::keyReleaseEvent(QKeyEvent *event) {
+  if (isHoldableKey(event->key())) {
+    if (!event->isAutoRepeat()) {
+      handleUserInput(event->key(), false, monotonicNanos());
+    }
+    event->accept();
+    return;
+  }
+  QMainWindow::keyReleaseEvent(event);
+}
+
+bool MainWindow::isHoldableKey(int input) const {
+  switch (input) {
+    case Qt::Key_Left:
+    case Qt::Key_Right:
+    case Qt::Key_Up:
+    case Qt::Key_Down:
+    case Qt::Key_Space:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void MainWindow::handleUserInput(int input, bool hold,
+                                 unsigned long long stamp) {
+  TraceSpan_t span;
+  beginTraceSpan(&span, "input");
+  submitUserInput(input, hold, stamp);
+  endTraceSpan(&span);
+}
+
+void MainWindow::submitUserInput(int input, bool hold,
+                                 unsigned long long stamp) {
+  InputEvent_t event = {getSignal(input), hold, stamp};
 
-  if (action == Terminate) {
-    controller->userInput(action, false);
+  if (event.action == Terminate) {
+    submitInputEvent(engine, &event);
     quitApp();
     return;
   }
 
-  if (action == Pause) {
+  if (event.action == Pause) {
     if (gamePaused) {
       gamePaused = false;
     } else {
@@ -215,11 +319,70 @@ void MainWindow::handleUserInput(int input) {
     }
   }
 
-  controller->userInput(action, false);
+  submitInputEvent(engine, &event);
 
-  if (action == Start) {
+  if (event.action == Start) {
     gameStarted = true;
-    updateGUI();
+  }
+}
+
+void MainWindow::updateLatencyOverlay() {
+  if (!latencyLabel->isVisible()) return;
+
+  const double millis = NANOS_PER_MILLI;
+  LatencySummary_t latency = summarizeLatency(&inputLatency.histogram);
+  latencyLabel->setText(QString("KEY LAG p50/p99/max:\n%1/%2/%3 ms")
+                            .arg(latency.p50 / millis, 0, 'f', 1)
+                            .arg(latency.p99 / millis, 0, 'f', 1)
+                            .arg(latency.max / millis, 0, 'f', 1));
+}
+
+void MainWindow::updateHudOverlay() {
+  if (!hudLabel->isVisible()) return;
+
+  const double millis = NANOS_PER_MILLI;
+  const HudStats_t &stats = perfHud.stats;
+  QString allocs = stats.allocs_per_frame < 0
+                       ? QString("n/a")
+                       : QString::number(stats.allocs_per_frame, 'f', 1);
+  hudLabel->setText(QString("FPS %1  TPS %2\n"
+                            "FRAME p50/p99: %3/%4 ms\n"
+                            "TICK p50/p99: %5/%6 ms\n"
+                            "ALLOCS/FRAME: %7\n"
+                            "DB OPS/S: %8")
+                        .arg(stats.fps, 0, 'f', 1)
+                        .arg(stats.ticks_per_sec, 0, 'f', 1)
+                        .arg(stats.frame.p50 / millis, 0, 'f', 2)
+                        .arg(stats.frame.p99 / millis, 0, 'f', 2)
+                        .arg(stats.tick.p50 / millis, 0, 'f', 3)
+                        .arg(stats.tick.p99 / millis, 0, 'f', 3)
+                        .arg(allocs)
+                        .arg(stats.db_ops_per_sec, 0, 'f', 1));
+}
+
+bool MainWindow::handleViewportKey(int input) {
+  switch (input) {
+    case Qt::Key_Z:
+      zoomViewport(&viewport);
+      return true;
+    case Qt::Key_F:
+      viewport.follow = !viewport.follow;
+      return true;
+    case Qt::Key_I:
+      scrollViewport(&viewport, -1, 0);
+      return true;
+    case Qt::Key_J:
+      scrollViewport(&viewport, 0, -1);
+      return true;
+    case Qt::Key_K:
+      scrollViewport(&viewport, 1, 0);
+      return true;
+    case Qt::Key_L:
+      scrollViewport(&viewport, 0, 1);
+      return true;
+
+    default:
+      return false;
   }
 }
 
@@ -14,7 +14,12 @@
 #include <QWidget>
 
 #include "./../../brick_game.h"
-#include "./../../brick_game/tetris/controller.h"
+#include "./../../brick_game/common/engine.h"
+#include "./../../brick_game/common/perf_counters.h"
+#include "./../common/frame_image.h"
+#include "./../common/input_latency.h"
+#include "./../common/perf_hud.h"
+#include "./../common/viewport.h"
 
 namespace brickgame {
 class MainWindow : public QMainWindow {
@@ -33,11 +38,18 @@ class MainWindow : public QMainWindow {
  private:
   void initializeGUI();
   void keyPressEvent(QKeyEvent *event) override;
+  void keyReleaseEvent(QKeyEvent *event) override;
   UserAction_t getSignal(int input) const;
-  void handleUserInput(int input);
+  bool isHoldableKey(int input) const;
+  void handleUserInput(int input, bool hold, unsigned long long stamp);
+  void submitUserInput(int input, bool hold, unsigned long long stamp);
+  bool handleViewportKey(int input);
+  void updateLatencyOverlay();
+  void updateHudOverlay();
   void renderGUI(GameInfo_t info);
+  void showGameOverDialog(int pause);
 
-  Controller *controller;
+  EngineThread_t *engine;
   QGraphicsView *gameView;
   QGraphicsScene *gameScene;
   QTimer *gameTimer;
@@ -49,10 +61,16 @@ class MainWindow : public QMainWindow {
   QLabel *scoreLabel;
   QLabel *levelLabel;
   QLabel *speedLabel;
+  QLabel *latencyLabel;
+  QLabel *hudLabel;
 
   bool gameStarted;
   bool gameEnded;
   bool gamePaused;
+  bool viewportChanged;
+  Viewport_t viewport;
+  InputLatency_t inputLatency;
+  PerfHud_t perfHud;
 };
 
 }  // namespace brickgame
@@ -0,0 +1,101 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Allocation Tests - steady-state engine calls must not touch the heap
+// =============================================================================
+
+TEST(AllocTrackerTest, CountsOnlyWhileTracking) {
+  if (!allocTrackingSupported()) GTEST_SKIP();
+
+  delete new int(1);
+  startAllocTracking();
+  int *value = new int(2);
+  std::vector<char> buffer(100);
+  delete value;
+  AllocStats_t stats = stopAllocTracking();
+  delete new int(3);
+
+  EXPECT_EQ(stats.mallocs, 2ULL);
+  EXPECT_EQ(stats.frees, 1ULL);
+  EXPECT_GE(stats.bytes, sizeof(int) + 100);
+  EXPECT_EQ(currentAllocStats().mallocs, 2ULL);
+}
+
+TEST(AllocTrackerTest, RejectsBadAlignment) {
+  if (!allocTrackingSupported()) GTEST_SKIP();
+
+  // volatile keeps the compiler from folding the calls.
+  volatile size_t odd = 24, small = sizeof(void *) / 2, good = 64;
+  void *memory = nullptr;
+  startAllocTracking();
+  EXPECT_EQ(posix_memalign(&memory, odd, 16), EINVAL);
+  EXPECT_EQ(posix_memalign(&memory, small, 16), EINVAL);
+  EXPECT_EQ(memory, nullptr);
+  errno = 0;
+  EXPECT_EQ(aligned_alloc(odd, 48), nullptr);
+  EXPECT_EQ(errno, EINVAL);
+  EXPECT_EQ(stopAllocTracking().mallocs, 0ULL);
+
+  ASSERT_EQ(posix_memalign(&memory, good, 16), 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(memory) % good, 0u);
+  free(memory);
+}
+
+class SnakeAllocTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (!allocTrackingSupported()) GTEST_SKIP();
+    controller = std::make_unique<Controller>();
+    controller->userInput(Start, false);
+  }
+
+  // The snake starts at (10, 5) heading up. If the apple lies on that way,
+  // it turns left instead, so the measured ticks never eat.
+  void steerClearOfApple() {
+    Frame_t frame;
+    controller->fillFrame(&frame);
+    for (int row = 0; row < 10; ++row) {
+      if (frame.field[row][5] == 1) controller->userInput(Left, false);
+    }
+  }
+
+  std::unique_ptr<Controller> controller;
+};
+
+TEST_F(SnakeAllocTest, SnapshotDoesNotAllocate) {
+  Frame_t frame;
+  startAllocTracking();
+  controller->fillFrame(&frame);
+  EXPECT_EQ(stopAllocTracking().mallocs, 0ULL);
+}
+
+TEST_F(SnakeAllocTest, InputDoesNotAllocate) {
+  startAllocTracking();
+  controller->userInput(Left, false);
+  controller->userInput(Action, true);
+  controller->userInput(Action, false);
+  controller->userInput(Pause, false);
+  controller->userInput(Pause, false);
+  EXPECT_EQ(stopAllocTracking().mallocs, 0ULL);
+}
+
+TEST_F(SnakeAllocTest, MoveTickDoesNotAllocate) {
+  steerClearOfApple();
+  controller->userInput(Action, true);
+
+  for (int i = 0; i < 3; ++i) {
+    Frame_t before, after;
+    controller->fillFrame(&before);
+    std::this_thread::sleep_for(std::chrono::milliseconds(25));
+
+    startAllocTracking();
+    controller->processTimer();
+    AllocStats_t stats = stopAllocTracking();
+
+    controller->fillFrame(&after);
+    EXPECT_NE(before.focus_row * FIELD_W + before.focus_col,
+              after.focus_row * FIELD_W + after.focus_col);
+    EXPECT_EQ(stats.mallocs, 0ULL);
+    EXPECT_EQ(stats.frees, 0ULL);
+  }
+}
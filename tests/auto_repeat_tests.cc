@@ -0,0 +1,54 @@
+#include "test_includes.h"
+
+class AutoRepeatTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    initAutoRepeat(&repeat);
+    setAutoRepeatRates(&repeat, 100, 20);
+  }
+  AutoRepeat_t repeat;
+};
+
+TEST_F(AutoRepeatTest, TapsAreAlwaysApplied) {
+  EXPECT_TRUE(acceptHeldInput(&repeat, Left, false));
+  EXPECT_TRUE(acceptHeldInput(&repeat, Left, false));
+  EXPECT_TRUE(acceptHeldInput(&repeat, (UserAction_t)-1, false));
+  EXPECT_FALSE(isInputHeld(&repeat, Left));
+}
+
+TEST_F(AutoRepeatTest, PressAppliesOnceAndReleaseNever) {
+  EXPECT_TRUE(acceptHeldInput(&repeat, Right, true));
+  EXPECT_TRUE(isInputHeld(&repeat, Right));
+  EXPECT_FALSE(acceptHeldInput(&repeat, Right, true));
+
+  EXPECT_TRUE(acceptHeldInput(&repeat, Action, false));
+  EXPECT_TRUE(isInputHeld(&repeat, Right));
+
+  EXPECT_FALSE(acceptHeldInput(&repeat, Right, false));
+  EXPECT_FALSE(isInputHeld(&repeat, Right));
+}
+
+TEST_F(AutoRepeatTest, RepeatsFollowDelayThenRate) {
+  acceptHeldInput(&repeat, Left, true);
+  startAutoRepeat(&repeat, Left, 1000);
+
+  EXPECT_EQ(autoRepeatTimeLeft(&repeat, 1000), 100ULL);
+  EXPECT_EQ(dueAutoRepeats(&repeat, 1099), 0);
+  EXPECT_EQ(dueAutoRepeats(&repeat, 1100), 1);
+  EXPECT_EQ(autoRepeatTimeLeft(&repeat, 1100), 20ULL);
+  EXPECT_EQ(dueAutoRepeats(&repeat, 1165), 3);
+  EXPECT_EQ(autoRepeatTimeLeft(&repeat, 1165), 15ULL);
+  EXPECT_EQ(dueAutoRepeats(&repeat, 100000), MAX_REPEATS_PER_TICK);
+
+  acceptHeldInput(&repeat, Left, false);
+  EXPECT_EQ(dueAutoRepeats(&repeat, 200000), 0);
+  EXPECT_EQ(autoRepeatTimeLeft(&repeat, 200000), NO_TIMEOUT);
+}
+
+TEST_F(AutoRepeatTest, ReleasingAnotherKeyKeepsRepeating) {
+  acceptHeldInput(&repeat, Left, true);
+  startAutoRepeat(&repeat, Left, 0);
+  acceptHeldInput(&repeat, Action, true);
+  acceptHeldInput(&repeat, Action, false);
+  EXPECT_EQ(dueAutoRepeats(&repeat, 100), 1);
+}
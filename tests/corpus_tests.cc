@@ -0,0 +1,189 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Corpus Tests - replays packed into columns, scanned on threads
+// =============================================================================
+
+namespace {
+
+const char *kCorpusPath = "corpus_test.corpus";
+const char *kSessionPath = "corpus_session.bin";
+
+// Records ticks of snake on a virtual clock, turning every few ticks, and
+// steps after inputs and claims the last frame the way the engine does.
+void recordSession(const char *path, unsigned long long seed, int ticks) {
+  unsigned long long clock = 1000;
+  setGameClock(&clock);
+  suspendScoreStores(true);
+  const EngineOps_t *ops = getEngineOps();
+  void *game = ops->create();
+  ops->seed(game, seed);
+  ReplayRecorder_t recorder;
+  startReplayRecording(&recorder, path, ops, game, seed, clock, 16);
+
+  const UserAction_t turns[] = {Left, Down, Right, Up};
+  Frame_t frame;
+  recordReplayEntry(&recorder, clock, Start, false);
+  ops->input(game, Start, false);
+  recordReplayEntry(&recorder, clock, REPLAY_ADVANCE, false);
+  stepGameClock(ops, game);
+  for (int i = 0; i < ticks; ++i) {
+    clock += INIT_SPEED;
+    if (i % 3 == 0) {
+      recordReplayEntry(&recorder, clock, turns[i / 3 % 4], false);
+      ops->input(game, turns[i / 3 % 4], false);
+    }
+    recordReplayEntry(&recorder, clock, REPLAY_ADVANCE, false);
+    stepGameClock(ops, game);
+  }
+  ops->fill(game, &frame);
+  claimReplayResult(&recorder, &frame);
+
+  stopReplayRecording(&recorder);
+  ops->destroy(game);
+  suspendScoreStores(false);
+  setGameClock(nullptr);
+}
+
+uint8_t entryCode(int action) {
+  return static_cast<uint8_t>((action + 4) << 1);
+}
+
+}  // namespace
+
+TEST(CorpusTest, PacksReplaysIntoAlignedColumns) {
+  CorpusWriter_t writer;
+  ASSERT_TRUE(startCorpus(&writer, kCorpusPath, "snake"));
+  ReplayCheck_t checks[3];
+  for (int i = 0; i < 3; ++i) {
+    recordSession(kSessionPath, 11 + i, 40 + 20 * i);
+    ASSERT_EQ(verifyReplay(kSessionPath, getEngineOps(), &checks[i]),
+              REPLAY_VERIFIED);
+    ASSERT_TRUE(addReplayToCorpus(&writer, kSessionPath, getEngineOps()));
+  }
+  EXPECT_FALSE(addReplayToCorpus(&writer, "missing_replay.bin",
+                                 getEngineOps()));
+  ASSERT_TRUE(finishCorpus(&writer));
+
+  Corpus_t corpus;
+  ASSERT_TRUE(openCorpus(&corpus, kCorpusPath));
+  ASSERT_EQ(corpus.header->sessions, 3u);
+  EXPECT_STREQ(corpus.header->game, "snake");
+  EXPECT_EQ(corpus.header->codes_offset % CORPUS_ALIGN, 0u);
+  EXPECT_EQ(corpus.header->deltas_offset % CORPUS_ALIGN, 0u);
+
+  uint64_t entries = 0;
+  for (int i = 0; i < 3; ++i) {
+    const CorpusSession_t &session = corpus.sessions[i];
+    EXPECT_EQ(session.seed, 11u + i);
+    EXPECT_EQ(session.first_entry, entries);
+    EXPECT_EQ(session.entries, checks[i].entries);
+    EXPECT_EQ(session.millis, checks[i].millis);
+    EXPECT_EQ(session.score, checks[i].score);
+    EXPECT_EQ(session.flags, CORPUS_CLAIMED | CORPUS_VERIFIED);
+    // Start and its tick, then a turn and a tick on every third tick.
+    int ticks = 40 + 20 * i;
+    EXPECT_EQ(session.inputs, 1u + (ticks + 2) / 3);
+    EXPECT_EQ(corpus.codes[session.first_entry], entryCode(Start));
+    EXPECT_EQ(corpus.codes[session.first_entry + 1],
+              entryCode(REPLAY_ADVANCE));
+    EXPECT_EQ(corpus.deltas[session.first_entry + 1], 0u);
+    EXPECT_EQ(corpus.codes[session.first_entry + 2], entryCode(Left));
+    EXPECT_EQ(corpus.codes[session.first_entry + 3],
+              entryCode(REPLAY_ADVANCE));
+    EXPECT_EQ(corpus.deltas[session.first_entry + 2], (uint32_t)INIT_SPEED);
+    entries += session.entries;
+  }
+  EXPECT_EQ(corpus.header->entries, entries);
+  closeCorpus(&corpus);
+
+  // A replay is not a corpus, and neither is a truncated corpus.
+  EXPECT_FALSE(openCorpus(&corpus, kSessionPath));
+  EXPECT_EQ(truncate(kCorpusPath, CORPUS_ALIGN * 2), 0);
+  EXPECT_FALSE(openCorpus(&corpus, kCorpusPath));
+  std::remove(kSessionPath);
+  std::remove(kCorpusPath);
+}
+
+TEST(CorpusTest, ThreadedScanMatchesSerialScan) {
+  // Enough sessions for every worker to take several chunks.
+  const int kSessions = CORPUS_SCAN_CHUNK * 5 + 7;
+  CorpusWriter_t writer;
+  ASSERT_TRUE(startCorpus(&writer, kCorpusPath, "snake"));
+  std::vector<uint8_t> codes;
+  std::vector<uint32_t> deltas;
+  uint64_t moves = 0, zero_scores = 0, top_levels = 0;
+  for (int i = 0; i < kSessions; ++i) {
+    size_t length = 1 + i % 13;
+    codes.assign(length, entryCode(REPLAY_ADVANCE));
+    deltas.assign(length, 100);
+    codes[0] = entryCode(Start);
+    for (size_t j = 2; j < length; j += 3, ++moves) codes[j] = entryCode(Left);
+    CorpusSession_t session = {};
+    session.millis = 60000;
+    session.inputs = static_cast<uint32_t>(i % 50);
+    session.score = i % 300;
+    session.level = i % 14;
+    session.pieces[i % CORPUS_PIECE_TYPES] = 2;
+    zero_scores += session.score == 0;
+    top_levels += session.level >= CORPUS_LEVELS - 1;
+    ASSERT_TRUE(addCorpusSession(&writer, &session, codes.data(),
+                                 deltas.data(), length));
+  }
+  ASSERT_TRUE(finishCorpus(&writer));
+
+  Corpus_t corpus;
+  ASSERT_TRUE(openCorpus(&corpus, kCorpusPath));
+  CorpusStats_t serial, threaded;
+  scanCorpus(&corpus, 1, &serial);
+  scanCorpus(&corpus, 4, &threaded);
+  EXPECT_EQ(std::memcmp(&serial, &threaded, sizeof(serial)), 0);
+
+  EXPECT_EQ(serial.sessions, (uint64_t)kSessions);
+  EXPECT_EQ(serial.verified, 0u);
+  EXPECT_EQ(serial.entries, corpus.header->entries);
+  EXPECT_EQ(serial.actions[Start], (uint64_t)kSessions);
+  EXPECT_EQ(serial.actions[Left], moves);
+  uint64_t pieces = 0;
+  for (uint64_t count : serial.pieces) pieces += count;
+  EXPECT_EQ(pieces, 2u * kSessions);
+  EXPECT_EQ(serial.scores[0], zero_scores);
+  EXPECT_EQ(serial.levels[CORPUS_LEVELS - 1], top_levels);
+  // A minute each, so actions per minute are the inputs: 0 to 49.
+  EXPECT_EQ(serial.apm[0] + serial.apm[1] + serial.apm[2],
+            (uint64_t)kSessions);
+  EXPECT_GT(serial.apm[2], 0u);
+  closeCorpus(&corpus);
+  std::remove(kCorpusPath);
+}
+
+TEST(CorpusTest, RejectsOffsetsThatWrap) {
+  CorpusWriter_t writer;
+  ASSERT_TRUE(startCorpus(&writer, kCorpusPath, "snake"));
+  recordSession(kSessionPath, 5, 30);
+  ASSERT_TRUE(addReplayToCorpus(&writer, kSessionPath, getEngineOps()));
+  ASSERT_TRUE(finishCorpus(&writer));
+
+  Corpus_t corpus;
+  ASSERT_TRUE(openCorpus(&corpus, kCorpusPath));
+  CorpusHeader_t header = *corpus.header;
+  closeCorpus(&corpus);
+
+  // Each patch would pass an unchecked offset + length sum once it wraps.
+  uint64_t wrap = UINT64_MAX - CORPUS_ALIGN + 1;
+  const size_t fields[] = {offsetof(CorpusHeader_t, sessions_offset),
+                           offsetof(CorpusHeader_t, codes_offset),
+                           offsetof(CorpusHeader_t, deltas_offset)};
+  for (size_t field : fields) {
+    CorpusHeader_t patched = header;
+    std::memcpy(reinterpret_cast<char *>(&patched) + field, &wrap,
+                sizeof(wrap));
+    std::fstream file(kCorpusPath,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    file.write(reinterpret_cast<const char *>(&patched), sizeof(patched));
+    file.close();
+    EXPECT_FALSE(openCorpus(&corpus, kCorpusPath)) << field;
+  }
+  std::remove(kSessionPath);
+  std::remove(kCorpusPath);
+}
@@ -0,0 +1,199 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Engine Tests - Testing the simulation thread and frame publication
+// =============================================================================
+
+namespace {
+
+template <typename Predicate>
+bool waitForFrame(const EngineThread_t* engine, Frame_t* frame,
+                  Predicate predicate) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (readFrame(engine, frame) != 0 && predicate(*frame)) return true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+}  // namespace
+
+TEST(FrameSeqlockTest, ReadersNeverSeeTornFrames) {
+  FrameSeqlock_t lock;
+  initFrameSeqlock(&lock);
+
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    Frame_t frame = {};
+    for (int n = 1; n <= 20000; ++n) {
+      for (auto& row : frame.field) std::fill(row, row + FIELD_W, n);
+      frame.score = n;
+      frame.frame_id = n;
+      publishFrame(&lock, &frame);
+    }
+    done = true;
+  });
+
+  Frame_t copy;
+  while (!done) {
+    readPublishedFrame(&lock, &copy);
+    for (const auto& row : copy.field) {
+      for (int cell : row) ASSERT_EQ(cell, copy.score);
+    }
+  }
+  writer.join();
+
+  EXPECT_EQ(readPublishedFrame(&lock, &copy), 20000u);
+}
+
+TEST(TripleBufferTest, ReaderSeesNewestCompletedFrame) {
+  TripleBuffer_t buffer;
+  initTripleBuffer(&buffer);
+
+  bool fresh = true;
+  getFrontFrame(&buffer, &fresh);
+  EXPECT_FALSE(fresh);
+
+  for (int n = 1; n <= 3; ++n) {
+    getBackFrame(&buffer)->frame_id = n;
+    swapBackFrame(&buffer);
+  }
+
+  Frame_t* front = getFrontFrame(&buffer, &fresh);
+  EXPECT_TRUE(fresh);
+  EXPECT_EQ(front->frame_id, 3u);
+
+  front = getFrontFrame(&buffer, &fresh);
+  EXPECT_FALSE(fresh);
+  EXPECT_EQ(front->frame_id, 3u);
+}
+
+TEST(TripleBufferTest, WriterNeverTouchesFrontFrame) {
+  TripleBuffer_t buffer;
+  initTripleBuffer(&buffer);
+
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    for (int n = 1; n <= 20000; ++n) {
+      Frame_t* frame = getBackFrame(&buffer);
+      for (auto& row : frame->field) std::fill(row, row + FIELD_W, n);
+      frame->score = n;
+      swapBackFrame(&buffer);
+    }
+    done = true;
+  });
+
+  int last_seen = 0;
+  while (!done) {
+    const Frame_t* frame = getFrontFrame(&buffer, nullptr);
+    for (const auto& row : frame->field) {
+      for (int cell : row) ASSERT_EQ(cell, frame->score);
+    }
+    ASSERT_GE(frame->score, last_seen);
+    last_seen = frame->score;
+  }
+  writer.join();
+}
+
+TEST(FrameTest, GameInfoViewSharesFrameStorage) {
+  Frame_t frame = {};
+  frame.field[3][4] = 2;
+  frame.next[1][1] = 1;
+  frame.level = 7;
+
+  int* field_rows[FIELD_H];
+  int* next_rows[NEXT_H];
+  GameInfo_t info = frameToGameInfo(&frame, field_rows, next_rows);
+
+  EXPECT_EQ(info.field[3][4], 2);
+  EXPECT_EQ(info.next[1][1], 1);
+  EXPECT_EQ(info.level, 7);
+  EXPECT_EQ(&info.field[0][0], &frame.field[0][0]);
+}
+
+TEST(EngineThreadTest, PublishesInitialFrame) {
+  EngineThread_t* engine = startEngineThread(getEngineOps());
+  ASSERT_NE(engine, nullptr);
+
+  Frame_t frame;
+  EXPECT_TRUE(waitForFrame(engine, &frame, [](const Frame_t& f) {
+    return f.pause == StartMenu;
+  }));
+
+  stopEngineThread(engine);
+}
+
+TEST(EngineThreadTest, AppliesSubmittedInput) {
+  EngineThread_t* engine = startEngineThread(getEngineOps());
+  ASSERT_NE(engine, nullptr);
+  Frame_t frame;
+
+  EXPECT_TRUE(submitInput(engine, Start, false));
+  EXPECT_TRUE(waitForFrame(engine, &frame, [](const Frame_t& f) {
+    return f.pause == Empty;
+  }));
+
+  EXPECT_TRUE(submitInput(engine, Pause, false));
+  EXPECT_TRUE(waitForFrame(engine, &frame, [](const Frame_t& f) {
+    return f.pause == GamePause;
+  }));
+
+  stopEngineThread(engine);
+}
+
+TEST(EngineThreadTest, AdvancesOnItsOwnClock) {
+  EngineThread_t* engine = startEngineThread(getEngineOps());
+  ASSERT_NE(engine, nullptr);
+  Frame_t frame;
+
+  submitInput(engine, Start, false);
+  ASSERT_TRUE(waitForFrame(engine, &frame, [](const Frame_t& f) {
+    return f.pause == Empty && f.field[10][5] == 3;
+  }));
+
+  // Nobody polls the engine: the head still moves up on the engine's timer.
+  EXPECT_TRUE(waitForFrame(engine, &frame, [](const Frame_t& f) {
+    return f.field[9][5] == 3;
+  }));
+
+  stopEngineThread(engine);
+}
+
+TEST(EngineThreadTest, RenderStageGetsStampedFrames) {
+  EngineThread_t* engine = startEngineThread(getEngineOps());
+  ASSERT_NE(engine, nullptr);
+
+  InputEvent_t start = {Start, false, 42};
+  ASSERT_TRUE(submitInputEvent(engine, &start));
+
+  bool fresh = false;
+  Frame_t* frame = nullptr;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+  while (std::chrono::steady_clock::now() < deadline) {
+    frame = acquireFrame(engine, &fresh);
+    if (frame->input_stamp == 42) break;
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_NE(frame, nullptr);
+  EXPECT_EQ(frame->input_stamp, 42u);
+  EXPECT_EQ(frame->pause, Empty);
+
+  stopEngineThread(engine);
+}
+
+TEST(EngineThreadTest, FrameIdsIncrease) {
+  EngineThread_t* engine = startEngineThread(getEngineOps());
+  ASSERT_NE(engine, nullptr);
+  Frame_t frame;
+
+  ASSERT_TRUE(waitForFrame(engine, &frame, [](const Frame_t&) { return true; }));
+  unsigned long long first = frame.frame_id;
+
+  submitInput(engine, Start, false);
+  ASSERT_TRUE(waitForFrame(engine, &frame, [first](const Frame_t& f) {
+    return f.frame_id > first;
+  }));
+
+  stopEngineThread(engine);
+}
@@ -0,0 +1,83 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Event Ring Tests - binary gameplay flight recorder
+// =============================================================================
+
+static bool readDump(const char *path, EventDumpHeader_t *header,
+                     std::vector<GameEvent_t> *events) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in.read(reinterpret_cast<char *>(header), sizeof(*header))) return false;
+  events->resize(header->capacity);
+  return static_cast<bool>(
+      in.read(reinterpret_cast<char *>(events->data()),
+              static_cast<std::streamsize>(events->size() *
+                                           sizeof(GameEvent_t))));
+}
+
+TEST(EventRingTest, KeepsNewestEventsWithTickStamps) {
+  auto ring = std::make_unique<EventRing_t>();
+  initEventRing(ring.get(), "event_ring_test");
+
+  for (int i = 0; i < EVENT_RING_SIZE + 10; ++i) {
+    if (i % 2 == 0) advanceEventTick(ring.get());
+    emitGameEvent(ring.get(), EVENT_LINES_CLEARED, 1, 0, i);
+  }
+  releaseEventRing(ring.get());
+
+  EXPECT_EQ(ring->head, static_cast<uint32_t>(EVENT_RING_SIZE + 10));
+  const GameEvent_t &newest = ring->events[(EVENT_RING_SIZE + 9) %
+                                           EVENT_RING_SIZE];
+  EXPECT_EQ(newest.sequence, static_cast<uint32_t>(EVENT_RING_SIZE + 10));
+  EXPECT_EQ(newest.value, EVENT_RING_SIZE + 9);
+  EXPECT_EQ(newest.tick, static_cast<uint32_t>((EVENT_RING_SIZE + 10) / 2));
+  // Slot 10 now holds the oldest surviving event.
+  EXPECT_EQ(ring->events[10].sequence, 11u);
+}
+
+TEST(EventRingTest, DumpRoundTrips) {
+  auto ring = std::make_unique<EventRing_t>();
+  initEventRing(ring.get(), "event_ring_dump_test");
+  emitGameEvent(ring.get(), EVENT_PIECE_SPAWNED, 3, 2, 0);
+  advanceEventTick(ring.get());
+  emitGameEvent(ring.get(), EVENT_SCORE_PERSISTED, 0, 0, 1500);
+  ASSERT_TRUE(dumpEventRing(ring.get()));
+  releaseEventRing(ring.get());
+
+  EventDumpHeader_t header;
+  std::vector<GameEvent_t> events;
+  ASSERT_TRUE(readDump(ring->path, &header, &events));
+  std::remove(ring->path);
+
+  EXPECT_EQ(std::string(header.magic, 4), EVENT_DUMP_MAGIC);
+  EXPECT_EQ(header.event_size, sizeof(GameEvent_t));
+  EXPECT_EQ(header.head, 2u);
+  EXPECT_EQ(events[0].type, EVENT_PIECE_SPAWNED);
+  EXPECT_EQ(events[0].a, 3);
+  EXPECT_EQ(events[0].b, 2);
+  EXPECT_EQ(events[1].tick, 1u);
+  EXPECT_EQ(events[1].value, 1500);
+  EXPECT_STREQ(gameEventName(events[1].type), "score_persisted");
+}
+
+TEST(EventRingTest, SignalDumpsSnakeSession) {
+  const char *path = "snake_events.bin";
+  std::remove(path);
+  {
+    SnakeModel model;
+    model.handleInput(Start, false);
+    model.handleInput(Pause, false);
+    std::raise(SIGUSR1);
+  }
+
+  EventDumpHeader_t header;
+  std::vector<GameEvent_t> events;
+  ASSERT_TRUE(readDump(path, &header, &events));
+  std::remove(path);
+
+  ASSERT_EQ(header.head, 2u);
+  EXPECT_EQ(events[0].type, EVENT_STATE_CHANGED);
+  EXPECT_EQ(events[0].a, static_cast<int>(SnakeFSM::State_t::INITIAL));
+  EXPECT_EQ(events[0].b, static_cast<int>(SnakeFSM::State_t::MOVING));
+  EXPECT_EQ(events[1].b, static_cast<int>(SnakeFSM::State_t::PAUSED));
+}
@@ -0,0 +1,149 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Frame Delta Tests - versions move with the board, deltas carry the changes
+// =============================================================================
+
+namespace {
+
+// Applies the delta from since and returns the version it reached.
+unsigned long long catchUp(const FrameVersions_t *versions,
+                           unsigned long long since, Frame_t *copy) {
+  FrameDelta_t delta;
+  if (!readFrameVersionsDelta(versions, since, &delta)) return since;
+  applyFrameDelta(copy, &delta);
+  return delta.version;
+}
+
+void expectSameBoard(const Frame_t &expected, const Frame_t &actual) {
+  EXPECT_EQ(memcmp(expected.field, actual.field, sizeof(expected.field)), 0);
+  EXPECT_EQ(memcmp(expected.next, actual.next, sizeof(expected.next)), 0);
+  EXPECT_EQ(expected.score, actual.score);
+  EXPECT_EQ(expected.level, actual.level);
+  EXPECT_EQ(expected.pause, actual.pause);
+  EXPECT_EQ(expected.focus_row, actual.focus_row);
+}
+
+}  // namespace
+
+TEST(FrameDeltaTest, ReportsOnlyWhatChanged) {
+  auto versions = std::make_unique<FrameVersions_t>();
+  initFrameVersions(versions.get());
+  Frame_t frame = {};
+  EXPECT_EQ(updateFrameVersions(versions.get(), &frame), 0u);
+
+  frame.field[3][4] = 2;
+  EXPECT_EQ(updateFrameVersions(versions.get(), &frame), 1u);
+  frame.frame_id = 99;  // not drawn, not a change
+  EXPECT_EQ(updateFrameVersions(versions.get(), &frame), 1u);
+
+  FrameDelta_t delta;
+  EXPECT_FALSE(readFrameVersionsDelta(versions.get(), 1, &delta));
+  EXPECT_EQ(delta.version, 1u);
+  ASSERT_TRUE(readFrameVersionsDelta(versions.get(), 0, &delta));
+  EXPECT_TRUE(delta.full);
+  EXPECT_EQ(delta.count, FRAME_DELTA_CELLS);
+
+  frame.field[3][4] = 0;
+  frame.next[1][2] = 5;
+  frame.score = 10;
+  updateFrameVersions(versions.get(), &frame);
+  frame.field[3][4] = 7;
+  updateFrameVersions(versions.get(), &frame);
+
+  // Cell (3, 4) changed twice but is reported once, with its last value.
+  ASSERT_TRUE(readFrameVersionsDelta(versions.get(), 1, &delta));
+  EXPECT_FALSE(delta.full);
+  EXPECT_EQ(delta.version, 3u);
+  ASSERT_EQ(delta.count, 2);
+  EXPECT_EQ(delta.cells[0].next, 1);
+  EXPECT_EQ(delta.cells[0].row, 1);
+  EXPECT_EQ(delta.cells[0].col, 2);
+  EXPECT_EQ(delta.cells[0].value, 5);
+  EXPECT_EQ(delta.cells[1].next, 0);
+  EXPECT_EQ(delta.cells[1].row, 3);
+  EXPECT_EQ(delta.cells[1].col, 4);
+  EXPECT_EQ(delta.cells[1].value, 7);
+  EXPECT_EQ(delta.scalar_mask, 1u << FRAME_SCORE);
+  EXPECT_EQ(delta.scalars[FRAME_SCORE], 10);
+}
+
+TEST(FrameDeltaTest, DeltasRebuildAPlayedGame) {
+  unsigned long long clock = 1000;
+  setGameClock(&clock);
+  suspendScoreStores(true);
+  Controller game;
+  game.seed(5);
+  game.userInput(Start, false);
+  auto versions = std::make_unique<FrameVersions_t>();
+  initFrameVersions(versions.get());
+
+  // One follower polls every frame, the other every tenth, the last one
+  // only after falling behind the log.
+  const UserAction_t turns[] = {Left, Down, Right, Up};
+  Frame_t frame = {}, every = {}, tenth = {}, late = {};
+  unsigned long long every_version = 0, tenth_version = 0;
+  for (int i = 0; i < 300; ++i) {
+    clock += INIT_SPEED;
+    if (i % 3 == 0) game.userInput(turns[i / 3 % 4], false);
+    game.processTimer();
+    game.fillFrame(&frame);
+    updateFrameVersions(versions.get(), &frame);
+    every_version = catchUp(versions.get(), every_version, &every);
+    expectSameBoard(frame, every);
+    if (i % 10 == 9) {
+      tenth_version = catchUp(versions.get(), tenth_version, &tenth);
+      expectSameBoard(frame, tenth);
+    }
+  }
+  FrameDelta_t delta;
+  ASSERT_TRUE(readFrameVersionsDelta(versions.get(), 1, &delta));
+  EXPECT_TRUE(delta.full);
+  applyFrameDelta(&late, &delta);
+  expectSameBoard(frame, late);
+  suspendScoreStores(false);
+  setGameClock(nullptr);
+}
+
+TEST(FrameDeltaTest, ReadersNeverSeeTornDeltas) {
+  auto versions = std::make_unique<FrameVersions_t>();
+  initFrameVersions(versions.get());
+
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    Frame_t frame = {};
+    for (int n = 1; n <= 20000; ++n) {
+      for (auto &row : frame.field) std::fill(row, row + FIELD_W, n);
+      frame.score = n;
+      updateFrameVersions(versions.get(), &frame);
+    }
+    done = true;
+  });
+
+  Frame_t copy = {};
+  unsigned long long version = 0;
+  while (!done) {
+    version = catchUp(versions.get(), version, &copy);
+    for (const auto &row : copy.field) {
+      for (int cell : row) ASSERT_EQ(cell, copy.score);
+    }
+  }
+  writer.join();
+  catchUp(versions.get(), version, &copy);
+  EXPECT_EQ(copy.score, 20000);
+}
+
+TEST(FrameDeltaTest, EngineReportsUnchangedFrames) {
+  EngineThread_t *engine = startEngineThread(getEngineOps());
+  ASSERT_NE(engine, nullptr);
+  Frame_t frame;
+  while (readFrame(engine, &frame) == 0) std::this_thread::yield();
+
+  // The start screen stands still: every poll from its version is empty.
+  FrameDelta_t delta;
+  ASSERT_TRUE(pollFrameDelta(engine, 0, &delta));
+  EXPECT_EQ(delta.version, frame.version);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_FALSE(pollFrameDelta(engine, delta.version, &delta));
+  stopEngineThread(engine);
+}
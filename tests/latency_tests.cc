@@ -0,0 +1,62 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Latency Histogram Tests - Testing percentile accuracy and merging
+// =============================================================================
+
+TEST(LatencyHistogramTest, EmptyHistogramReportsZero) {
+  LatencyHistogram_t histogram;
+  initLatencyHistogram(&histogram);
+
+  LatencySummary_t summary = summarizeLatency(&histogram);
+  EXPECT_EQ(summary.count, 0u);
+  EXPECT_EQ(summary.p50, 0u);
+  EXPECT_EQ(summary.p99, 0u);
+  EXPECT_EQ(summary.max, 0u);
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+  LatencyHistogram_t histogram;
+  initLatencyHistogram(&histogram);
+  for (unsigned long long i = 0; i < 10; ++i) recordLatency(&histogram, i);
+
+  EXPECT_EQ(latencyPercentile(&histogram, 0.5), 4u);
+  EXPECT_EQ(histogram.max, 9u);
+}
+
+TEST(LatencyHistogramTest, PercentilesWithinBucketPrecision) {
+  LatencyHistogram_t histogram;
+  initLatencyHistogram(&histogram);
+  for (unsigned long long us = 1; us <= 10000; ++us) {
+    recordLatency(&histogram, us * 1000);
+  }
+
+  LatencySummary_t summary = summarizeLatency(&histogram);
+  EXPECT_EQ(summary.count, 10000u);
+  EXPECT_NEAR(static_cast<double>(summary.p50), 5.0e6, 5.0e6 * 0.07);
+  EXPECT_NEAR(static_cast<double>(summary.p99), 9.9e6, 9.9e6 * 0.07);
+  EXPECT_EQ(summary.max, 10000000u);
+}
+
+TEST(LatencyHistogramTest, HugeValuesDoNotOverflowBuckets) {
+  LatencyHistogram_t histogram;
+  initLatencyHistogram(&histogram);
+  recordLatency(&histogram, ~0ULL);
+
+  EXPECT_EQ(histogram.max, ~0ULL);
+  EXPECT_GE(latencyPercentile(&histogram, 1.0), ~0ULL / 16 * 15);
+}
+
+TEST(LatencyHistogramTest, MergeCombinesShards) {
+  LatencyHistogram_t first, second;
+  initLatencyHistogram(&first);
+  initLatencyHistogram(&second);
+  for (int i = 0; i < 100; ++i) recordLatency(&first, 1000);
+  for (int i = 0; i < 100; ++i) recordLatency(&second, 1000000);
+
+  mergeLatencyHistogram(&first, &second);
+  EXPECT_EQ(first.count, 200u);
+  EXPECT_EQ(first.max, 1000000u);
+  EXPECT_NEAR(static_cast<double>(latencyPercentile(&first, 0.99)), 1.0e6,
+              1.0e6 * 0.07);
+}
@@ -0,0 +1,125 @@
+#include "test_includes.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// =============================================================================
+// Metrics Tests - per-thread shards and the Prometheus endpoint
+// =============================================================================
+
+static std::string scrape(const char *path, const char *request) {
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  std::snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+  if (connect(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address))) {
+    close(fd);
+    return "";
+  }
+  if (request) send(fd, request, std::strlen(request), 0);
+
+  std::string response;
+  char buffer[4096];
+  ssize_t received;
+  while ((received = recv(fd, buffer, sizeof(buffer), 0)) > 0) {
+    response.append(buffer, static_cast<size_t>(received));
+  }
+  close(fd);
+  return response;
+}
+
+TEST(MetricsTest, MergesShardsOfAllThreads) {
+  auto before = std::make_unique<MetricsSnapshot_t>();
+  auto after = std::make_unique<MetricsSnapshot_t>();
+  readMetrics(before.get());
+
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 4; ++t) {
+    workers.emplace_back([] {
+      for (int i = 0; i < 1000; ++i) {
+        addMetricCounter(METRIC_INPUTS, 1);
+        recordMetricLatency(METRIC_TICK_LATENCY, 2000);
+      }
+    });
+  }
+  for (auto &worker : workers) worker.join();
+  setMetricGauge(METRIC_LEVEL, 7);
+  readMetrics(after.get());
+
+  EXPECT_EQ(after->counters[METRIC_INPUTS] - before->counters[METRIC_INPUTS],
+            4000u);
+  const LatencyHistogram_t &tick = after->latencies[METRIC_TICK_LATENCY];
+  EXPECT_EQ(tick.count - before->latencies[METRIC_TICK_LATENCY].count, 4000u);
+  EXPECT_EQ(tick.sum - before->latencies[METRIC_TICK_LATENCY].sum, 8000000u);
+  EXPECT_EQ(after->gauges[METRIC_LEVEL], 7);
+}
+
+TEST(MetricsTest, SnakeTouchesStorageOnlyOnceStarted) {
+  auto before = std::make_unique<MetricsSnapshot_t>();
+  auto after = std::make_unique<MetricsSnapshot_t>();
+  readMetrics(before.get());
+  auto model = std::make_unique<SnakeModel>();
+  readMetrics(after.get());
+  EXPECT_EQ(after->counters[METRIC_DB_OPS], before->counters[METRIC_DB_OPS]);
+
+  model->handleInput(Start, false);
+  readMetrics(after.get());
+  EXPECT_GT(after->counters[METRIC_DB_OPS], before->counters[METRIC_DB_OPS]);
+}
+
+TEST(MetricsTest, SnakeSkipsStorageWithoutRecord) {
+  auto model = std::make_unique<SnakeModel>();
+  model->handleInput(Start, false);
+  auto before = std::make_unique<MetricsSnapshot_t>();
+  auto after = std::make_unique<MetricsSnapshot_t>();
+  readMetrics(before.get());
+  model->handleInput(Terminate, false);
+  readMetrics(after.get());
+  EXPECT_EQ(after->counters[METRIC_DB_OPS], before->counters[METRIC_DB_OPS]);
+}
+
+TEST(MetricsTest, WritesPrometheusText) {
+  recordMetricLatency(METRIC_RENDER_LATENCY, 300000);
+  char *text = nullptr;
+  size_t size = 0;
+  FILE *out = open_memstream(&text, &size);
+  writeMetrics(out, "metrics_test");
+  fclose(out);
+  std::string metrics(text, size);
+  free(text);
+
+  EXPECT_NE(metrics.find("# TYPE brickgame_ticks_total counter\n"),
+            std::string::npos);
+  EXPECT_NE(metrics.find("# TYPE brickgame_level gauge\n"), std::string::npos);
+  EXPECT_NE(metrics.find("# TYPE brickgame_render_duration_seconds histogram"),
+            std::string::npos);
+  EXPECT_NE(metrics.find("brickgame_render_duration_seconds_bucket{process="
+                         "\"metrics_test\",le=\"+Inf\"}"),
+            std::string::npos);
+  EXPECT_NE(metrics.find("brickgame_render_duration_seconds_bucket{process="
+                         "\"metrics_test\",le=\"0.0001\"} 0\n"),
+            std::string::npos);
+}
+
+TEST(MetricsTest, ServesPlainAndHttpScrapes) {
+  const char *path = "metrics_test.sock";
+  setenv("BRICKGAME_METRICS_SOCKET", path, 1);
+  ASSERT_TRUE(startMetricsServer("./bin/metrics_test"));
+  unsetenv("BRICKGAME_METRICS_SOCKET");
+  EXPECT_STREQ(metricsSocketPath(), path);
+
+  std::string plain = scrape(path, nullptr);
+  EXPECT_EQ(plain.rfind("# HELP brickgame_ticks_total", 0), 0u);
+  EXPECT_NE(plain.find("brickgame_inputs_total{process=\"metrics_test\"}"),
+            std::string::npos);
+
+  std::string http =
+      scrape(path, "GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  EXPECT_EQ(http.rfind("HTTP/1.0 200 OK\r\n", 0), 0u);
+  EXPECT_NE(http.find("\r\n\r\n# HELP"), std::string::npos);
+
+  stopMetricsServer();
+  EXPECT_EQ(metricsSocketPath(), nullptr);
+  EXPECT_NE(access(path, F_OK), 0);
+}
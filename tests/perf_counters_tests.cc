@@ -0,0 +1,92 @@
+#include <dirent.h>
+
+#include "test_includes.h"
+
+// =============================================================================
+// Perf Counter Tests - per-site aggregation with or without hardware counters
+// =============================================================================
+
+namespace {
+
+int openFdCount() {
+  DIR *dir = opendir("/proc/self/fd");
+  if (!dir) return -1;
+  int count = 0;
+  while (readdir(dir)) ++count;
+  closedir(dir);
+  return count;
+}
+
+}  // namespace
+
+TEST(PerfCountersTest, AggregatesPerSite) {
+  enablePerfCounters();
+  resetPerfTotals();
+
+  for (int i = 0; i < 3; ++i) {
+    PerfSample_t sample;
+    beginPerfSample(&sample);
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+    endPerfSample(&sample, PERF_SITE_PERSIST);
+  }
+
+  PerfTotals_t persist, tick;
+  getPerfTotals(PERF_SITE_PERSIST, &persist);
+  getPerfTotals(PERF_SITE_TICK, &tick);
+  EXPECT_EQ(persist.calls, 3ULL);
+  EXPECT_GE(persist.nanos, 300000ULL);
+  EXPECT_EQ(tick.calls, 0ULL);
+
+  PerfSample_t probe;
+  readPerfCounters(&probe);
+  if (probe.hardware) {
+    EXPECT_GT(persist.counts[1], 0ULL);
+  } else {
+    EXPECT_NE(perfUnavailableReason(), nullptr);
+    EXPECT_EQ(persist.counts[1], 0ULL);
+  }
+}
+
+TEST(PerfCountersTest, EngineTicksAreSampled) {
+  enablePerfCounters();
+  resetPerfTotals();
+
+  EngineThread_t *engine = startEngineThread(getEngineOps());
+  ASSERT_NE(engine, nullptr);
+  Frame_t frame;
+  while (readFrame(engine, &frame) == 0) std::this_thread::yield();
+  stopEngineThread(engine);
+
+  PerfTotals_t tick, snapshot;
+  getPerfTotals(PERF_SITE_TICK, &tick);
+  getPerfTotals(PERF_SITE_SNAPSHOT, &snapshot);
+  EXPECT_GE(tick.calls, 1ULL);
+  EXPECT_GE(snapshot.calls, 1ULL);
+
+  char report[512] = {0};
+  FILE *out = fmemopen(report, sizeof(report), "w");
+  printPerfReport(out);
+  fclose(out);
+  EXPECT_NE(std::string(report).find("tick"), std::string::npos);
+}
+
+TEST(PerfCountersTest, EngineThreadsCloseTheirCounters) {
+  enablePerfCounters();
+  releasePerfCounters();
+  int before = openFdCount();
+  if (before < 0) GTEST_SKIP();
+
+  for (int i = 0; i < 4; ++i) {
+    EngineThread_t *engine = startEngineThread(getEngineOps());
+    ASSERT_NE(engine, nullptr);
+    Frame_t frame;
+    while (readFrame(engine, &frame) == 0) std::this_thread::yield();
+    stopEngineThread(engine);
+  }
+  EXPECT_EQ(openFdCount(), before);
+
+  PerfSample_t sample;
+  readPerfCounters(&sample);
+  releasePerfCounters();
+  EXPECT_EQ(openFdCount(), before);
+}
@@ -69,6 +69,19 @@ TEST_F(SnakePublicModelTest, TestAccelerationThroughAction) {
   controller->freeGameInfo(&info);
 }
 
+TEST_F(SnakePublicModelTest, TestHeldActionBoostsUntilRelease) {
+  controller->userInput(Start, false);
+  EXPECT_GT(controller->processTimer(), 20ULL);
+
+  controller->userInput(Action, true);
+  EXPECT_LE(controller->processTimer(), 20ULL);
+  controller->userInput(Action, true);
+  EXPECT_LE(controller->processTimer(), 20ULL);
+
+  controller->userInput(Action, false);
+  EXPECT_GT(controller->processTimer(), 20ULL);
+}
+
 TEST_F(SnakePublicModelTest, TestPauseFunctionality) {
   controller->userInput(Start, false);
   auto info = controller->updateCurrentState();
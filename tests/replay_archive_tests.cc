@@ -0,0 +1,183 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Replay Archive Tests - payloads streamed in and out, metadata by index
+// =============================================================================
+
+namespace {
+
+const char *kArchivePath = "replay_archive_test.db";
+const char *kSessionPath = "replay_archive_session.bin";
+const char *kExtractPath = "replay_archive_extract.bin";
+
+void removeArchiveFiles() {
+  std::remove(kArchivePath);
+  std::remove("replay_archive_test.db-wal");
+  std::remove("replay_archive_test.db-shm");
+}
+
+// Records ticks of snake on a virtual clock, turning every few ticks, and
+// steps after inputs and claims the last frame the way the engine does.
+void recordSession(const char *path, unsigned long long seed, int ticks) {
+  unsigned long long clock = 1000;
+  setGameClock(&clock);
+  suspendScoreStores(true);
+  const EngineOps_t *ops = getEngineOps();
+  void *game = ops->create();
+  ops->seed(game, seed);
+  ReplayRecorder_t recorder;
+  startReplayRecording(&recorder, path, ops, game, seed, clock, 16);
+
+  const UserAction_t turns[] = {Left, Down, Right, Up};
+  Frame_t frame;
+  recordReplayEntry(&recorder, clock, Start, false);
+  ops->input(game, Start, false);
+  recordReplayEntry(&recorder, clock, REPLAY_ADVANCE, false);
+  stepGameClock(ops, game);
+  for (int i = 0; i < ticks; ++i) {
+    clock += INIT_SPEED;
+    if (i % 3 == 0) {
+      recordReplayEntry(&recorder, clock, turns[i / 3 % 4], false);
+      ops->input(game, turns[i / 3 % 4], false);
+    }
+    recordReplayEntry(&recorder, clock, REPLAY_ADVANCE, false);
+    stepGameClock(ops, game);
+  }
+  ops->fill(game, &frame);
+  claimReplayResult(&recorder, &frame);
+
+  stopReplayRecording(&recorder);
+  ops->destroy(game);
+  suspendScoreStores(false);
+  setGameClock(nullptr);
+}
+
+// A session that claims the given result without playing for it; the archive
+// takes claims at face value.
+void recordClaim(const char *path, int score) {
+  ReplayRecorder_t recorder;
+  startReplayRecording(&recorder, path, getEngineOps(), nullptr, 1, 0, 0);
+  recordReplayEntry(&recorder, 1000, Start, false);
+  Frame_t frame = {};
+  frame.score = score;
+  frame.level = 1;
+  claimReplayResult(&recorder, &frame);
+  stopReplayRecording(&recorder);
+}
+
+std::string readFile(const char *path) {
+  std::ifstream file(path, std::ios::binary);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+bool collect(const ReplayRecord_t *record, void *context) {
+  static_cast<std::vector<ReplayRecord_t> *>(context)->push_back(*record);
+  return true;
+}
+
+std::string queryPlan(ReplayArchive_t *archive, ArchiveStatement_t statement) {
+  std::string sql = "EXPLAIN QUERY PLAN ";
+  sql += sqlite3_sql(archive->statements[statement]);
+  sqlite3_stmt *stmt;
+  std::string plan;
+  if (sqlite3_prepare_v2(archive->db, sql.c_str(), -1, &stmt, 0) != SQLITE_OK)
+    return plan;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    plan += reinterpret_cast<const char *>(sqlite3_column_text(stmt, 3));
+    plan += "\n";
+  }
+  sqlite3_finalize(stmt);
+  return plan;
+}
+
+}  // namespace
+
+TEST(ReplayArchiveTest, StreamsPayloadsInAndOut) {
+  removeArchiveFiles();
+  // Larger than a chunk, so both directions take several BLOB calls.
+  recordSession(kSessionPath, 5, 6000);
+  std::string original = readFile(kSessionPath);
+  ASSERT_GT(original.size(), (size_t)REPLAY_ARCHIVE_CHUNK);
+
+  ReplayArchive_t archive = {};
+  ASSERT_EQ(openReplayArchive(&archive, kArchivePath), SQLITE_OK);
+  long long id = 0;
+  ASSERT_EQ(archiveReplay(&archive, kSessionPath, 1700000000, &id), SQLITE_OK);
+  ASSERT_EQ(extractReplay(&archive, id, kExtractPath), SQLITE_OK);
+  EXPECT_EQ(readFile(kExtractPath), original);
+
+  std::vector<ReplayRecord_t> records;
+  ASSERT_EQ(topReplays(&archive, "snake", 10, collect, &records), SQLITE_OK);
+  ASSERT_EQ(records.size(), 1u);
+  ReplayCheck_t check;
+  ASSERT_EQ(verifyReplay(kExtractPath, getEngineOps(), &check),
+            REPLAY_VERIFIED);
+  EXPECT_EQ(records[0].id, id);
+  EXPECT_STREQ(records[0].game, "snake");
+  EXPECT_EQ(records[0].score, check.score);
+  EXPECT_EQ(records[0].duration, check.millis);
+  EXPECT_EQ(records[0].seed, 5u);
+  EXPECT_EQ(records[0].size, (long long)original.size());
+
+  EXPECT_NE(extractReplay(&archive, id + 1, kExtractPath), SQLITE_OK);
+  EXPECT_EQ(archiveReplay(&archive, "missing_replay.bin", 0, &id),
+            SQLITE_FORMAT);
+  closeReplayArchive(&archive);
+  std::remove(kSessionPath);
+  std::remove(kExtractPath);
+  removeArchiveFiles();
+}
+
+TEST(ReplayArchiveTest, QueriesByScoreAndDate) {
+  removeArchiveFiles();
+  ReplayArchive_t archive = {};
+  ASSERT_EQ(openReplayArchive(&archive, kArchivePath), SQLITE_OK);
+  const int scores[] = {30, 90, 10, 70, 50, 20};
+  for (int i = 0; i < 6; ++i) {
+    recordClaim(kSessionPath, scores[i]);
+    ASSERT_EQ(archiveReplay(&archive, kSessionPath, 1000 + i * 100, nullptr),
+              SQLITE_OK);
+  }
+
+  std::vector<ReplayRecord_t> top;
+  ASSERT_EQ(topReplays(&archive, "snake", 3, collect, &top), SQLITE_OK);
+  ASSERT_EQ(top.size(), 3u);
+  EXPECT_EQ(top[0].score, 90);
+  EXPECT_EQ(top[1].score, 70);
+  EXPECT_EQ(top[2].score, 50);
+
+  std::vector<ReplayRecord_t> range;
+  ASSERT_EQ(replaysBetween(&archive, "snake", 1150, 1400, collect, &range),
+            SQLITE_OK);
+  ASSERT_EQ(range.size(), 3u);
+  EXPECT_EQ(range[0].recorded, 1200);
+  EXPECT_EQ(range[2].recorded, 1400);
+  EXPECT_EQ(range[0].score, 10);
+
+  std::vector<ReplayRecord_t> other;
+  EXPECT_EQ(topReplays(&archive, "tetris", 3, collect, &other), SQLITE_OK);
+  EXPECT_TRUE(other.empty());
+  closeReplayArchive(&archive);
+  std::remove(kSessionPath);
+  removeArchiveFiles();
+}
+
+TEST(ReplayArchiveTest, ListingNeverTouchesPayloads) {
+  removeArchiveFiles();
+  ReplayArchive_t archive = {};
+  ASSERT_EQ(openReplayArchive(&archive, kArchivePath), SQLITE_OK);
+
+  std::string top = queryPlan(&archive, ARCHIVE_STMT_TOP);
+  std::string range = queryPlan(&archive, ARCHIVE_STMT_RANGE);
+  EXPECT_NE(top.find("replays_by_score"), std::string::npos) << top;
+  EXPECT_NE(range.find("replays_by_date"), std::string::npos) << range;
+  for (const std::string &plan : {top, range}) {
+    EXPECT_EQ(plan.find("SCAN"), std::string::npos) << plan;
+    EXPECT_EQ(plan.find("TEMP B-TREE"), std::string::npos) << plan;
+    EXPECT_EQ(plan.find("replay_payloads"), std::string::npos) << plan;
+  }
+  closeReplayArchive(&archive);
+  removeArchiveFiles();
+}
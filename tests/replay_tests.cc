@@ -0,0 +1,188 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Replay Tests - compact recording and deterministic playback
+// =============================================================================
+
+namespace {
+
+const char *kReplayPath = "snake_replay_test.bin";
+
+// Records a short snake session through the engine thread and returns the
+// frame it settled on: the game is paused last, so nothing moves after it.
+Frame_t recordSession() {
+  setenv(REPLAY_RECORD_ENV, kReplayPath, 1);
+  EngineThread_t *engine = startEngineThread(getEngineOps());
+  auto step = [engine](UserAction_t action, bool hold, int millis) {
+    submitInput(engine, action, hold);
+    std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+  };
+  step(Start, false, 30);
+  step(Action, true, 120);
+  step(Left, false, 80);
+  step(Down, false, 80);
+  step(Action, false, 40);
+  step(Pause, false, 30);
+
+  Frame_t frame = {};
+  readFrame(engine, &frame);
+  stopEngineThread(engine);
+  unsetenv(REPLAY_RECORD_ENV);
+  return frame;
+}
+
+void expectSameGame(const Frame_t &expected, const Frame_t &actual) {
+  EXPECT_EQ(memcmp(expected.field, actual.field, sizeof(expected.field)), 0);
+  EXPECT_EQ(memcmp(expected.next, actual.next, sizeof(expected.next)), 0);
+  EXPECT_EQ(expected.score, actual.score);
+  EXPECT_EQ(expected.level, actual.level);
+  EXPECT_EQ(expected.speed, actual.speed);
+  EXPECT_EQ(expected.pause, actual.pause);
+}
+
+}  // namespace
+
+TEST(ReplayTest, EntriesAreVarintPacked) {
+  FILE *file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  const ReplayEntry_t entries[] = {
+      {0, REPLAY_ADVANCE, false}, {16, Left, true}, {300, Left, false},
+      {70000, (int)Terminate, false}, {0, -1, false}};
+  for (const auto &entry : entries) ASSERT_TRUE(writeReplayEntry(file, &entry));
+  // 2 + 2 + 3 (300 ms) + 4 (70 s) + 2 bytes.
+  EXPECT_EQ(ftell(file), 13);
+
+  rewind(file);
+  ReplayEntry_t read;
+  for (const auto &entry : entries) {
+    ASSERT_TRUE(readReplayEntry(file, &read));
+    EXPECT_EQ(read.delta, entry.delta);
+    EXPECT_EQ(read.action, entry.action);
+    EXPECT_EQ(read.hold, entry.hold);
+  }
+  EXPECT_FALSE(readReplayEntry(file, &read));
+  fclose(file);
+}
+
+TEST(ReplayTest, SameSeedDrawsSameSequence) {
+  Rng_t a, b;
+  seedRng(&a, 42);
+  seedRng(&b, 42);
+  for (int i = 0; i < 100; ++i) {
+    int value = randomBelow(&a, 7);
+    EXPECT_EQ(value, randomBelow(&b, 7));
+    EXPECT_GE(value, 0);
+    EXPECT_LT(value, 7);
+  }
+}
+
+TEST(ReplayTest, PlaybackReproducesRecordedSession) {
+  Frame_t recorded = recordSession();
+  ASSERT_EQ(recorded.pause, GamePause);
+
+  ReplayPlayer_t player;
+  ASSERT_TRUE(openReplay(&player, kReplayPath, getEngineOps()));
+  EXPECT_GT(fastForwardReplay(&player), 5u);
+  EXPECT_TRUE(player.finished);
+  Frame_t replayed;
+  fillReplayFrame(&player, &replayed);
+  closeReplay(&player);
+
+  expectSameGame(recorded, replayed);
+  EXPECT_EQ(replayed.high_score, 0);  // stores stay closed during playback
+  std::remove(kReplayPath);
+}
+
+TEST(ReplayTest, VirtualClockPlaybackMatchesFastForward) {
+  recordSession();
+
+  ReplayPlayer_t paced, fast;
+  ASSERT_TRUE(openReplay(&paced, kReplayPath, getEngineOps()));
+  ASSERT_TRUE(openReplay(&fast, kReplayPath, getEngineOps()));
+  while (!paced.finished) advanceReplay(&paced, 7);
+  fastForwardReplay(&fast);
+  EXPECT_GE(replayElapsed(&paced), replayElapsed(&fast));
+
+  Frame_t a, b;
+  fillReplayFrame(&paced, &a);
+  fillReplayFrame(&fast, &b);
+  closeReplay(&paced);
+  closeReplay(&fast);
+  expectSameGame(a, b);
+  std::remove(kReplayPath);
+}
+
+TEST(ReplayTest, SeekMatchesLinearPlayback) {
+  setenv(REPLAY_KEYFRAME_ENV, "4", 1);
+  recordSession();
+  unsetenv(REPLAY_KEYFRAME_ENV);
+
+  ReplayPlayer_t seeker;
+  ASSERT_TRUE(openReplay(&seeker, kReplayPath, getEngineOps()));
+  ASSERT_GT(seeker.keyframe_count, 1u);
+  unsigned long long total = replayElapsed(&seeker);
+  fastForwardReplay(&seeker);
+  total = replayElapsed(&seeker) - total;
+
+  // Forwards past several keyframes, then back, then into the same span.
+  for (unsigned long long point : {total, total / 4, total * 3 / 4, total / 2}) {
+    seekReplay(&seeker, point);
+    ReplayPlayer_t linear;
+    ASSERT_TRUE(openReplay(&linear, kReplayPath, getEngineOps()));
+    advanceReplay(&linear, point);
+    EXPECT_EQ(seeker.entries, linear.entries) << "at " << point << " ms";
+    EXPECT_EQ(replayElapsed(&seeker), replayElapsed(&linear));
+
+    Frame_t a, b;
+    fillReplayFrame(&seeker, &a);
+    fillReplayFrame(&linear, &b);
+    closeReplay(&linear);
+    expectSameGame(b, a);
+  }
+  closeReplay(&seeker);
+  std::remove(kReplayPath);
+}
+
+TEST(ReplayTest, VerifiesTheClaimedResult) {
+  Frame_t recorded = recordSession();
+
+  ReplayCheck_t check;
+  ASSERT_EQ(verifyReplay(kReplayPath, getEngineOps(), &check),
+            REPLAY_VERIFIED);
+  EXPECT_EQ(check.claim.score, recorded.score);
+  EXPECT_EQ(check.score, recorded.score);
+  EXPECT_EQ(check.level, recorded.level);
+  EXPECT_GT(check.entries, 5u);
+
+  FILE *file = fopen(kReplayPath, "r+b");
+  ReplayFooter_t footer;
+  fseek(file, -(long)sizeof(footer), SEEK_END);
+  ASSERT_EQ(fread(&footer, sizeof(footer), 1, file), 1u);
+  footer.claim.score += 10;
+  fseek(file, -(long)sizeof(footer), SEEK_END);
+  fwrite(&footer, sizeof(footer), 1, file);
+  fclose(file);
+  EXPECT_EQ(verifyReplay(kReplayPath, getEngineOps(), &check),
+            REPLAY_MISMATCH);
+  EXPECT_EQ(check.score, recorded.score);
+
+  EXPECT_EQ(verifyReplay("missing_replay.bin", getEngineOps(), &check),
+            REPLAY_INVALID);
+  std::remove(kReplayPath);
+}
+
+TEST(ReplayTest, RejectsOtherGamesAndGarbage) {
+  FILE *file = fopen(kReplayPath, "wb");
+  ReplayHeader_t header = {};
+  memcpy(header.magic, REPLAY_MAGIC, 4);
+  header.version = REPLAY_VERSION;
+  header.header_size = sizeof(header);
+  strcpy(header.game, "tetris");
+  fwrite(&header, sizeof(header), 1, file);
+  fclose(file);
+
+  ReplayPlayer_t player;
+  EXPECT_FALSE(openReplay(&player, kReplayPath, getEngineOps()));
+  EXPECT_FALSE(openReplay(&player, "missing_replay.bin", getEngineOps()));
+  std::remove(kReplayPath);
+}
@@ -0,0 +1,132 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Rollback Tests - predicted remote inputs corrected by re-simulation
+// =============================================================================
+
+namespace {
+
+const unsigned long long kSeed = 21;
+const unsigned long long kStart = 1000;
+
+RollbackInput_t press(int action) {
+  RollbackInput_t input = {static_cast<int8_t>(action), 0};
+  return input;
+}
+
+// Start, then a turn every eight ticks, different for each player.
+RollbackInput_t scripted(uint32_t tick, int player) {
+  const UserAction_t turns[] = {Left, Down, Right, Up};
+  if (tick == 0) return press(Start);
+  if (tick % 8 == 3) return press(turns[(tick / 8 + player) % 4]);
+  return press(-1);
+}
+
+std::unique_ptr<RollbackSession_t> startSession(int local) {
+  auto session = std::make_unique<RollbackSession_t>();
+  EXPECT_TRUE(startRollbackSession(session.get(), getEngineOps(), local,
+                                   kSeed, kStart));
+  return session;
+}
+
+void expectSameBoard(RollbackSession_t *a, RollbackSession_t *b, int player) {
+  Frame_t expected, actual;
+  fillRollbackFrame(a, player, &expected);
+  fillRollbackFrame(b, player, &actual);
+  EXPECT_EQ(memcmp(expected.field, actual.field, sizeof(expected.field)), 0);
+  EXPECT_EQ(expected.score, actual.score);
+  EXPECT_EQ(expected.level, actual.level);
+  EXPECT_EQ(expected.pause, actual.pause);
+}
+
+}  // namespace
+
+TEST(RollbackTest, LateInputsAreReplayedIntoTheRemoteBoard) {
+  auto a = startSession(0);
+  auto b = startSession(1);
+  // a sees none of player 1's inputs in time and predicts nothing.
+  for (uint32_t tick = 0; tick < ROLLBACK_MAX_TICKS; ++tick) {
+    ASSERT_TRUE(advanceRollback(a.get(), scripted(tick, 0)));
+    ASSERT_TRUE(advanceRollback(b.get(), scripted(tick, 1)));
+  }
+  Frame_t predicted, actual;
+  fillRollbackFrame(a.get(), 1, &predicted);
+  fillRollbackFrame(b.get(), 1, &actual);
+  EXPECT_NE(predicted.pause, actual.pause);
+
+  for (uint32_t tick = 0; tick < ROLLBACK_MAX_TICKS; ++tick)
+    addRemoteInput(a.get(), tick, scripted(tick, 1));
+  EXPECT_EQ(a->confirmed, (uint32_t)ROLLBACK_MAX_TICKS);
+  startAllocTracking();
+  EXPECT_EQ(reconcileRollback(a.get()), (uint32_t)ROLLBACK_MAX_TICKS);
+  EXPECT_EQ(stopAllocTracking().mallocs, 0u);
+  expectSameBoard(a.get(), b.get(), 1);
+  EXPECT_EQ(a->stats.rollbacks, 1u);
+  EXPECT_EQ(a->stats.deepest, (uint32_t)ROLLBACK_MAX_TICKS);
+
+  // The right guess costs nothing, and inputs already known are ignored.
+  addRemoteInput(a.get(), 2, press(Up));
+  EXPECT_EQ(reconcileRollback(a.get()), 0u);
+  stopRollbackSession(a.get());
+  stopRollbackSession(b.get());
+}
+
+TEST(RollbackTest, StallsTooFarAheadOfTheRemotePlayer) {
+  auto session = startSession(0);
+  for (uint32_t tick = 0; tick < ROLLBACK_MAX_TICKS; ++tick)
+    ASSERT_TRUE(advanceRollback(session.get(), scripted(tick, 0)));
+  EXPECT_FALSE(advanceRollback(session.get(), press(-1)));
+  EXPECT_EQ(session->tick, (uint32_t)ROLLBACK_MAX_TICKS);
+  EXPECT_EQ(session->stats.stalls, 1u);
+
+  addRemoteInput(session.get(), 0, press(Start));
+  EXPECT_TRUE(advanceRollback(session.get(), press(-1)));
+  stopRollbackSession(session.get());
+
+  // A remote player ahead of this one never holds it back.
+  session = startSession(1);
+  for (uint32_t tick = 0; tick < ROLLBACK_MAX_TICKS + 5; ++tick)
+    addRemoteInput(session.get(), tick, scripted(tick, 0));
+  EXPECT_EQ(session->confirmed, (uint32_t)ROLLBACK_MAX_TICKS + 5);
+  EXPECT_TRUE(advanceRollback(session.get(), scripted(0, 1)));
+  EXPECT_EQ(session->stats.stalls, 0u);
+  stopRollbackSession(session.get());
+}
+
+TEST(RollbackTest, PeersAgreeOverALaggyLink) {
+  const uint32_t kTicks = 300;
+  auto a = startSession(0);
+  auto b = startSession(1);
+  int fds[2];
+  ASSERT_TRUE(openRollbackLink(fds));
+  // Neither a short datagram nor a lying count gets through.
+  ASSERT_EQ(send(fds[1], "bad", 3, 0), 3);
+
+  // b only gets a packet out every fifth frame, so a keeps guessing wrong.
+  for (uint32_t frame = 0; a->tick < kTicks || b->tick < kTicks; ++frame) {
+    if (a->tick < kTicks) advanceRollback(a.get(), scripted(a->tick, 0));
+    if (b->tick < kTicks) advanceRollback(b.get(), scripted(b->tick, 1));
+    sendRollbackInputs(a.get(), fds[0]);
+    if (frame % 5 == 0) sendRollbackInputs(b.get(), fds[1]);
+    receiveRollbackInputs(a.get(), fds[0]);
+    receiveRollbackInputs(b.get(), fds[1]);
+    ASSERT_LT(frame, kTicks * 10);
+  }
+  for (int i = 0; i < 3; ++i) {
+    sendRollbackInputs(a.get(), fds[0]);
+    sendRollbackInputs(b.get(), fds[1]);
+    receiveRollbackInputs(a.get(), fds[0]);
+    receiveRollbackInputs(b.get(), fds[1]);
+  }
+  EXPECT_EQ(a->confirmed, kTicks);
+  EXPECT_EQ(b->confirmed, kTicks);
+  expectSameBoard(a.get(), b.get(), 0);
+  expectSameBoard(a.get(), b.get(), 1);
+  EXPECT_GT(a->stats.rollbacks, 0u);
+  EXPECT_LE(a->stats.deepest, (uint32_t)ROLLBACK_MAX_TICKS);
+
+  close(fds[0]);
+  close(fds[1]);
+  stopRollbackSession(a.get());
+  stopRollbackSession(b.get());
+}
@@ -0,0 +1,128 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Score Store Tests - cached statements, WAL and batched writes
+// =============================================================================
+
+static const char *kStorePath = "score_store_test.db";
+
+static void removeStoreFiles() {
+  std::remove(kStorePath);
+  std::remove("score_store_test.db-wal");
+  std::remove("score_store_test.db-shm");
+}
+
+TEST(ScoreStoreTest, CreatesTableAndRoundTripsScore) {
+  removeStoreFiles();
+  ScoreStore_t store = {};
+  ASSERT_EQ(openScoreStore(&store, kStorePath, "test_scores"), SQLITE_OK);
+
+  int score = -1;
+  EXPECT_EQ(readScore(&store, &score), SQLITE_OK);
+  EXPECT_EQ(score, 0);
+  EXPECT_EQ(writeScore(&store, 4200), SQLITE_OK);
+  closeScoreStore(&store);
+  EXPECT_FALSE(isScoreStoreOpen(&store));
+
+  ASSERT_EQ(openScoreStore(&store, kStorePath, "test_scores"), SQLITE_OK);
+  EXPECT_EQ(readScore(&store, &score), SQLITE_OK);
+  EXPECT_EQ(score, 4200);
+  closeScoreStore(&store);
+  removeStoreFiles();
+}
+
+TEST(ScoreStoreTest, RunsInWalModeWithNormalSync) {
+  removeStoreFiles();
+  ScoreStore_t store = {};
+  ASSERT_EQ(openScoreStore(&store, kStorePath, "test_scores"), SQLITE_OK);
+
+  sqlite3_stmt *stmt;
+  ASSERT_EQ(sqlite3_prepare_v2(store.db, "PRAGMA journal_mode;", -1, &stmt, 0),
+            SQLITE_OK);
+  ASSERT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+  EXPECT_STREQ(reinterpret_cast<const char *>(sqlite3_column_text(stmt, 0)),
+               "wal");
+  sqlite3_finalize(stmt);
+
+  ASSERT_EQ(sqlite3_prepare_v2(store.db, "PRAGMA synchronous;", -1, &stmt, 0),
+            SQLITE_OK);
+  ASSERT_EQ(sqlite3_step(stmt), SQLITE_ROW);
+  EXPECT_EQ(sqlite3_column_int(stmt, 0), 1);  // NORMAL
+  sqlite3_finalize(stmt);
+
+  closeScoreStore(&store);
+  removeStoreFiles();
+}
+
+TEST(ScoreStoreTest, ReusesStatementsAcrossCalls) {
+  removeStoreFiles();
+  ScoreStore_t store = {};
+  ASSERT_EQ(openScoreStore(&store, kStorePath, "test_scores"), SQLITE_OK);
+  sqlite3_stmt *read = store.statements[SCORE_STMT_READ];
+
+  int score;
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(writeScore(&store, i), SQLITE_OK);
+    ASSERT_EQ(readScore(&store, &score), SQLITE_OK);
+    EXPECT_EQ(score, i);
+  }
+  EXPECT_EQ(store.statements[SCORE_STMT_READ], read);
+  // Nothing is left mid-step: the connection is back in autocommit.
+  EXPECT_TRUE(sqlite3_get_autocommit(store.db));
+  closeScoreStore(&store);
+  removeStoreFiles();
+}
+
+TEST(ScoreStoreTest, NestedBatchCommitsOnce) {
+  removeStoreFiles();
+  ScoreStore_t store = {};
+  ASSERT_EQ(openScoreStore(&store, kStorePath, "test_scores"), SQLITE_OK);
+
+  ASSERT_EQ(beginScoreBatch(&store), SQLITE_OK);
+  ASSERT_EQ(beginScoreBatch(&store), SQLITE_OK);
+  EXPECT_EQ(writeScore(&store, 10), SQLITE_OK);
+  EXPECT_EQ(commitScoreBatch(&store), SQLITE_OK);
+  EXPECT_FALSE(sqlite3_get_autocommit(store.db));
+  EXPECT_EQ(writeScore(&store, 20), SQLITE_OK);
+  EXPECT_EQ(commitScoreBatch(&store), SQLITE_OK);
+  EXPECT_TRUE(sqlite3_get_autocommit(store.db));
+  EXPECT_EQ(commitScoreBatch(&store), SQLITE_MISUSE);
+
+  int score;
+  EXPECT_EQ(readScore(&store, &score), SQLITE_OK);
+  EXPECT_EQ(score, 20);
+  closeScoreStore(&store);
+  removeStoreFiles();
+}
+
+TEST(ScoreStoreTest, ReportsErrorsInsteadOfIgnoringThem) {
+  ScoreStore_t store = {};
+  int score = 7;
+  EXPECT_EQ(readScore(&store, &score), SQLITE_MISUSE);
+  EXPECT_EQ(writeScore(&store, 1), SQLITE_MISUSE);
+  EXPECT_EQ(beginScoreBatch(&store), SQLITE_MISUSE);
+  EXPECT_NE(openScoreStore(&store, "/nonexistent/dir/scores.db", "test_scores"),
+            SQLITE_OK);
+  EXPECT_FALSE(isScoreStoreOpen(&store));
+}
+
+TEST(ScoreStoreTest, RecordsStatementLatency) {
+  removeStoreFiles();
+  ScoreStore_t store = {};
+  ASSERT_EQ(openScoreStore(&store, kStorePath, "test_scores"), SQLITE_OK);
+
+  auto before = std::make_unique<MetricsSnapshot_t>();
+  auto after = std::make_unique<MetricsSnapshot_t>();
+  readMetrics(before.get());
+  int score;
+  for (int i = 0; i < 5; ++i) readScore(&store, &score);
+  readMetrics(after.get());
+
+  EXPECT_EQ(after->latencies[METRIC_DB_LATENCY].count -
+                before->latencies[METRIC_DB_LATENCY].count,
+            5u);
+  EXPECT_EQ(after->counters[METRIC_DB_OPS] - before->counters[METRIC_DB_OPS],
+            5u);
+  closeScoreStore(&store);
+  removeStoreFiles();
+}
@@ -0,0 +1,132 @@
+#include <type_traits>
+
+#include "test_includes.h"
+
+// =============================================================================
+// Snapshot Tests - a restored game continues exactly like the original
+// =============================================================================
+
+namespace {
+
+// Runs a game on a virtual clock with the stores suspended, so two runs
+// from the same snapshot see the same time and nothing is persisted.
+class SnakeSnapshotTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    setGameClock(&clock);
+    suspendScoreStores(true);
+  }
+
+  void TearDown() override {
+    suspendScoreStores(false);
+    setGameClock(nullptr);
+  }
+
+  // A move per tick, turning every few ticks so the snake wanders.
+  std::vector<Frame_t> play(Controller &game, int ticks) {
+    const UserAction_t turns[] = {Left, Down, Right, Up};
+    std::vector<Frame_t> frames(ticks);
+    for (int i = 0; i < ticks; ++i) {
+      clock += INIT_SPEED;
+      if (i % 3 == 0) game.userInput(turns[i / 3 % 4], false);
+      game.processTimer();
+      game.fillFrame(&frames[i]);
+    }
+    return frames;
+  }
+
+  static void expectSameFrames(const std::vector<Frame_t> &expected,
+                               const std::vector<Frame_t> &actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(memcmp(expected[i].field, actual[i].field,
+                       sizeof(expected[i].field)),
+                0)
+          << "tick " << i;
+      EXPECT_EQ(expected[i].score, actual[i].score) << "tick " << i;
+      EXPECT_EQ(expected[i].pause, actual[i].pause) << "tick " << i;
+    }
+  }
+
+  unsigned long long clock = 1000;
+};
+
+}  // namespace
+
+TEST_F(SnakeSnapshotTest, IsCompactPod) {
+  EXPECT_TRUE(std::is_trivially_copyable_v<Controller::Snapshot>);
+  EXPECT_LE(sizeof(Controller::Snapshot), 512u);
+}
+
+TEST_F(SnakeSnapshotTest, RestoreContinuesIdentically) {
+  Controller game;
+  game.seed(7);
+  game.userInput(Start, false);
+  play(game, 4);
+  Controller::Snapshot snapshot = game.snapshot();
+  unsigned long long saved_clock = clock;
+  std::vector<Frame_t> original = play(game, 40);
+
+  clock = saved_clock;
+  game.restore(snapshot);
+  expectSameFrames(original, play(game, 40));
+
+  // Into another game, apples included: the RNG travels with the snapshot.
+  Controller other;
+  clock = saved_clock;
+  other.restore(snapshot);
+  expectSameFrames(original, play(other, 40));
+}
+
+TEST_F(SnakeSnapshotTest, RoundTripDoesNotAllocate) {
+  if (!allocTrackingSupported()) GTEST_SKIP();
+  Controller game;
+  game.userInput(Start, false);
+  play(game, 4);
+
+  startAllocTracking();
+  Controller::Snapshot snapshot = game.snapshot();
+  game.restore(snapshot);
+  EXPECT_EQ(stopAllocTracking().mallocs, 0ULL);
+}
+
+TEST_F(SnakeSnapshotTest, LoadRejectsImpossibleStates) {
+  const EngineOps_t *ops = getEngineOps();
+  void *game = ops->create();
+  ops->input(game, Start, false);
+  static_cast<Controller *>(game)->processTimer();
+  Controller::Snapshot valid = static_cast<Controller *>(game)->snapshot();
+  ASSERT_EQ(valid.state, SnakeFSM::State_t::MOVING);
+  EXPECT_TRUE(ops->load(game, &valid, sizeof(valid)));
+
+  using Snapshot = Controller::Snapshot;
+  auto rejects = [&](void (*corrupt)(Snapshot *)) {
+    Snapshot snapshot = valid;
+    corrupt(&snapshot);
+    return !ops->load(game, &snapshot, sizeof(snapshot));
+  };
+  EXPECT_TRUE(rejects([](Snapshot *s) { s->length = 0; }));
+  EXPECT_TRUE(rejects([](Snapshot *s) { s->length = -1; }));
+  EXPECT_TRUE(rejects([](Snapshot *s) {
+    s->length = sizeof(s->body) / sizeof(s->body[0]) + 1;
+  }));
+  EXPECT_TRUE(
+      rejects([](Snapshot *s) { s->state = (SnakeFSM::State_t)9; }));
+  EXPECT_TRUE(rejects([](Snapshot *s) {
+    s->current_direction = (SnakeModel::Direction_t)-1;
+  }));
+  EXPECT_TRUE(rejects(
+      [](Snapshot *s) { s->next_direction = (SnakeModel::Direction_t)4; }));
+  EXPECT_TRUE(rejects([](Snapshot *s) { s->base_speed = 0; }));
+  EXPECT_TRUE(rejects([](Snapshot *s) { s->current_speed = -5; }));
+  EXPECT_TRUE(rejects([](Snapshot *s) { s->auto_repeat.arr = 0; }));
+  EXPECT_TRUE(rejects([](Snapshot *s) { s->auto_repeat.repeating = Start; }));
+  EXPECT_TRUE(rejects([](Snapshot *s) { s->auto_repeat.repeating = 8; }));
+
+  // The menu and the game over screen have no snake to move.
+  EXPECT_FALSE(rejects([](Snapshot *s) {
+    s->state = SnakeFSM::State_t::GAME_OVER;
+    s->length = 0;
+  }));
+  ops->destroy(game);
+}
@@ -0,0 +1,160 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Spectator Tests - frames survive the delta stream, late joiners catch up
+// =============================================================================
+
+namespace {
+
+const uint32_t kInterval = 16;
+
+// A wandering snake on a virtual clock, a frame per tick.
+std::vector<Frame_t> playSnake(int ticks) {
+  unsigned long long clock = 1000;
+  setGameClock(&clock);
+  suspendScoreStores(true);
+  const UserAction_t turns[] = {Left, Down, Right, Up};
+  Controller game;
+  game.seed(11);
+  game.userInput(Start, false);
+  std::vector<Frame_t> frames(ticks);
+  for (int i = 0; i < ticks; ++i) {
+    clock += INIT_SPEED;
+    if (i % 3 == 0) game.userInput(turns[i / 3 % 4], false);
+    game.processTimer();
+    game.fillFrame(&frames[i]);
+  }
+  suspendScoreStores(false);
+  setGameClock(nullptr);
+  return frames;
+}
+
+std::vector<uint8_t> encode(std::vector<Frame_t> &frames, uint32_t interval) {
+  SpectatorEncoder_t encoder;
+  startSpectatorEncoder(&encoder, interval);
+  std::vector<uint8_t> stream;
+  uint8_t message[SPECTATOR_MESSAGE_MAX];
+  for (Frame_t &frame : frames) {
+    int *field_rows[FIELD_H];
+    int *next_rows[NEXT_H];
+    size_t size = encodeSpectatorFrame(
+        &encoder, frameToGameInfo(&frame, field_rows, next_rows), message);
+    stream.insert(stream.end(), message, message + size);
+  }
+  return stream;
+}
+
+// Size of the message at offset, its varint size included.
+size_t messageSize(const std::vector<uint8_t> &stream, size_t offset) {
+  if (stream[offset] < 0x80) return 1 + stream[offset];
+  return 2 + ((stream[offset] & 0x7F) | stream[offset + 1] << 7);
+}
+
+void expectSameFrame(const Frame_t &expected, const Frame_t &actual) {
+  EXPECT_EQ(memcmp(expected.field, actual.field, sizeof(expected.field)), 0);
+  EXPECT_EQ(memcmp(expected.next, actual.next, sizeof(expected.next)), 0);
+  EXPECT_EQ(expected.score, actual.score);
+  EXPECT_EQ(expected.high_score, actual.high_score);
+  EXPECT_EQ(expected.level, actual.level);
+  EXPECT_EQ(expected.speed, actual.speed);
+  EXPECT_EQ(expected.pause, actual.pause);
+}
+
+}  // namespace
+
+TEST(SpectatorTest, DecodesEveryFrameAtAFractionOfTheGrid) {
+  std::vector<Frame_t> frames = playSnake(200);
+  std::vector<uint8_t> stream = encode(frames, kInterval);
+  EXPECT_LT(stream.size() * 50, frames.size() * sizeof(frames[0].field));
+
+  SpectatorDecoder_t decoder;
+  startSpectatorDecoder(&decoder);
+  size_t offset = 0;
+  for (size_t i = 0; i < frames.size(); ++i) {
+    size_t used = 0;
+    ASSERT_EQ(decodeSpectatorMessage(&decoder, stream.data() + offset,
+                                     stream.size() - offset, &used),
+              SPECTATOR_FRAME)
+        << "frame " << i;
+    offset += used;
+    expectSameFrame(frames[i], decoder.frame);
+    EXPECT_EQ(decoder.frame.frame_id, i);
+  }
+  EXPECT_EQ(offset, stream.size());
+  EXPECT_EQ(decoder.keyframes, (frames.size() + kInterval - 1) / kInterval);
+}
+
+TEST(SpectatorTest, LateJoinerStartsAtTheNextKeyframe) {
+  std::vector<Frame_t> frames = playSnake(40);
+  std::vector<uint8_t> stream = encode(frames, kInterval);
+
+  // Skip the first five messages, as a spectator connecting mid-game would.
+  size_t offset = 0;
+  for (int i = 0; i < 5; ++i)
+    offset += messageSize(stream, offset);
+  SpectatorDecoder_t decoder;
+  startSpectatorDecoder(&decoder);
+  for (size_t i = 5; i < frames.size(); ++i) {
+    size_t used = 0;
+    SpectatorResult_t result = decodeSpectatorMessage(
+        &decoder, stream.data() + offset, stream.size() - offset, &used);
+    offset += used;
+    if (i < kInterval) {
+      EXPECT_EQ(result, SPECTATOR_SKIPPED) << "frame " << i;
+    } else {
+      ASSERT_EQ(result, SPECTATOR_FRAME) << "frame " << i;
+      expectSameFrame(frames[i], decoder.frame);
+    }
+  }
+  EXPECT_EQ(decoder.skipped, kInterval - 5);
+}
+
+TEST(SpectatorTest, LostMessageWaitsForAKeyframe) {
+  std::vector<Frame_t> frames = playSnake(40);
+  std::vector<uint8_t> stream = encode(frames, kInterval);
+
+  SpectatorDecoder_t decoder;
+  startSpectatorDecoder(&decoder);
+  size_t offset = 0;
+  for (size_t i = 0; i < frames.size(); ++i) {
+    size_t used = 0;
+    // Half a message first: nothing is taken until the rest arrives.
+    EXPECT_EQ(decodeSpectatorMessage(&decoder, stream.data() + offset, 3,
+                                     &used),
+              SPECTATOR_PARTIAL);
+    EXPECT_EQ(used, 0u);
+    if (i == 3) {
+      // Frame 3 never arrives, so frame 4 has nothing to apply to.
+      offset += messageSize(stream, offset);
+      continue;
+    }
+    SpectatorResult_t result = decodeSpectatorMessage(
+        &decoder, stream.data() + offset, stream.size() - offset, &used);
+    offset += used;
+    if (i > 3 && i < kInterval)
+      EXPECT_EQ(result, SPECTATOR_SKIPPED) << "frame " << i;
+    else
+      EXPECT_EQ(result, SPECTATOR_FRAME) << "frame " << i;
+  }
+  expectSameFrame(frames.back(), decoder.frame);
+}
+
+TEST(SpectatorTest, CorruptMessageIsRejected) {
+  std::vector<Frame_t> frames = playSnake(2);
+  std::vector<uint8_t> stream = encode(frames, kInterval);
+  SpectatorDecoder_t decoder;
+  startSpectatorDecoder(&decoder);
+  size_t used = 0;
+  size_t keyframe = messageSize(stream, 0);
+  ASSERT_EQ(decodeSpectatorMessage(&decoder, stream.data(), keyframe, &used),
+            SPECTATOR_FRAME);
+
+  // A cell run past the end of the grid.
+  std::vector<uint8_t> bad = {6, 1, 0, 0, 0xFF, 0x7F, 0};
+  bad[2] = static_cast<uint8_t>(decoder.sequence + 1);
+  EXPECT_EQ(decodeSpectatorMessage(&decoder, bad.data(), bad.size(), &used),
+            SPECTATOR_CORRUPT);
+  EXPECT_EQ(used, bad.size());
+  EXPECT_FALSE(decoder.synced);
+  expectSameFrame(frames[0], decoder.frame);
+}
@@ -1,11 +1,42 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <memory>
+#include <sstream>
+#include <string>
 #include <thread>
+#include <vector>
 
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "./../brick_game/common/alloc_tracker.h"
+#include "./../brick_game/common/auto_repeat.h"
+#include "./../brick_game/common/corpus.h"
+#include "./../brick_game/common/engine.h"
+#include "./../brick_game/common/event_ring.h"
+#include "./../brick_game/common/frame_delta.h"
+#include "./../brick_game/common/latency.h"
+#include "./../brick_game/common/metrics.h"
+#include "./../brick_game/common/perf_counters.h"
+#include "./../brick_game/common/replay.h"
+#include "./../brick_game/common/replay_archive.h"
+#include "./../brick_game/common/rollback.h"
+#include "./../brick_game/common/rng.h"
+#include "./../brick_game/common/score_store.h"
+#include "./../brick_game/common/seqlock.h"
+#include "./../brick_game/common/spectator.h"
+#include "./../brick_game/common/trace.h"
+#include "./../brick_game/common/triple_buffer.h"
 #include "./../brick_game/snake/controller.h"
 #include "./../brick_game/snake/fsm.h"
 #include "./../brick_game/snake/model.h"
+#include "./../gui/common/viewport.h"
 
 using namespace brickgame;
\ No newline at end of file
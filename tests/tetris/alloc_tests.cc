@@ -0,0 +1,49 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Allocation Tests - steady-state engine calls must not touch the heap
+// =============================================================================
+
+class TetrisAllocTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (!allocTrackingSupported()) GTEST_SKIP();
+    userInput(Start, false);
+    userInput((UserAction_t)-1, false);
+    ASSERT_EQ(getCurrentState()->status, Moving);
+  }
+};
+
+TEST_F(TetrisAllocTest, SnapshotDoesNotAllocate) {
+  Frame_t frame;
+  startAllocTracking();
+  fillFrame(&frame);
+  EXPECT_EQ(stopAllocTracking().mallocs, 0ULL);
+}
+
+TEST_F(TetrisAllocTest, MoveAndRotateDoNotAllocate) {
+  startAllocTracking();
+  userInput(Left, false);
+  userInput(Right, false);
+  userInput(Right, false);
+  userInput(Action, false);
+  AllocStats_t stats = stopAllocTracking();
+
+  EXPECT_EQ(stats.mallocs, 0ULL);
+  EXPECT_EQ(stats.frees, 0ULL);
+}
+
+TEST_F(TetrisAllocTest, GravityTickDoesNotAllocate) {
+  for (int i = 0; i < 3; ++i) {
+    int row = getCurrentState()->x;
+
+    startAllocTracking();
+    processTimer();
+    userInput((UserAction_t)-1, false);
+    AllocStats_t stats = stopAllocTracking();
+
+    EXPECT_EQ(getCurrentState()->x, row + 1);
+    EXPECT_EQ(stats.mallocs, 0ULL);
+    EXPECT_EQ(stats.frees, 0ULL);
+  }
+}
@@ -0,0 +1,80 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Event Tests - gameplay events recorded by the Tetris engine
+// =============================================================================
+
+static const GameEvent_t *lastEvent(GameEventType_t type) {
+  const EventRing_t *ring = getEventRing();
+  for (uint32_t i = ring->head; i > 0 && ring->head - i < EVENT_RING_SIZE;
+       i--) {
+    const GameEvent_t *event = &ring->events[(i - 1) % EVENT_RING_SIZE];
+    if (event->type == type) return event;
+  }
+  return NULL;
+}
+
+TEST(TetrisEventTest, RecordsSpawnLockAndGameOver) {
+  userInput(Start, false);
+  userInput((UserAction_t)-1, false);
+  ASSERT_EQ(getCurrentState()->status, Moving);
+
+  const GameEvent_t *spawned = lastEvent(EVENT_PIECE_SPAWNED);
+  ASSERT_NE(spawned, nullptr);
+  EXPECT_EQ(spawned->a, getCurrentState()->block_type);
+  EXPECT_LT(spawned->b, 4);
+
+  const GameEvent_t *changed = lastEvent(EVENT_STATE_CHANGED);
+  ASSERT_NE(changed, nullptr);
+  EXPECT_EQ(changed->b, Moving);
+
+  uint32_t tick = getEventRing()->tick;
+  userInput(Down, false);
+  userInput((UserAction_t)-1, false);
+  const GameEvent_t *locked = lastEvent(EVENT_PIECE_LOCKED);
+  ASSERT_NE(locked, nullptr);
+  EXPECT_EQ(locked->tick, tick + 1);
+
+  std::remove("tetris_events.bin");
+  for (int i = 0; i < 1000 && getCurrentState()->status != GameOver; ++i) {
+    if (getCurrentState()->status == Moving) userInput(Down, false);
+    userInput((UserAction_t)-1, false);
+  }
+  ASSERT_EQ(getCurrentState()->status, GameOver);
+  EXPECT_EQ(lastEvent(EVENT_STATE_CHANGED)->b, GameOver);
+
+  FILE *dump = fopen("tetris_events.bin", "rb");
+  ASSERT_NE(dump, nullptr);
+  EventDumpHeader_t header;
+  ASSERT_EQ(fread(&header, sizeof(header), 1, dump), 1u);
+  fclose(dump);
+  std::remove("tetris_events.bin");
+  EXPECT_EQ(header.head, getEventRing()->head);
+
+  userInput(Start, false);
+}
+
+TEST(TetrisEventTest, CountsClearedLines) {
+  suspendScoreStores(true);
+  userInput(Start, false);
+  State_t *state = getCurrentState();
+  ASSERT_EQ(state->lines, 0);
+  for (int j = 0; j < FIELD_W; ++j) {
+    state->field[FIELD_H - 1][j] = 1;
+    state->field[FIELD_H - 2][j] = 1;
+  }
+  deleteLines();
+
+  EXPECT_EQ(state->lines, 2);
+  const GameEvent_t *cleared = lastEvent(EVENT_LINES_CLEARED);
+  ASSERT_NE(cleared, nullptr);
+  EXPECT_EQ(cleared->a, 2);
+  Frame_t frame;
+  fillFrame(&frame);
+  EXPECT_EQ(frame.lines, 2);
+  EXPECT_EQ(frame.score, 300);
+
+  requestTermination();
+  EXPECT_EQ(getCurrentState()->lines, 0);
+  suspendScoreStores(false);
+}
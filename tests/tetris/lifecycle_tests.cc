@@ -0,0 +1,55 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Lifecycle Tests - restarts reuse the buffers and the storage connection
+// =============================================================================
+
+static void playUntilGameOver() {
+  for (int i = 0; i < 1000 && getCurrentState()->status != GameOver; ++i) {
+    if (getCurrentState()->status == Moving) userInput(Down, false);
+    userInput((UserAction_t)-1, false);
+  }
+  ASSERT_EQ(getCurrentState()->status, GameOver);
+}
+
+TEST(TetrisLifecycleTest, RestartReusesBuffersAndConnection) {
+  userInput(Start, false);
+  userInput((UserAction_t)-1, false);
+  State_t *state = getCurrentState();
+  int **field = state->field;
+  sqlite3 *db = getScoreStore()->db;
+  ASSERT_NE(db, nullptr);
+
+  playUntilGameOver();
+  userInput(Start, false);
+  userInput((UserAction_t)-1, false);
+
+  EXPECT_EQ(state->status, Moving);
+  EXPECT_EQ(state->field, field);
+  EXPECT_EQ(getScoreStore()->db, db);
+  EXPECT_EQ(state->score, 0);
+  for (int i = 0; i < FIELD_H; ++i)
+    for (int j = 0; j < FIELD_W; ++j) EXPECT_EQ(state->field[i][j], 0);
+}
+
+TEST(TetrisLifecycleTest, RepeatedStartDoesNotLeak) {
+  if (!allocTrackingSupported()) GTEST_SKIP();
+  userInput(Start, false);
+  userInput((UserAction_t)-1, false);
+
+  startAllocTracking();
+  for (int i = 0; i < 10; ++i) {
+    userInput(Start, false);
+    userInput((UserAction_t)-1, false);
+  }
+  AllocStats_t stats = stopAllocTracking();
+  EXPECT_EQ(stats.mallocs, stats.frees);
+}
+
+TEST(TetrisLifecycleTest, TerminationClosesStorage) {
+  userInput(Start, false);
+  ASSERT_NE(getScoreStore()->db, nullptr);
+  userInput(Terminate, false);
+  EXPECT_EQ(getScoreStore()->db, nullptr);
+  EXPECT_EQ(getCurrentState()->status, Initial);
+}
@@ -0,0 +1,258 @@
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "test_includes.h"
+
+// =============================================================================
+// Replay Tests - a recorded tetris session plays back bit for bit
+// =============================================================================
+
+namespace {
+
+void expectSameGame(const Frame_t &expected, const Frame_t &actual) {
+  EXPECT_EQ(memcmp(expected.field, actual.field, sizeof(expected.field)), 0);
+  EXPECT_EQ(memcmp(expected.next, actual.next, sizeof(expected.next)), 0);
+  EXPECT_EQ(expected.score, actual.score);
+  EXPECT_EQ(expected.pause, actual.pause);
+}
+
+// Plays seconds of tetris on a virtual clock and records it the way the
+// engine does, claiming the frame after every call. With hold, every move is
+// held for 100 ms, long enough to auto-repeat at short rates.
+void recordVirtualSession(const char *path, int seconds, bool hold = false,
+                          unsigned long long keyframe_interval = 64) {
+  unsigned long long clock = 1000;
+  setGameClock(&clock);
+  suspendScoreStores(true);
+  const EngineOps_t *ops = getEngineOps();
+  void *game = ops->create();
+  ops->seed(game, 11);
+  ReplayRecorder_t recorder;
+  startReplayRecording(&recorder, path, ops, game, 11, clock,
+                       keyframe_interval);
+
+  Frame_t frame;
+  auto call = [&](int action, bool held = false) {
+    recordReplayEntry(&recorder, clock, action, held);
+    if (action == REPLAY_ADVANCE)
+      stepGameClock(ops, game);
+    else
+      ops->input(game, (UserAction_t)action, held);
+    ops->fill(game, &frame);
+    claimReplayResult(&recorder, &frame);
+  };
+  const UserAction_t moves[] = {Left, Right, Action, Down, Down};
+  call(Start);
+  for (int t = 50; t <= seconds * 1000; t += 50) {
+    clock += 50;
+    if (frame.pause == GOTryAgain)
+      call(Start);
+    else if (t % 200 == 0)
+      call(moves[t / 200 % 5], hold);
+    else if (hold && t % 200 == 100)
+      call(moves[t / 200 % 5]);
+    call(REPLAY_ADVANCE);
+  }
+
+  stopReplayRecording(&recorder);
+  ops->destroy(game);
+  suspendScoreStores(false);
+  setGameClock(NULL);
+}
+
+// Rewrites a replay recorded without keyframes keeping only every keep-th
+// advance entry, 0 for none, with the claim moved to the entries left.
+void dropAdvances(const char *from, const char *to, int keep) {
+  FILE *in = fopen(from, "rb");
+  FILE *out = fopen(to, "wb");
+  ReplayHeader_t header;
+  ASSERT_EQ(fread(&header, sizeof(header), 1, in), 1u);
+  fwrite(&header, sizeof(header), 1, out);
+
+  ReplayEntry_t entry;
+  unsigned long long pending = 0, written = 0;
+  int advances = 0;
+  while (readReplayEntry(in, &entry) && entry.action != REPLAY_END) {
+    ASSERT_NE(entry.action, REPLAY_KEYFRAME);
+    if (entry.action == REPLAY_ADVANCE && (keep == 0 || ++advances % keep)) {
+      pending += entry.delta;
+      continue;
+    }
+    entry.delta += pending;
+    pending = 0;
+    writeReplayEntry(out, &entry);
+    written++;
+  }
+  ReplayEntry_t end = {0, REPLAY_END, false};
+  writeReplayEntry(out, &end);
+
+  ReplayFooter_t footer;
+  fseek(in, -(long)sizeof(footer), SEEK_END);
+  ASSERT_EQ(fread(&footer, sizeof(footer), 1, in), 1u);
+  footer.index_offset = (uint64_t)ftell(out);
+  footer.claim.entries = written;
+  fwrite(&footer, sizeof(footer), 1, out);
+  fclose(in);
+  fclose(out);
+}
+
+}  // namespace
+
+TEST(TetrisReplayTest, PlaybackReproducesRecordedSession) {
+  const char *path = "tetris_replay_test.bin";
+  setenv(REPLAY_RECORD_ENV, path, 1);
+  setenv(REPLAY_KEYFRAME_ENV, "3", 1);
+  EngineThread_t *engine = startEngineThread(getEngineOps());
+  const struct {
+    UserAction_t action;
+    bool hold;
+    int millis;
+  } steps[] = {{Start, false, 40},  {Left, true, 250},  {Left, false, 20},
+               {Action, false, 20}, {Down, false, 60},  {Right, false, 20},
+               {Down, false, 60},   {Action, false, 30}, {Pause, false, 30}};
+  for (const auto &step : steps) {
+    submitInput(engine, step.action, step.hold);
+    std::this_thread::sleep_for(std::chrono::milliseconds(step.millis));
+  }
+  Frame_t recorded = {};
+  readFrame(engine, &recorded);
+  stopEngineThread(engine);
+  unsetenv(REPLAY_RECORD_ENV);
+  unsetenv(REPLAY_KEYFRAME_ENV);
+  int filled = 0;
+  for (int i = 0; i < FIELD_H; i++)
+    for (int j = 0; j < FIELD_W; j++) filled += recorded.field[i][j] != 0;
+  ASSERT_GT(filled, 0);
+
+  ReplayPlayer_t player;
+  ASSERT_TRUE(openReplay(&player, path, getEngineOps()));
+  fastForwardReplay(&player);
+  Frame_t replayed;
+  fillReplayFrame(&player, &replayed);
+  expectSameGame(recorded, replayed);
+
+  // Back to the middle through a keyframe, then forwards to the end again.
+  ASSERT_GT(player.keyframe_count, 0u);
+  unsigned long long middle = replayElapsed(&player) / 2;
+  unsigned long long end = replayElapsed(&player);
+  seekReplay(&player, middle);
+  Frame_t sought;
+  fillReplayFrame(&player, &sought);
+  unsigned long long sought_entries = player.entries;
+  seekReplay(&player, end);
+  fillReplayFrame(&player, &replayed);
+  closeReplay(&player);
+  expectSameGame(recorded, replayed);
+
+  ASSERT_TRUE(openReplay(&player, path, getEngineOps()));
+  advanceReplay(&player, middle);
+  Frame_t linear;
+  fillReplayFrame(&player, &linear);
+  EXPECT_EQ(player.entries, sought_entries);
+  closeReplay(&player);
+  expectSameGame(linear, sought);
+  std::remove(path);
+}
+
+TEST(TetrisReplayTest, VerifiesClaimsOnParallelThreads) {
+  const char *path = "tetris_verify_test.bin";
+  recordVirtualSession(path, 120);
+  ReplayCheck_t expected;
+  ASSERT_EQ(verifyReplay(path, getEngineOps(), &expected), REPLAY_VERIFIED);
+  EXPECT_EQ(expected.claim.entries, expected.entries);
+  EXPECT_GE(expected.millis, 120000u);
+
+  // Every thread plays its own game; none sees another's pieces.
+  std::vector<ReplayCheck_t> checks(4);
+  std::vector<std::thread> workers;
+  for (auto &check : checks)
+    workers.emplace_back([&check, path] {
+      verifyReplay(path, getEngineOps(), &check);
+    });
+  for (auto &worker : workers) worker.join();
+  for (const auto &check : checks) {
+    EXPECT_EQ(check.verdict, REPLAY_VERIFIED);
+    EXPECT_EQ(check.score, expected.score);
+    EXPECT_EQ(check.lines, expected.lines);
+    EXPECT_EQ(check.entries, expected.entries);
+  }
+
+  // A claim the session never reached.
+  FILE *file = fopen(path, "r+b");
+  ReplayFooter_t footer;
+  fseek(file, -(long)sizeof(footer), SEEK_END);
+  ASSERT_EQ(fread(&footer, sizeof(footer), 1, file), 1u);
+  footer.claim.lines += 1;
+  fseek(file, -(long)sizeof(footer), SEEK_END);
+  fwrite(&footer, sizeof(footer), 1, file);
+  fclose(file);
+  ReplayCheck_t tampered;
+  EXPECT_EQ(verifyReplay(path, getEngineOps(), &tampered), REPLAY_MISMATCH);
+  EXPECT_EQ(tampered.lines, expected.lines);
+  std::remove(path);
+}
+
+TEST(TetrisReplayTest, PlaybackKeepsRecordedRepeatRates) {
+  const char *path = "tetris_rates_test.bin";
+  setenv("BRICKGAME_DAS_MS", "40", 1);
+  setenv("BRICKGAME_ARR_MS", "10", 1);
+  recordVirtualSession(path, 30, true);
+  ReplayHeader_t header;
+  ReplayClaim_t claim;
+  ASSERT_TRUE(peekReplay(path, &header, &claim));
+  EXPECT_EQ(header.das_millis, 40u);
+  EXPECT_EQ(header.arr_millis, 10u);
+
+  // Another machine's settings must not change how held moves replay.
+  setenv("BRICKGAME_DAS_MS", "300", 1);
+  setenv("BRICKGAME_ARR_MS", "120", 1);
+  ReplayPlayer_t player;
+  ASSERT_TRUE(openReplay(&player, path, getEngineOps()));
+  int das = 0, arr = 0;
+  player.ops->repeatRates(player.game, &das, &arr);
+  EXPECT_EQ(das, 40);
+  EXPECT_EQ(arr, 10);
+  closeReplay(&player);
+  ReplayCheck_t check;
+  EXPECT_EQ(verifyReplay(path, getEngineOps(), &check), REPLAY_VERIFIED);
+  unsetenv("BRICKGAME_DAS_MS");
+  unsetenv("BRICKGAME_ARR_MS");
+  std::remove(path);
+}
+
+TEST(TetrisReplayTest, RejectsReplaysWithoutGravity) {
+  const char *path = "tetris_gravity_test.bin";
+  const char *forged = "tetris_forged_test.bin";
+  recordVirtualSession(path, 60, false, 0);
+  ReplayCheck_t check;
+  ASSERT_EQ(verifyReplay(path, getEngineOps(), &check), REPLAY_VERIFIED);
+  EXPECT_EQ(check.missed_ticks, 0u);
+
+  // The inputs alone, or with a tick every two seconds, never let the
+  // pieces fall on time, even once the claim matches what they reach.
+  for (int keep : {0, 40}) {
+    dropAdvances(path, forged, keep);
+    ReplayCheck_t forged_check;
+    EXPECT_EQ(verifyReplay(forged, getEngineOps(), &forged_check),
+              REPLAY_MISMATCH);
+    EXPECT_GT(forged_check.missed_ticks, 0u);
+
+    FILE *file = fopen(forged, "r+b");
+    ReplayFooter_t footer;
+    fseek(file, -(long)sizeof(footer), SEEK_END);
+    ASSERT_EQ(fread(&footer, sizeof(footer), 1, file), 1u);
+    footer.claim.score = forged_check.score;
+    footer.claim.level = forged_check.level;
+    footer.claim.lines = forged_check.lines;
+    fseek(file, -(long)sizeof(footer), SEEK_END);
+    fwrite(&footer, sizeof(footer), 1, file);
+    fclose(file);
+    EXPECT_EQ(verifyReplay(forged, getEngineOps(), &forged_check),
+              REPLAY_MISMATCH)
+        << "keeping every " << keep << "th tick";
+  }
+  std::remove(forged);
+  std::remove(path);
+}
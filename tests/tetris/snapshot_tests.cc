@@ -0,0 +1,128 @@
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "test_includes.h"
+
+// =============================================================================
+// Snapshot Tests - a restored game continues exactly like the original
+// =============================================================================
+
+namespace {
+
+// Runs the game on a virtual clock with the stores suspended, so two runs
+// from the same snapshot see the same time and nothing is persisted.
+class TetrisSnapshotTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    setGameClock(&clock);
+    suspendScoreStores(true);
+    seedGame(7);
+    userInput(Start, false);
+  }
+
+  void TearDown() override {
+    suspendScoreStores(false);
+    setGameClock(nullptr);
+  }
+
+  // Ticks in 50 ms steps the way the engine does, with a move now and then,
+  // so pieces spawn, fall and lock.
+  std::vector<Frame_t> play(int ticks) {
+    const UserAction_t moves[] = {Left, Action, Right, Down};
+    std::vector<Frame_t> frames(ticks);
+    for (int i = 0; i < ticks; ++i) {
+      clock += 50;
+      if (i % 4 == 0) userInput(moves[i / 4 % 4], false);
+      if (processTimer() == 0) userInput((UserAction_t)-1, false);
+      fillFrame(&frames[i]);
+    }
+    return frames;
+  }
+
+  static void expectSameFrames(const std::vector<Frame_t> &expected,
+                               const std::vector<Frame_t> &actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(memcmp(expected[i].field, actual[i].field,
+                       sizeof(expected[i].field)),
+                0)
+          << "tick " << i;
+      EXPECT_EQ(memcmp(expected[i].next, actual[i].next,
+                       sizeof(expected[i].next)),
+                0)
+          << "tick " << i;
+      EXPECT_EQ(expected[i].score, actual[i].score) << "tick " << i;
+    }
+  }
+
+  unsigned long long clock = 1000;
+};
+
+}  // namespace
+
+TEST_F(TetrisSnapshotTest, IsCompactPod) {
+  EXPECT_TRUE(std::is_trivially_copyable_v<TetrisSnapshot_t>);
+  EXPECT_LE(sizeof(TetrisSnapshot_t), 512u);
+}
+
+TEST_F(TetrisSnapshotTest, RestoreContinuesIdentically) {
+  play(10);
+  TetrisSnapshot_t snapshot;
+  snapshotGame(&snapshot);
+  unsigned long long saved_clock = clock;
+  std::vector<Frame_t> original = play(200);
+
+  clock = saved_clock;
+  restoreGame(&snapshot);
+  expectSameFrames(original, play(200));
+}
+
+TEST_F(TetrisSnapshotTest, RoundTripDoesNotAllocate) {
+  if (!allocTrackingSupported()) GTEST_SKIP();
+  play(10);
+  TetrisSnapshot_t snapshot;
+
+  startAllocTracking();
+  snapshotGame(&snapshot);
+  restoreGame(&snapshot);
+  EXPECT_EQ(stopAllocTracking().mallocs, 0ULL);
+}
+
+TEST_F(TetrisSnapshotTest, LoadRejectsImpossibleStates) {
+  play(10);
+  TetrisSnapshot_t valid;
+  snapshotGame(&valid);
+  const EngineOps_t *ops = getEngineOps();
+  void *game = ops->create();
+  EXPECT_TRUE(ops->load(game, &valid, sizeof(valid)));
+
+  auto rejects = [&](void (*corrupt)(TetrisSnapshot_t *)) {
+    TetrisSnapshot_t snapshot = valid;
+    corrupt(&snapshot);
+    return !ops->load(game, &snapshot, sizeof(snapshot));
+  };
+  EXPECT_TRUE(rejects([](TetrisSnapshot_t *s) { s->status = 99; }));
+  EXPECT_TRUE(rejects([](TetrisSnapshot_t *s) { s->previous_status = -1; }));
+  EXPECT_TRUE(
+      rejects([](TetrisSnapshot_t *s) { s->block_size = BLOCK_MAX + 1; }));
+  EXPECT_TRUE(rejects([](TetrisSnapshot_t *s) { s->next_block_size = -1; }));
+  EXPECT_TRUE(rejects([](TetrisSnapshot_t *s) { s->block_type = 7; }));
+  EXPECT_TRUE(rejects([](TetrisSnapshot_t *s) { s->x = FIELD_H + 100; }));
+  EXPECT_TRUE(rejects([](TetrisSnapshot_t *s) { s->y = -1000; }));
+  EXPECT_TRUE(rejects([](TetrisSnapshot_t *s) { s->auto_repeat.arr = 0; }));
+  EXPECT_TRUE(
+      rejects([](TetrisSnapshot_t *s) { s->auto_repeat.repeating = Pause; }));
+  // A piece cell past the right wall or below the floor.
+  EXPECT_TRUE(rejects([](TetrisSnapshot_t *s) {
+    s->block_size = 2;
+    s->block[0][1] = 1;
+    s->y = FIELD_W - 1;
+  }));
+  EXPECT_TRUE(rejects([](TetrisSnapshot_t *s) {
+    s->block_size = 2;
+    s->block[0][0] = 1;
+    s->x = FIELD_H;
+  }));
+  ops->destroy(game);
+}
@@ -0,0 +1,5 @@
+#include <gtest/gtest.h>
+
+#include "./../../brick_game/common/alloc_tracker.h"
+#include "./../../brick_game/common/replay.h"
+#include "./../../brick_game/tetris/backend.h"
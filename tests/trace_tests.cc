@@ -0,0 +1,69 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Trace Tests - Chrome trace-event export
+// =============================================================================
+
+static std::string readFile(const char *path) {
+  std::ifstream in(path);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+TEST(TraceTest, DisabledSpansRecordNothing) {
+  TraceSpan_t span;
+  beginTraceSpan(&span, "ignored");
+  EXPECT_EQ(span.name, nullptr);
+  endTraceSpan(&span);
+}
+
+TEST(TraceTest, WritesSpansFromEveryThread) {
+  const char *path = "trace_test.json";
+  ASSERT_TRUE(startTracing(path));
+  ASSERT_TRUE(tracingEnabled());
+
+  setTraceThreadName("test");
+  TraceSpan_t span;
+  beginTraceSpan(&span, "outer");
+  traceInstant("marker");
+  std::thread worker([] {
+    TraceSpan_t inner;
+    beginTraceSpan(&inner, "worker span");
+    endTraceSpan(&inner);
+  });
+  worker.join();
+  endTraceSpan(&span);
+
+  ASSERT_TRUE(stopTracing());
+  EXPECT_FALSE(tracingEnabled());
+
+  std::string trace = readFile(path);
+  std::remove(path);
+  EXPECT_EQ(trace.rfind("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", 0), 0u);
+  EXPECT_NE(trace.find("\"args\":{\"name\":\"test\"}"), std::string::npos);
+  EXPECT_NE(trace.find("{\"name\":\"outer\""), std::string::npos);
+  EXPECT_NE(trace.find("{\"name\":\"worker span\""), std::string::npos);
+  EXPECT_NE(trace.find("\"ph\":\"X\",\"dur\":"), std::string::npos);
+  EXPECT_NE(trace.find("{\"name\":\"marker\""), std::string::npos);
+  EXPECT_NE(trace.find("\"ph\":\"i\""), std::string::npos);
+  EXPECT_EQ(trace.substr(trace.size() - 4), "\n]}\n");
+}
+
+TEST(TraceTest, GameRecordsInputAndStateTransitions) {
+  const char *path = "trace_game_test.json";
+  ASSERT_TRUE(startTracing(path));
+  {
+    Controller controller;
+    controller.userInput(Start, false);
+    controller.processTimer();
+  }
+  ASSERT_TRUE(stopTracing());
+
+  std::string trace = readFile(path);
+  std::remove(path);
+  EXPECT_NE(trace.find("\"userInput\""), std::string::npos);
+  EXPECT_NE(trace.find("\"processTimer\""), std::string::npos);
+  EXPECT_NE(trace.find("\"MOVING\""), std::string::npos);
+  EXPECT_NE(trace.find("\"db read\""), std::string::npos);
+}
@@ -0,0 +1,142 @@
+#include "test_includes.h"
+
+// =============================================================================
+// Viewport Tests - a window of screen cells over a board of any size
+// =============================================================================
+
+namespace {
+
+// A board_h x board_w field with rows the way the renderers get them.
+class Board {
+ public:
+  Board(int height, int width)
+      : cells_(height, std::vector<int>(width, 0)), rows_(height) {
+    for (int i = 0; i < height; ++i) rows_[i] = cells_[i].data();
+  }
+  int **field() { return rows_.data(); }
+  int &at(int row, int col) { return cells_[row][col]; }
+
+ private:
+  std::vector<std::vector<int>> cells_;
+  std::vector<int *> rows_;
+};
+
+}  // namespace
+
+TEST(ViewportTest, ScrollingStopsAtTheBoardEdges) {
+  Viewport_t viewport;
+  initViewport(&viewport, 100, 200, 20, 40);
+
+  scrollViewport(&viewport, -5, -5);
+  EXPECT_EQ(viewport.top, 0);
+  EXPECT_EQ(viewport.left, 0);
+  scrollViewport(&viewport, 7, 9);
+  EXPECT_EQ(viewport.top, 7);
+  EXPECT_EQ(viewport.left, 9);
+  scrollViewport(&viewport, 1000, 1000);
+  EXPECT_EQ(viewport.top, 100 - 20);
+  EXPECT_EQ(viewport.left, 200 - 40);
+}
+
+TEST(ViewportTest, ZoomStepsThroughScalesAroundTheCenter) {
+  Viewport_t viewport;
+  initViewport(&viewport, 100, 200, 20, 40);
+  scrollViewport(&viewport, 40, 80);
+
+  // The center stays on board cell (50, 100) at every scale.
+  const int expected[][3] = {{2, 30, 60}, {4, 10, 20}, {1, 40, 80}};
+  for (const auto &step : expected) {
+    zoomViewport(&viewport);
+    EXPECT_EQ(viewport.scale, step[0]);
+    EXPECT_EQ(viewport.top, step[1]);
+    EXPECT_EQ(viewport.left, step[2]);
+  }
+
+  // Scrolling moves a whole screen cell, scale board cells at a time.
+  zoomViewport(&viewport);
+  scrollViewport(&viewport, 1, -1);
+  EXPECT_EQ(viewport.top, 32);
+  EXPECT_EQ(viewport.left, 58);
+}
+
+TEST(ViewportTest, ZoomOnASmallBoardShowsAllOfIt) {
+  Viewport_t viewport;
+  initViewport(&viewport, 50, 30, 20, 20);
+  EXPECT_EQ(visibleRows(&viewport), 20);
+  EXPECT_EQ(visibleCols(&viewport), 20);
+
+  zoomViewport(&viewport);
+  zoomViewport(&viewport);
+  ASSERT_EQ(viewport.scale, 4);
+  EXPECT_EQ(viewport.top, 0);
+  EXPECT_EQ(viewport.left, 0);
+  EXPECT_EQ(visibleRows(&viewport), 13);  // 50 rows, the last block partial
+  EXPECT_EQ(visibleCols(&viewport), 8);
+}
+
+TEST(ViewportTest, FollowKeepsTheTargetOutsideTheMargin) {
+  Viewport_t viewport;
+  initViewport(&viewport, 100, 100, 20, 20);
+
+  followViewport(&viewport, 10, 10);
+  EXPECT_EQ(viewport.top, 0);
+  EXPECT_EQ(viewport.left, 0);
+
+  // The last row still outside the margin is 20 - VIEWPORT_MARGIN - 1.
+  followViewport(&viewport, 20 - VIEWPORT_MARGIN - 1, 0);
+  EXPECT_EQ(viewport.top, 0);
+  followViewport(&viewport, 20 - VIEWPORT_MARGIN, 0);
+  EXPECT_EQ(viewport.top, 1);
+  followViewport(&viewport, 60, 60);
+  EXPECT_EQ(viewport.top, 60 - 20 + VIEWPORT_MARGIN + 1);
+  EXPECT_EQ(viewport.left, 60 - 20 + VIEWPORT_MARGIN + 1);
+
+  // Back up past the margin, and never beyond the board.
+  followViewport(&viewport, 50, 50);
+  EXPECT_EQ(viewport.top, 44);
+  followViewport(&viewport, 40, 40);
+  EXPECT_EQ(viewport.top, 40 - VIEWPORT_MARGIN);
+  followViewport(&viewport, 99, 0);
+  EXPECT_EQ(viewport.top, 80);
+  EXPECT_EQ(viewport.left, 0);
+
+  // The margin is in screen cells, so it grows with the scale.
+  zoomViewport(&viewport);
+  followViewport(&viewport, 60, 60);
+  EXPECT_EQ(viewport.top, 60 - 2 * VIEWPORT_MARGIN);
+}
+
+TEST(ViewportTest, SamplingTakesTheHighestCellOfEachBlock) {
+  Board board(10, 10);
+  board.at(0, 1) = 1;
+  board.at(1, 0) = 2;
+  board.at(3, 3) = 1;
+  board.at(9, 9) = 3;
+  Viewport_t viewport;
+  initViewport(&viewport, 10, 10, 10, 10);
+
+  EXPECT_EQ(sampleViewportCell(&viewport, board.field(), 0, 1), 1);
+  EXPECT_EQ(sampleViewportCell(&viewport, board.field(), 1, 1), 0);
+
+  zoomViewport(&viewport);
+  ASSERT_EQ(viewport.scale, 2);
+  ASSERT_EQ(viewport.top, 0);
+  EXPECT_EQ(sampleViewportCell(&viewport, board.field(), 0, 0), 2);
+  EXPECT_EQ(sampleViewportCell(&viewport, board.field(), 1, 1), 1);
+  EXPECT_EQ(sampleViewportCell(&viewport, board.field(), 4, 4), 3);
+  EXPECT_EQ(sampleViewportCell(&viewport, board.field(), 2, 2), 0);
+}
+
+TEST(ViewportTest, SamplingStopsAtAPartialBlock) {
+  // 5 x 5 cells at scale 4: the second block row and column hold one cell.
+  Board board(5, 5);
+  board.at(4, 4) = 2;
+  Viewport_t viewport;
+  initViewport(&viewport, 5, 5, 10, 10);
+  zoomViewport(&viewport);
+  zoomViewport(&viewport);
+  ASSERT_EQ(viewport.scale, 4);
+  EXPECT_EQ(visibleRows(&viewport), 2);
+  EXPECT_EQ(sampleViewportCell(&viewport, board.field(), 1, 1), 2);
+  EXPECT_EQ(sampleViewportCell(&viewport, board.field(), 0, 0), 0);
+}
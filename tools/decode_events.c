@@ -0,0 +1,95 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "./../brick_game/common/event_ring.h"
+
+// Prints a dump written by dumpEventRing() oldest event first, one line per
+// event. Slots that were being overwritten during the dump are reported and
+// skipped.
+
+static void printEvent(const GameEvent_t *event) {
+  printf("%8u  %-15s", event->tick, gameEventName(event->type));
+  switch (event->type) {
+    case EVENT_PIECE_SPAWNED:
+      printf(" type=%u rotation=%u", event->a, event->b);
+      break;
+    case EVENT_PIECE_LOCKED:
+      printf(" type=%u row=%d column=%u", event->a, event->value, event->b);
+      break;
+    case EVENT_LINES_CLEARED:
+      printf(" lines=%u score=%d", event->a, event->value);
+      break;
+    case EVENT_LEVEL_UP:
+      printf(" level=%u speed=%d", event->a, event->value);
+      break;
+    case EVENT_APPLE_EATEN:
+      printf(" row=%u column=%u score=%d", event->a, event->b, event->value);
+      break;
+    case EVENT_STATE_CHANGED:
+      printf(" from=%u to=%u score=%d", event->a, event->b, event->value);
+      break;
+    case EVENT_SCORE_PERSISTED:
+      printf(" score=%d", event->value);
+      break;
+    default:
+      printf(" a=%u b=%u value=%d", event->a, event->b, event->value);
+  }
+  printf("\n");
+}
+
+static int decode(FILE *file, const char *path) {
+  EventDumpHeader_t header;
+  if (fread(&header, sizeof(header), 1, file) != 1 ||
+      memcmp(header.magic, EVENT_DUMP_MAGIC, sizeof(header.magic)) != 0) {
+    fprintf(stderr, "%s: not an event dump\n", path);
+    return 1;
+  }
+  if (header.version != EVENT_DUMP_VERSION ||
+      header.event_size != sizeof(GameEvent_t) ||
+      header.capacity != EVENT_RING_SIZE) {
+    fprintf(stderr, "%s: unsupported dump version %u\n", path, header.version);
+    return 1;
+  }
+
+  static GameEvent_t events[EVENT_RING_SIZE];
+  if (fread(events, sizeof(events), 1, file) != 1) {
+    fprintf(stderr, "%s: truncated dump\n", path);
+    return 1;
+  }
+
+  unsigned first = header.head > EVENT_RING_SIZE ? header.head - EVENT_RING_SIZE
+                                                 : 0;
+  unsigned torn = 0;
+  printf("%s: %u events recorded, %u kept\n", path, header.head,
+         header.head - first);
+  printf("%8s  %s\n", "tick", "event");
+  for (unsigned i = first; i != header.head; i++) {
+    const GameEvent_t *event = &events[i & (EVENT_RING_SIZE - 1)];
+    if (event->sequence != i + 1)
+      torn++;
+    else
+      printEvent(event);
+  }
+  if (torn) printf("%u events were being written during the dump\n", torn);
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <game>_events.bin...\n", argv[0]);
+    return 2;
+  }
+
+  int status = 0;
+  for (int i = 1; i < argc; i++) {
+    FILE *file = fopen(argv[i], "rb");
+    if (!file) {
+      perror(argv[i]);
+      status = 1;
+      continue;
+    }
+    status |= decode(file, argv[i]);
+    fclose(file);
+  }
+  return status;
+}
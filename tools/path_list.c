@@ -0,0 +1,82 @@
+#define _DEFAULT_SOURCE
+
+#include "path_list.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+bool addPath(PathList_t *list, const char *path) {
+  if (list->count == list->capacity) {
+    size_t capacity = list->capacity ? list->capacity * 2 : 64;
+    char **grown = realloc(list->paths, capacity * sizeof(*grown));
+    if (!grown) return false;
+    list->paths = grown;
+    list->capacity = capacity;
+  }
+  char *copy = strdup(path);
+  if (!copy) return false;
+  list->paths[list->count++] = copy;
+  return true;
+}
+
+static int comparePaths(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static bool addDirectory(PathList_t *list, const char *path) {
+  DIR *dir = opendir(path);
+  if (!dir) return false;
+  size_t first = list->count;
+  bool ok = true;
+  struct dirent *entry;
+  char full[4096];
+  while (ok && (entry = readdir(dir)) != NULL) {
+    if (entry->d_type != DT_REG && entry->d_type != DT_UNKNOWN) continue;
+    if (entry->d_name[0] == '.') continue;
+    snprintf(full, sizeof(full), "%s/%s", path, entry->d_name);
+    ok = addPath(list, full);
+  }
+  closedir(dir);
+  qsort(list->paths + first, list->count - first, sizeof(*list->paths),
+        comparePaths);
+  return ok;
+}
+
+static bool addStdin(PathList_t *list) {
+  char line[4096];
+  while (fgets(line, sizeof(line), stdin)) {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (*line && !addPath(list, line)) return false;
+  }
+  return true;
+}
+
+bool addArgument(PathList_t *list, const char *argument) {
+  if (strcmp(argument, "-") == 0) return addStdin(list);
+  DIR *dir = opendir(argument);
+  if (dir) {
+    closedir(dir);
+    return addDirectory(list, argument);
+  }
+  return addPath(list, argument);
+}
+
+void freePaths(PathList_t *list) {
+  for (size_t i = 0; i < list->count; i++) free(list->paths[i]);
+  free(list->paths);
+  memset(list, 0, sizeof(*list));
+}
+
+int parseThreads(const char *value) {
+  char *end = NULL;
+  long parsed = strtol(value, &end, 10);
+  return (*end == '\0' && parsed > 0 && parsed <= 1024) ? (int)parsed : 0;
+}
+
+int defaultThreads(void) {
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return cores > 0 ? (int)cores : 1;
+}
@@ -0,0 +1,26 @@
+#ifndef SRC_TOOLS_PATH_LIST_H_
+#define SRC_TOOLS_PATH_LIST_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// The file arguments the replay tools share: files, directories of them, or
+// "-" for a queue of paths on stdin, one per line.
+typedef struct {
+  char **paths;
+  size_t count;
+  size_t capacity;
+} PathList_t;
+
+bool addPath(PathList_t *list, const char *path);
+// A directory adds its regular files, sorted, so reports do not depend on the
+// order the file system lists them in.
+bool addArgument(PathList_t *list, const char *argument);
+void freePaths(PathList_t *list);
+
+// -j values: 1 to 1024, 0 for anything else.
+int parseThreads(const char *value);
+// One per online core.
+int defaultThreads(void);
+
+#endif  // SRC_TOOLS_PATH_LIST_H_
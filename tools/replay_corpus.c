@@ -0,0 +1,157 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./../brick_game/common/clock.h"
+#include "./../brick_game/common/corpus.h"
+#include "path_list.h"
+
+// Packs replays of the game it is linked against into a columnar corpus, and
+// aggregates corpora on -j threads:
+//
+//   replay_corpus_tetris pack out.corpus <replay|directory|->...
+//   replay_corpus_tetris scan [-j threads] <corpus>...
+//
+// A scan reads only the session summaries and the codes column of a mapped
+// file, so it runs at the speed the pages come in, not the speed of a game.
+
+static const char *const ACTION_NAMES[CORPUS_ACTIONS] = {
+    "start", "pause", "terminate", "left", "right", "up", "down", "action"};
+static const char PIECE_NAMES[CORPUS_PIECE_TYPES] = {'I', 'L', 'J', 'O',
+                                                     'Z', 'T', 'S'};
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s pack <corpus> <replay|directory|->...\n"
+          "       %s scan [-j threads] <corpus>...\n",
+          program, program);
+}
+
+static int pack(const char *program, const char *out, int argc, char **argv) {
+  PathList_t paths = {0};
+  for (int i = 0; i < argc; i++) {
+    if (!addArgument(&paths, argv[i])) {
+      fprintf(stderr, "%s: cannot read %s\n", program, argv[i]);
+      freePaths(&paths);
+      return 2;
+    }
+  }
+  const EngineOps_t *ops = getEngineOps();
+  CorpusWriter_t writer;
+  if (paths.count == 0 || !startCorpus(&writer, out, ops->name)) {
+    fprintf(stderr, "%s: cannot write %s\n", program, out);
+    freePaths(&paths);
+    return 2;
+  }
+
+  int status = 0;
+  unsigned long long start = monotonicNanos();
+  for (size_t i = 0; i < paths.count; i++) {
+    if (!addReplayToCorpus(&writer, paths.paths[i], ops)) {
+      fprintf(stderr, "%s: skipped %s\n", program, paths.paths[i]);
+      status = 1;
+    }
+  }
+  if (!finishCorpus(&writer)) {
+    fprintf(stderr, "%s: cannot write %s\n", program, out);
+    status = 2;
+  }
+  double seconds = (double)(monotonicNanos() - start) / 1e9;
+  printf("%llu sessions, %llu entries, %llu bytes in %.3f s\n",
+         (unsigned long long)writer.header.sessions,
+         (unsigned long long)writer.header.entries,
+         (unsigned long long)writer.header.size, seconds);
+  freePaths(&paths);
+  return status;
+}
+
+static void printHistogram(const char *title, const uint64_t *counts,
+                           int buckets, int step) {
+  printf("%s:", title);
+  for (int i = 0; i < buckets; i++) {
+    if (counts[i]) printf(" %d:%llu", i * step, (unsigned long long)counts[i]);
+  }
+  printf("\n");
+}
+
+static void printStats(const CorpusStats_t *stats) {
+  printf("%llu sessions (%llu verified), %llu entries, %llu inputs, %.1f s of "
+         "game time\n",
+         (unsigned long long)stats->sessions,
+         (unsigned long long)stats->verified,
+         (unsigned long long)stats->entries,
+         (unsigned long long)stats->inputs, (double)stats->millis / 1000.0);
+  if (stats->millis)
+    printf("%.1f actions per minute overall\n",
+           (double)stats->inputs * 60000.0 / (double)stats->millis);
+
+  printf("actions:");
+  for (int i = 0; i < CORPUS_ACTIONS; i++)
+    printf(" %s=%llu", ACTION_NAMES[i], (unsigned long long)stats->actions[i]);
+  printf("\npieces:");
+  uint64_t pieces = 0;
+  for (int i = 0; i < CORPUS_PIECE_TYPES; i++) pieces += stats->pieces[i];
+  for (int i = 0; i < CORPUS_PIECE_TYPES; i++) {
+    printf(" %c=%llu (%.1f%%)", PIECE_NAMES[i],
+           (unsigned long long)stats->pieces[i],
+           pieces ? 100.0 * (double)stats->pieces[i] / (double)pieces : 0.0);
+  }
+  printf("\nscores (from 2^(n-1)):");
+  for (int i = 0; i < CORPUS_SCORE_BUCKETS; i++) {
+    if (stats->scores[i])
+      printf(" %d:%llu", i ? 1 << (i - 1) : 0,
+             (unsigned long long)stats->scores[i]);
+  }
+  printf("\n");
+  printHistogram("levels", stats->levels, CORPUS_LEVELS, 1);
+  printHistogram("apm (from)", stats->apm, CORPUS_APM_BUCKETS,
+                 CORPUS_APM_STEP);
+}
+
+static int scan(const char *program, int argc, char **argv) {
+  int threads = defaultThreads();
+  CorpusStats_t total;
+  memset(&total, 0, sizeof(total));
+  unsigned long long nanos = 0;
+  int corpora = 0;
+
+  for (int i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      threads = parseThreads(argv[++i]);
+      if (!threads) return 2;
+      continue;
+    }
+    Corpus_t corpus;
+    if (!openCorpus(&corpus, argv[i])) {
+      fprintf(stderr, "%s: not a corpus: %s\n", program, argv[i]);
+      return 2;
+    }
+    CorpusStats_t stats;
+    unsigned long long start = monotonicNanos();
+    scanCorpus(&corpus, threads, &stats);
+    nanos += monotonicNanos() - start;
+    mergeCorpusStats(&total, &stats);
+    closeCorpus(&corpus);
+    corpora++;
+  }
+  if (corpora == 0) return 2;
+
+  printStats(&total);
+  double seconds = (double)nanos / 1e9;
+  if (seconds <= 0) seconds = 1e-9;
+  printf("\n%.3f s on %d thread%s: %.2f GB/s, %.0f sessions/s\n", seconds,
+         threads, threads == 1 ? "" : "s", (double)total.bytes / seconds / 1e9,
+         (double)total.sessions / seconds);
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  int status = 2;
+  if (argc >= 4 && strcmp(argv[1], "pack") == 0) {
+    status = pack(argv[0], argv[2], argc - 3, argv + 3);
+  } else if (argc >= 3 && strcmp(argv[1], "scan") == 0) {
+    status = scan(argv[0], argc - 2, argv + 2);
+  }
+  if (status == 2) usage(argv[0]);
+  return status;
+}
@@ -0,0 +1,260 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <unistd.h>
+
+#include "./../brick_game/common/clock.h"
+#include "./../brick_game/common/perf_counters.h"
+#include "./../brick_game/common/replay.h"
+#include "./../gui/common/frame_image.h"
+#include "path_list.h"
+
+// Renders a replay of the game it is linked against into images on stdout,
+// -r frames per second of game time, for a video encoder:
+//
+//   replay_render_tetris [-j threads] [-r fps] [-s block] [-f ppm|rgba]
+//                        <replay>
+//   replay_render_tetris game.bin |
+//       ffmpeg -f image2pipe -c:v ppm -r 30 -i - game.mp4
+//
+// ppm is a stream of binary PPM images; rgba is raw frames of the size
+// printed on stderr. The replay's keyframes cut it into segments, which -j
+// threads play on the virtual clock, each from its own keyframe, into a
+// temporary file; the files are written out in the order of the segments.
+// Threads stay at most two segments each ahead of the output.
+
+#define RENDER_AHEAD 2
+
+typedef struct {
+  unsigned long long first;  // index of the first frame
+  unsigned long long end;    // one past the last, 0 for up to the end
+  FILE *file;
+  unsigned long long frames;
+  bool done;
+  bool ok;
+} Segment_t;
+
+typedef struct {
+  const char *path;
+  int fps;
+  int block;
+  int channels;
+  Segment_t *segments;
+  size_t count;
+  size_t next;     // segment to claim
+  size_t written;  // segments already on stdout
+  int threads;
+  mtx_t lock;
+  cnd_t changed;
+} Job_t;
+
+static unsigned long long frameMillis(const Job_t *job,
+                                      unsigned long long frame) {
+  return frame * 1000 / (unsigned long long)job->fps;
+}
+
+// The first frame shown at or after millis.
+static unsigned long long firstFrameAt(const Job_t *job,
+                                       unsigned long long millis) {
+  return (millis * (unsigned long long)job->fps + 999) / 1000;
+}
+
+static bool writeImage(const Job_t *job, const uint8_t *pixels, FILE *file) {
+  int width, height;
+  frameImageSize(job->block, &width, &height);
+  if (job->channels == 3 &&
+      fprintf(file, "P6\n%d %d\n255\n", width, height) < 0)
+    return false;
+  size_t size = (size_t)width * height * job->channels;
+  return fwrite(pixels, 1, size, file) == size;
+}
+
+static bool renderSegment(Job_t *job, ReplayPlayer_t *player,
+                          Segment_t *segment, uint8_t *pixels) {
+  segment->file = tmpfile();
+  if (!segment->file) return false;
+  seekReplay(player, frameMillis(job, segment->first));
+  for (unsigned long long frame = segment->first;
+       segment->end == 0 || frame < segment->end; frame++) {
+    unsigned long long millis = frameMillis(job, frame);
+    if (millis > replayElapsed(player))
+      advanceReplay(player, millis - replayElapsed(player));
+    Frame_t state;
+    fillReplayFrame(player, &state);
+    rasterizeFrame(&state, job->block, job->channels, pixels);
+    if (!writeImage(job, pixels, segment->file)) return false;
+    segment->frames++;
+    if (player->finished) break;
+  }
+  return fflush(segment->file) == 0;
+}
+
+static int renderWorker(void *arg) {
+  Job_t *job = arg;
+  int width, height;
+  frameImageSize(job->block, &width, &height);
+  uint8_t *pixels = malloc((size_t)width * height * job->channels);
+  ReplayPlayer_t player;
+  bool open = pixels && openReplay(&player, job->path, getEngineOps());
+
+  for (;;) {
+    mtx_lock(&job->lock);
+    while (job->next < job->count &&
+           job->next >= job->written + (size_t)job->threads * RENDER_AHEAD)
+      cnd_wait(&job->changed, &job->lock);
+    size_t index = job->next < job->count ? job->next++ : job->count;
+    mtx_unlock(&job->lock);
+    if (index == job->count) break;
+
+    Segment_t *segment = &job->segments[index];
+    bool ok = open && renderSegment(job, &player, segment, pixels);
+    mtx_lock(&job->lock);
+    segment->ok = ok;
+    segment->done = true;
+    cnd_broadcast(&job->changed);
+    mtx_unlock(&job->lock);
+  }
+
+  if (open) closeReplay(&player);
+  free(pixels);
+  releasePerfCounters();
+  return 0;
+}
+
+static bool copySegment(Segment_t *segment) {
+  char buffer[1 << 16];
+  size_t count;
+  bool ok = segment->ok && fseek(segment->file, 0, SEEK_SET) == 0;
+  while (ok && (count = fread(buffer, 1, sizeof(buffer), segment->file)) > 0)
+    ok = fwrite(buffer, 1, count, stdout) == count;
+  return ok && !ferror(segment->file);
+}
+
+// One segment from the start and one from each keyframe that moves the
+// picture on by at least a frame.
+static Segment_t *cutSegments(Job_t *job, const ReplayPlayer_t *player) {
+  Segment_t *segments = calloc(player->keyframe_count + 1, sizeof(*segments));
+  if (!segments) return NULL;
+  job->count = 1;
+  for (size_t i = 0; i < player->keyframe_count; i++) {
+    unsigned long long first = firstFrameAt(
+        job, player->keyframes[i].millis - player->header.start_millis);
+    if (first <= segments[job->count - 1].first) continue;
+    segments[job->count - 1].end = first;
+    segments[job->count++].first = first;
+  }
+  return segments;
+}
+
+static int render(Job_t *job) {
+  ReplayPlayer_t player;
+  if (!openReplay(&player, job->path, getEngineOps())) {
+    fprintf(stderr, "not a replay of this game: %s\n", job->path);
+    return 2;
+  }
+  job->segments = cutSegments(job, &player);
+  closeReplay(&player);
+  if (!job->segments) return 2;
+
+  unsigned long long start = monotonicNanos();
+  if ((size_t)job->threads > job->count) job->threads = (int)job->count;
+  mtx_init(&job->lock, mtx_plain);
+  cnd_init(&job->changed);
+  thrd_t *threads = calloc((size_t)job->threads, sizeof(*threads));
+  int started = 0;
+  while (threads && started < job->threads &&
+         thrd_create(&threads[started], renderWorker, job) == thrd_success)
+    started++;
+
+  bool ok = started > 0;
+  unsigned long long frames = 0;
+  for (size_t i = 0; ok && i < job->count; i++) {
+    Segment_t *segment = &job->segments[i];
+    mtx_lock(&job->lock);
+    while (!segment->done) cnd_wait(&job->changed, &job->lock);
+    mtx_unlock(&job->lock);
+    ok = copySegment(segment);
+    frames += segment->frames;
+    fclose(segment->file);
+    segment->file = NULL;
+    mtx_lock(&job->lock);
+    job->written = i + 1;
+    cnd_broadcast(&job->changed);
+    mtx_unlock(&job->lock);
+  }
+  // On a failure the workers run out of segments to claim.
+  mtx_lock(&job->lock);
+  job->next = job->count;
+  cnd_broadcast(&job->changed);
+  mtx_unlock(&job->lock);
+  for (int i = 0; i < started; i++) thrd_join(threads[i], NULL);
+  for (size_t i = 0; i < job->count; i++) {
+    if (job->segments[i].file) fclose(job->segments[i].file);
+  }
+  ok = fflush(stdout) == 0 && ok;
+
+  int width, height;
+  frameImageSize(job->block, &width, &height);
+  double seconds = (double)(monotonicNanos() - start) / 1e9;
+  if (seconds <= 0) seconds = 1e-9;
+  fprintf(stderr,
+          "%llu frames of %dx%d %s at %d fps, %zu segments on %d thread%s: "
+          "%.3f s, %.0f frames/s\n",
+          frames, width, height, job->channels == 3 ? "ppm" : "rgba",
+          job->fps, job->count, started, started == 1 ? "" : "s", seconds,
+          (double)frames / seconds);
+  free(threads);
+  free(job->segments);
+  cnd_destroy(&job->changed);
+  mtx_destroy(&job->lock);
+  return ok ? 0 : 1;
+}
+
+static void usage(const char *program) {
+  fprintf(stderr,
+          "usage: %s [-j threads] [-r fps] [-s block] [-f ppm|rgba] <replay>\n",
+          program);
+}
+
+int main(int argc, char **argv) {
+  Job_t job;
+  memset(&job, 0, sizeof(job));
+  job.fps = 30;
+  job.block = 20;
+  job.channels = 3;
+  job.threads = defaultThreads();
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 < argc && strcmp(argv[i], "-j") == 0) {
+      job.threads = parseThreads(argv[++i]);
+      if (!job.threads) return 2;
+    } else if (i + 1 < argc && strcmp(argv[i], "-r") == 0) {
+      job.fps = atoi(argv[++i]);
+    } else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+      job.block = atoi(argv[++i]);
+    } else if (i + 1 < argc && strcmp(argv[i], "-f") == 0) {
+      i++;
+      job.channels = strcmp(argv[i], "rgba") == 0  ? 4
+                     : strcmp(argv[i], "ppm") == 0 ? 3
+                                                   : 0;
+    } else if (!job.path && argv[i][0] != '-') {
+      job.path = argv[i];
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (!job.path || job.fps < 1 || job.fps > 1000 || job.block < 1 ||
+      job.block > 256 || job.channels == 0) {
+    usage(argv[0]);
+    return 2;
+  }
+  if (isatty(STDOUT_FILENO)) {
+    fprintf(stderr, "%s: images go to stdout; pipe them somewhere\n",
+            argv[0]);
+    return 2;
+  }
+  return render(&job);
+}
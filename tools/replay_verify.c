@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+
+#include "./../brick_game/common/clock.h"
+#include "./../brick_game/common/perf_counters.h"
+#include "./../brick_game/common/replay.h"
+#include "path_list.h"
+
+// Re-simulates replays of the game it is linked against and checks that each
+// one reaches the score, level and line count its footer claims. Arguments are
+// replay files, directories of them, or "-" for a queue of paths on stdin,
+// one per line. The replays are spread over -j threads (one per core by
+// default), each playing its games back to back on the virtual clock, so a
+// session takes a fraction of the time it was played for.
+//
+// Verdicts come out in the order of the input, followed by the totals. The
+// exit status is 1 when any replay fails to verify.
+
+typedef struct {
+  const PathList_t *paths;
+  ReplayCheck_t *checks;
+  size_t next;  // taken with __atomic_fetch_add
+} Queue_t;
+
+static int verifyWorker(void *arg) {
+  Queue_t *queue = arg;
+  const EngineOps_t *ops = getEngineOps();
+  for (;;) {
+    size_t index = __atomic_fetch_add(&queue->next, 1, __ATOMIC_RELAXED);
+    if (index >= queue->paths->count) break;
+    verifyReplay(queue->paths->paths[index], ops, &queue->checks[index]);
+  }
+  releasePerfCounters();
+  return 0;
+}
+
+static void printCheck(const char *path, const ReplayCheck_t *check) {
+  const ReplayClaim_t *claim = &check->claim;
+  switch (check->verdict) {
+    case REPLAY_VERIFIED:
+      printf("OK        %s score=%d level=%d lines=%d", path, check->score,
+             check->level, check->lines);
+      break;
+    case REPLAY_MISMATCH:
+      printf("MISMATCH  %s score=%d/%d level=%d/%d lines=%d/%d", path,
+             check->score, claim->score, check->level, claim->level,
+             check->lines, claim->lines);
+      if (check->missed_ticks)
+        printf(" missed_ticks=%llu", check->missed_ticks);
+      break;
+    case REPLAY_UNCLAIMED:
+      printf("UNCLAIMED %s", path);
+      break;
+    case REPLAY_INVALID:
+      printf("INVALID   %s\n", path);
+      return;
+  }
+  printf(" entries=%llu game=%.1fs\n", check->entries,
+         (double)check->millis / 1000.0);
+}
+
+static void printTotals(const PathList_t *paths, const ReplayCheck_t *checks,
+                        int threads, unsigned long long nanos) {
+  size_t verdicts[REPLAY_INVALID + 1] = {0};
+  unsigned long long entries = 0, millis = 0;
+  for (size_t i = 0; i < paths->count; i++) {
+    verdicts[checks[i].verdict]++;
+    entries += checks[i].entries;
+    millis += checks[i].millis;
+  }
+  double seconds = (double)nanos / 1e9;
+  if (seconds <= 0) seconds = 1e-9;
+  printf(
+      "\n%zu replays: %zu ok, %zu mismatch, %zu unclaimed, %zu invalid\n"
+      "%.3f s on %d thread%s: %.1f replays/s, %.0f entries/s\n"
+      "%.1f s of game time, %.0fx real time\n",
+      paths->count, verdicts[REPLAY_VERIFIED], verdicts[REPLAY_MISMATCH],
+      verdicts[REPLAY_UNCLAIMED], verdicts[REPLAY_INVALID], seconds, threads,
+      threads == 1 ? "" : "s",
+      (double)paths->count / seconds, (double)entries / seconds,
+      (double)millis / 1000.0, (double)millis / 1000.0 / seconds);
+}
+
+static void usage(const char *program) {
+  fprintf(stderr, "usage: %s [-j threads] <replay|directory|->...\n",
+          program);
+}
+
+// Returns the exit status: 0 when every replay verifies or claims nothing,
+// 1 when any fails, 2 when the checks could not run at all.
+static int verifyAll(const PathList_t *paths, int threads) {
+  if ((size_t)threads > paths->count) threads = (int)paths->count;
+  ReplayCheck_t *checks = calloc(paths->count, sizeof(*checks));
+  thrd_t *workers = calloc((size_t)threads, sizeof(*workers));
+  if (!checks || !workers) {
+    free(checks);
+    free(workers);
+    return 2;
+  }
+
+  Queue_t queue = {paths, checks, 0};
+  unsigned long long start = monotonicNanos();
+  int started = 0;
+  while (started < threads &&
+         thrd_create(&workers[started], verifyWorker, &queue) == thrd_success)
+    started++;
+  // Without a single worker the main thread does the work itself.
+  if (started == 0) verifyWorker(&queue);
+  for (int i = 0; i < started; i++) thrd_join(workers[i], NULL);
+  unsigned long long nanos = monotonicNanos() - start;
+
+  int status = 0;
+  for (size_t i = 0; i < paths->count; i++) {
+    printCheck(paths->paths[i], &checks[i]);
+    if (checks[i].verdict == REPLAY_MISMATCH ||
+        checks[i].verdict == REPLAY_INVALID)
+      status = 1;
+  }
+  printTotals(paths, checks, started ? started : 1, nanos);
+  free(workers);
+  free(checks);
+  return status;
+}
+
+int main(int argc, char **argv) {
+  int threads = defaultThreads();
+  PathList_t paths = {0};
+  int status = 0;
+
+  for (int i = 1; i < argc && status == 0; i++) {
+    if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      threads = parseThreads(argv[++i]);
+      if (!threads) status = 2;
+    } else if (!addArgument(&paths, argv[i])) {
+      fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[i]);
+      status = 2;
+    }
+  }
+  if (status == 0 && paths.count == 0) status = 2;
+  if (status == 0) {
+    status = verifyAll(&paths, threads);
+  } else {
+    usage(argv[0]);
+  }
+
+  freePaths(&paths);
+  return status;
+}
@@ -0,0 +1,210 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <threads.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "./../brick_game/common/clock.h"
+#include "./../brick_game/common/perf_counters.h"
+#include "./../brick_game/common/rng.h"
+#include "./../brick_game/common/rollback.h"
+
+// A versus match between two bots, each on its own thread as its own peer,
+// over a local datagram link. Every packet is held back -l frames before it
+// is sent, standing in for the network, so each peer keeps predicting the
+// other and rolling back when it guessed wrong. At the end both peers must
+// show the same two boards. Frames run flat out unless -r paces them at
+// ROLLBACK_TICK_MILLIS.
+//
+//   versus_snake [-t ticks] [-l latency_frames] [-s seed] [-r]
+
+#define VERSUS_DELAY_MAX 64  // frames a packet can be held back
+
+typedef struct {
+  int fd;
+  int local;
+  uint32_t ticks;
+  int latency;
+  bool realtime;
+  unsigned long long seed;
+  RollbackSession_t session;
+  RollbackPacket_t delayed[VERSUS_DELAY_MAX];
+  Frame_t boards[ROLLBACK_PLAYERS];
+  RollbackStats_t stats;
+  unsigned long long worst_frame_nanos;
+  bool started;
+} Peer_t;
+
+// A player pressing a direction about every tenth tick.
+static RollbackInput_t botInput(Rng_t *rng, uint32_t tick) {
+  static const UserAction_t moves[] = {Left, Right, Up, Down};
+  RollbackInput_t input = {-1, 0};
+  if (tick == 0) {
+    input.action = Start;
+  } else if (randomBelow(rng, 10) == 0) {
+    input.action = (int8_t)moves[randomBelow(rng, 4)];
+  }
+  return input;
+}
+
+static void sleepUntil(unsigned long long deadline) {
+  unsigned long long now = monotonicNanos();
+  if (now >= deadline) return;
+  struct timespec pause = {(time_t)((deadline - now) / 1000000000ULL),
+                           (long)((deadline - now) % 1000000000ULL)};
+  thrd_sleep(&pause, NULL);
+}
+
+static bool settled(const Peer_t *peer) {
+  const RollbackSession_t *session = &peer->session;
+  return session->tick >= peer->ticks && session->confirmed >= peer->ticks &&
+         session->acked >= peer->ticks;
+}
+
+static int runPeer(void *arg) {
+  Peer_t *peer = arg;
+  RollbackSession_t *session = &peer->session;
+  peer->started = startRollbackSession(session, getEngineOps(), peer->local,
+                                       peer->seed, 1000);
+  if (!peer->started) return 1;
+  Rng_t rng;
+  seedRng(&rng, peer->seed * 2 + (unsigned)peer->local);
+  RollbackInput_t next = botInput(&rng, 0);
+
+  // Once settled, the peer keeps going until its last acknowledgement is out
+  // of the delay line.
+  unsigned long long start = monotonicNanos();
+  int linger = 0;
+  for (unsigned long long frame = 0; linger <= peer->latency + 1; frame++) {
+    unsigned long long frame_start = monotonicNanos();
+    if (session->tick < peer->ticks) {
+      if (advanceRollback(session, next))
+        next = botInput(&rng, session->tick);
+      else if (!peer->realtime)
+        thrd_yield();
+    }
+
+    // The packet filled now goes out latency frames later.
+    fillRollbackPacket(session, &peer->delayed[frame % VERSUS_DELAY_MAX]);
+    if (frame >= (unsigned long long)peer->latency) {
+      const RollbackPacket_t *packet =
+          &peer->delayed[(frame - peer->latency) % VERSUS_DELAY_MAX];
+      send(peer->fd, packet,
+           offsetof(RollbackPacket_t, inputs) +
+               packet->count * sizeof(packet->inputs[0]),
+           0);
+    }
+    receiveRollbackInputs(session, peer->fd);
+
+    unsigned long long spent = monotonicNanos() - frame_start;
+    if (spent > peer->worst_frame_nanos) peer->worst_frame_nanos = spent;
+    if (peer->realtime)
+      sleepUntil(start + (frame + 1) * ROLLBACK_TICK_MILLIS * 1000000ULL);
+    if (settled(peer)) linger++;
+  }
+
+  for (int player = 0; player < ROLLBACK_PLAYERS; player++)
+    fillRollbackFrame(session, player, &peer->boards[player]);
+  peer->stats = session->stats;
+  stopRollbackSession(session);
+  releasePerfCounters();
+  return 0;
+}
+
+static bool sameBoard(const Frame_t *a, const Frame_t *b) {
+  return memcmp(a->field, b->field, sizeof(a->field)) == 0 &&
+         a->score == b->score && a->level == b->level && a->pause == b->pause;
+}
+
+static void printPeer(const Peer_t *peer) {
+  const RollbackStats_t *stats = &peer->stats;
+  printf("peer %d: %llu rollbacks, %llu ticks re-simulated (deepest %u), "
+         "%llu stalls, %.2f us per rollback, worst frame %.1f us\n",
+         peer->local, (unsigned long long)stats->rollbacks,
+         (unsigned long long)stats->resimulated, stats->deepest,
+         (unsigned long long)stats->stalls,
+         stats->rollbacks ? (double)stats->rollback_nanos / 1e3 /
+                                (double)stats->rollbacks
+                          : 0.0,
+         (double)peer->worst_frame_nanos / 1e3);
+}
+
+static void usage(const char *program) {
+  fprintf(stderr, "usage: %s [-t ticks] [-l latency_frames] [-s seed] [-r]\n",
+          program);
+}
+
+int main(int argc, char **argv) {
+  uint32_t ticks = 3600;
+  int latency = 6;
+  unsigned long long seed = 1;
+  bool realtime = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-r") == 0) {
+      realtime = true;
+    } else if (i + 1 < argc && strcmp(argv[i], "-t") == 0) {
+      ticks = (uint32_t)strtoul(argv[++i], NULL, 10);
+    } else if (i + 1 < argc && strcmp(argv[i], "-l") == 0) {
+      latency = atoi(argv[++i]);
+    } else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+      seed = strtoull(argv[++i], NULL, 10);
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+  }
+  if (ticks == 0 || latency < 0 || latency >= VERSUS_DELAY_MAX) {
+    usage(argv[0]);
+    return 2;
+  }
+
+  int fds[2];
+  Peer_t *peers = calloc(ROLLBACK_PLAYERS, sizeof(*peers));
+  if (!peers || !openRollbackLink(fds)) {
+    fprintf(stderr, "%s: cannot open the link\n", argv[0]);
+    free(peers);
+    return 2;
+  }
+  thrd_t threads[ROLLBACK_PLAYERS];
+  int started = 0;
+  for (int i = 0; i < ROLLBACK_PLAYERS; i++) {
+    peers[i].fd = fds[i];
+    peers[i].local = i;
+    peers[i].ticks = ticks;
+    peers[i].latency = latency;
+    peers[i].realtime = realtime;
+    peers[i].seed = seed;
+    if (thrd_create(&threads[i], runPeer, &peers[i]) == thrd_success)
+      started++;
+  }
+  for (int i = 0; i < started; i++) thrd_join(threads[i], NULL);
+  close(fds[0]);
+  close(fds[1]);
+
+  int status = 0;
+  if (started < ROLLBACK_PLAYERS || !peers[0].started || !peers[1].started) {
+    fprintf(stderr, "%s: a peer failed to start\n", argv[0]);
+    status = 2;
+  } else {
+    printf("%u ticks, %d frames of latency\n", ticks, latency);
+    for (int i = 0; i < ROLLBACK_PLAYERS; i++) printPeer(&peers[i]);
+    bool agree = true;
+    for (int player = 0; player < ROLLBACK_PLAYERS; player++)
+      agree = agree &&
+              sameBoard(&peers[0].boards[player], &peers[1].boards[player]);
+    int scores[ROLLBACK_PLAYERS] = {peers[0].boards[0].score,
+                                    peers[0].boards[1].score};
+    printf("boards agree: %s\nscores %d:%d, %s\n", agree ? "yes" : "NO",
+           scores[0], scores[1],
+           scores[0] == scores[1]  ? "a draw"
+           : scores[0] > scores[1] ? "player 1 wins"
+                                   : "player 2 wins");
+    status = agree ? 0 : 1;
+  }
+  free(peers);
+  return status;
+}